@@ -0,0 +1,44 @@
+// Copyright 2024 Hiram Silvey
+
+// Writes the profiles in ../profiles to a file, encoded exactly as the
+// configurator stores them in EEPROM, so the firmware benchmarks run against
+// the same bytes a controller would be flashed with.
+//
+// Usage: export <output file>
+
+use anyhow::{anyhow, Result};
+use configurator::encoder;
+use configurator::profiles;
+use std::env;
+use std::fs;
+use std::path::Path;
+
+const MAX_EEPROM_BYTES: usize = 1064;
+
+fn main() -> Result<()> {
+    let args: Vec<String> = env::args().collect();
+    let out_path = match args.get(1) {
+        Some(x) => x,
+        None => return Err(anyhow!("Usage: export <output file>")),
+    };
+
+    let profiles = match profiles::load_all(&Path::new("../profiles")) {
+        Ok(x) => x,
+        Err(e) => return Err(anyhow!("Unable to load profiles: {}", e)),
+    };
+    let encoded = match encoder::encode(&profiles) {
+        Ok(x) => x,
+        Err(e) => return Err(anyhow!("Unable to encode profiles: {}", e)),
+    };
+    if encoded.len() > MAX_EEPROM_BYTES {
+        return Err(anyhow!(
+            "Encoded length of {} bytes exceeds HS maximum of {} bytes.",
+            encoded.len(),
+            MAX_EEPROM_BYTES,
+        ));
+    }
+
+    fs::write(out_path, &encoded)?;
+    println!("Wrote {} profiles to {}.", profiles.len(), out_path);
+    Ok(())
+}
@@ -0,0 +1,205 @@
+// Copyright 2024 Hiram Silvey
+
+// Command line client for the commands HS serves over serial while the
+// controller is running, as opposed to the setup mode driven by the
+// configurator GUI.
+//
+// Usage:
+//   live push <profile name> [--persist]
+//   live histograms
+//   live latency
+
+use anyhow::{anyhow, Result};
+use configurator::encoder;
+use configurator::profiles;
+use serialport::SerialPort;
+use std::env;
+use std::path::Path;
+use std::time::{Duration, Instant};
+
+#[derive(Clone, Copy)]
+enum LiveCommand {
+    PushProfile = 0,
+    SendCycleHistograms = 1,
+    SendLatencyStats = 2,
+}
+
+// Set in the push flags byte to also store the pushed layout in EEPROM.
+const PUSH_PERSIST_FLAG: u8 = 1;
+
+// Timed sections of a tick, in the order the firmware's profiler sends them.
+const PROFILER_STAGES: [&str; 4] = ["tick", "sensor", "buttons", "send"];
+const PROFILER_BUCKETS: usize = 32;
+
+// Button pins, in pin order as the firmware's latency tracer sends them.
+const PINS: [&str; 16] = [
+    "thumb top",
+    "thumb middle",
+    "thumb bottom",
+    "index top",
+    "index middle",
+    "middle top",
+    "middle middle",
+    "middle bottom",
+    "ring top",
+    "ring middle",
+    "ring bottom",
+    "pinky top",
+    "pinky middle",
+    "pinky bottom",
+    "left outer",
+    "left inner",
+];
+
+const USAGE: &str = "Usage: live push <profile name> [--persist] | live histograms | live latency";
+
+fn connect() -> Result<Box<dyn SerialPort>> {
+    let port = "/dev/ttyACM0";
+    match serialport::new(port, 9600)
+        .timeout(Duration::from_millis(10))
+        .open()
+    {
+        Ok(x) => Ok(x),
+        Err(e) => Err(anyhow!(
+            "Unable to connect to HS via serial port {}: {}",
+            port,
+            e
+        )),
+    }
+}
+
+fn wait_for_data(hs: &mut Box<dyn SerialPort>, buf: &mut Vec<u8>) -> Result<()> {
+    let now = Instant::now();
+    let timeout = Duration::new(1, 0);
+    let mut status = hs.read_exact(buf);
+    while status.is_err() && now.elapsed() < timeout {
+        status = hs.read_exact(buf);
+    }
+    if status.is_err() {
+        return Err(anyhow!(
+            "Failed waiting for data from HS: {}",
+            status.unwrap_err()
+        ));
+    }
+    Ok(())
+}
+
+// HS replies 0 once it accepts a command or completes it, and 1 otherwise.
+fn wait_for_ack(hs: &mut Box<dyn SerialPort>) -> Result<()> {
+    let mut buf = vec![0u8; 1];
+    wait_for_data(hs, &mut buf)?;
+    if buf[0] != 0 {
+        return Err(anyhow!("Failed to receive ACK. Wanted 0, got {}.", buf[0]));
+    }
+    Ok(())
+}
+
+// Reads big-endian 4-byte unsigned integers, as HS writes them.
+fn read_ints(hs: &mut Box<dyn SerialPort>, count: usize) -> Result<Vec<u32>> {
+    let mut buf = vec![0u8; count * 4];
+    wait_for_data(hs, &mut buf)?;
+    Ok(buf
+        .chunks(4)
+        .map(|x| u32::from_be_bytes([x[0], x[1], x[2], x[3]]))
+        .collect())
+}
+
+fn send_command(hs: &mut Box<dyn SerialPort>, cmd: LiveCommand) -> Result<()> {
+    hs.write_all(&[cmd as u8])?;
+    wait_for_ack(hs)
+}
+
+// Sends the layout of the named profile to be swapped in at the next tick.
+// The whole push must arrive within the firmware's push deadline, so it is
+// written in one go.
+fn push_profile(hs: &mut Box<dyn SerialPort>, name: &str, persist: bool) -> Result<()> {
+    let profiles = match profiles::load_all(&Path::new("../profiles")) {
+        Ok(x) => x,
+        Err(e) => return Err(anyhow!("Unable to load profiles: {}", e)),
+    };
+    let profile = match profiles::find(&profiles, name) {
+        Some(i) => &profiles[i],
+        None => return Err(anyhow!("No profile named {}.", name)),
+    };
+    let layout = match profile.layout.as_ref() {
+        Some(x) => x,
+        None => return Err(anyhow!("Profile {} has no layout.", name)),
+    };
+    let body = match encoder::encode_layout(layout) {
+        Ok(x) => x,
+        Err(e) => return Err(anyhow!("Unable to encode layout: {}", e)),
+    };
+
+    let mut push = Vec::new();
+    push.push(if persist { PUSH_PERSIST_FLAG } else { 0 });
+    push.extend_from_slice(&body);
+
+    send_command(hs, LiveCommand::PushProfile)?;
+    hs.write_all(&push)?;
+    match wait_for_ack(hs) {
+        Ok(()) => Ok(()),
+        Err(_) => Err(anyhow!(
+            "HS rejected the push. Its running layout and stored profiles are unchanged."
+        )),
+    }
+}
+
+// Prints the cycle histogram of each tick stage since the last dump. For each
+// stage HS sends the longest sample, then the count of each bucket, where
+// bucket N counts samples taking [2^(N-1), 2^N) cycles. HS rejects the command
+// unless built with HS_PROFILE.
+fn print_cycle_histograms(hs: &mut Box<dyn SerialPort>) -> Result<()> {
+    if send_command(hs, LiveCommand::SendCycleHistograms).is_err() {
+        return Err(anyhow!("HS was built without HS_PROFILE."));
+    }
+    for stage in PROFILER_STAGES.iter() {
+        let ints = read_ints(hs, 1 + PROFILER_BUCKETS)?;
+        println!("{}: max {} cycles", stage, ints[0]);
+        for (bucket, count) in ints[1..].iter().enumerate() {
+            if *count == 0 {
+                continue;
+            }
+            let low: u64 = if bucket == 0 { 0 } else { 1 << (bucket - 1) };
+            println!("\t[{}, {}): {}", low, 1u64 << bucket, count);
+        }
+    }
+    Ok(())
+}
+
+// Prints the input-to-send latency of each pin pressed since boot. For each
+// pin HS sends the edge count, then the min, mean, p99 and max latency in CPU
+// cycles.
+fn print_latency_stats(hs: &mut Box<dyn SerialPort>) -> Result<()> {
+    send_command(hs, LiveCommand::SendLatencyStats)?;
+    for pin in PINS.iter() {
+        let stats = read_ints(hs, 5)?;
+        if stats[0] == 0 {
+            continue;
+        }
+        println!(
+            "{}: {} edges, min {}, mean {}, p99 {}, max {} cycles",
+            pin, stats[0], stats[1], stats[2], stats[3], stats[4]
+        );
+    }
+    Ok(())
+}
+
+fn main() -> Result<()> {
+    let args: Vec<String> = env::args().collect();
+    let mut hs = connect()?;
+    match args.get(1).map(String::as_str) {
+        Some("push") => {
+            let name = match args.get(2) {
+                Some(x) => x,
+                None => return Err(anyhow!(USAGE)),
+            };
+            let persist = args.iter().skip(3).any(|x| x == "--persist");
+            push_profile(&mut hs, name, persist)?;
+            println!("Pushed {}.", name);
+        }
+        Some("histograms") => print_cycle_histograms(&mut hs)?,
+        Some("latency") => print_latency_stats(&mut hs)?,
+        _ => return Err(anyhow!(USAGE)),
+    }
+    Ok(())
+}
@@ -1,17 +1,51 @@
 // Copyright 2024 Hiram Silvey
 
-use crate::profile::profile::layer::action::ActionType::{Analog, Digital};
+use crate::profile::profile::layer::action::ActionType::{Analog, Digital, Macro, TapHold, Turbo};
 use crate::profile::profile::layer::Action;
 use crate::profile::profile::layer::DigitalAction;
+use crate::profile::profile::layout::{Sectors, Snapback};
 use crate::profile::profile::Platform::Unknown;
 use crate::profile::profile::{Layer, Layout, PlatformConfig};
 use crate::profile::Profile;
 use anyhow::{anyhow, Result};
 use std::cmp;
 
-const BUTTON_ID_BITS: i32 = 5;
+// Written before the profiles, so the firmware rejects images encoded in an
+// older format. Must match kFormatVersion in the firmware's decoder.h, and be
+// bumped along with it whenever the encoding changes.
+const FORMAT_VERSION: u8 = 1;
+const BUTTON_ID_BITS: i32 = 6;
 const BUTTON_VALUE_BITS: i32 = 10;
-const MAX_DIGITAL_ACTION_VALUE: i32 = DigitalAction::Mod as i32;
+// Encoded button IDs above this value are analog actions, offset by their
+// analog ID. Lower values are reserved for digital actions.
+const ANALOG_ACTION_ID_OFFSET: i32 = 32;
+// Encoded button ID of a tap-hold action, followed by the IDs of its tap and
+// hold digital actions.
+const TAP_HOLD_ACTION_ID: i32 = ANALOG_ACTION_ID_OFFSET;
+// Encoded button IDs of the remaining actions with parameters, counted down
+// from the top so analog IDs can grow. A turbo action is followed by its
+// digital action ID and rate, and a macro action by its macro index.
+const TURBO_ACTION_ID: i32 = 63;
+const MACRO_ACTION_ID: i32 = 62;
+const TURBO_RATE_BITS: i32 = 8;
+const MACRO_INDEX_BITS: i32 = 4;
+const MAX_MACROS: usize = 4;
+const MAX_MACRO_STEPS: usize = 8;
+const MAX_MACRO_STEP_ACTIONS: usize = 4;
+// Set in the joystick threshold byte when an options block follows it. The
+// block is a length byte followed by options, each a tag byte, a length byte
+// and the option data.
+const OPTIONS_FLAG: u8 = 0x80;
+const AXIS_POLICIES_TAG: u8 = 1;
+const TAP_HOLD_TERM_TAG: u8 = 2;
+const MACROS_TAG: u8 = 3;
+const DEBOUNCE_TAG: u8 = 4;
+const SNAPBACK_TAG: u8 = 5;
+const SECTORS_TAG: u8 = 6;
+const RESPONSE_CURVE_TAG: u8 = 7;
+const MAX_CURVE_POINTS: usize = 8;
+const NUM_PINS: i32 = 16;
+const AXIS_POLICY_BITS: i32 = 4;
 
 #[derive(Debug, Eq, Ord, PartialEq, PartialOrd)]
 struct PlatformMask {
@@ -74,10 +108,31 @@ fn get_button(action: &Action) -> Option<Button> {
         Digital(x) => {
             encoded.data = *x;
         }
+        TapHold(x) => {
+            encoded.num_bits = 3 * BUTTON_ID_BITS;
+            encoded.data =
+                (TAP_HOLD_ACTION_ID << (2 * BUTTON_ID_BITS)) | (x.tap << BUTTON_ID_BITS) | x.hold;
+        }
+        Turbo(x) => {
+            if x.rate < 1 || x.rate >= 1 << TURBO_RATE_BITS {
+                return None;
+            }
+            encoded.num_bits = 2 * BUTTON_ID_BITS + TURBO_RATE_BITS;
+            encoded.data = (TURBO_ACTION_ID << (BUTTON_ID_BITS + TURBO_RATE_BITS))
+                | (x.action << TURBO_RATE_BITS)
+                | x.rate;
+        }
+        Macro(x) => {
+            if *x < 0 || *x as usize >= MAX_MACROS {
+                return None;
+            }
+            encoded.num_bits = BUTTON_ID_BITS + MACRO_INDEX_BITS;
+            encoded.data = (MACRO_ACTION_ID << MACRO_INDEX_BITS) | *x;
+        }
         Analog(x) => {
             if x.id != 0 {
                 encoded.num_bits = BUTTON_ID_BITS + BUTTON_VALUE_BITS;
-                encoded.data = ((x.id + MAX_DIGITAL_ACTION_VALUE) << BUTTON_VALUE_BITS) | x.value;
+                encoded.data = ((x.id + ANALOG_ACTION_ID_OFFSET) << BUTTON_VALUE_BITS) | x.value;
             }
         }
     }
@@ -141,6 +196,157 @@ fn encode_layer(layer: &Layer) -> Result<Vec<u8>> {
     Ok(encoded)
 }
 
+fn encode_macros(layout: &Layout) -> Result<Vec<u8>> {
+    if layout.macros.len() > MAX_MACROS {
+        return Err(anyhow!("More than {} macros.", MAX_MACROS));
+    }
+    let mut encoded: Vec<u8> = Vec::new();
+    for m in layout.macros.iter() {
+        if m.steps.len() > MAX_MACRO_STEPS {
+            return Err(anyhow!("Macro has more than {} steps.", MAX_MACRO_STEPS));
+        }
+        encoded.push(m.steps.len() as u8);
+        for step in m.steps.iter() {
+            if step.actions.len() > MAX_MACRO_STEP_ACTIONS {
+                return Err(anyhow!(
+                    "Macro step has more than {} actions.",
+                    MAX_MACRO_STEP_ACTIONS
+                ));
+            }
+            if step.duration < 1 || step.duration > 0xFFFF {
+                return Err(anyhow!(
+                    "Macro step duration {} outside of [1-65535] range.",
+                    step.duration
+                ));
+            }
+            encoded.push(step.actions.len() as u8);
+            encoded.extend(step.actions.iter().map(|&action| action as u8));
+            encoded.push((step.duration >> 8) as u8);
+            encoded.push(step.duration as u8);
+        }
+    }
+    Ok(vec![vec![MACROS_TAG, encoded.len() as u8], encoded].concat())
+}
+
+fn encode_debounce(layout: &Layout) -> Result<Vec<u8>> {
+    let mut encoded: Vec<u8> = Vec::new();
+    let mut seen = 0u16;
+    for debounce in layout.debounce.iter() {
+        if debounce.pin < 0 || debounce.pin >= NUM_PINS {
+            return Err(anyhow!(
+                "Debounce pin {} outside of [0-15] range.",
+                debounce.pin
+            ));
+        }
+        if seen & (1 << debounce.pin) != 0 {
+            return Err(anyhow!("Debounce pin {} set more than once.", debounce.pin));
+        }
+        seen |= 1 << debounce.pin;
+        if debounce.mode < 0 || debounce.mode > 0xF {
+            return Err(anyhow!("Debounce mode {} is not supported.", debounce.mode));
+        }
+        if debounce.time < 1 || debounce.time > 0xFFFF {
+            return Err(anyhow!(
+                "Debounce time {} outside of [1-65535] range.",
+                debounce.time
+            ));
+        }
+        encoded.push(((debounce.pin << 4) | debounce.mode) as u8);
+        encoded.push((debounce.time >> 8) as u8);
+        encoded.push(debounce.time as u8);
+    }
+    Ok(vec![vec![DEBOUNCE_TAG, encoded.len() as u8], encoded].concat())
+}
+
+fn encode_snapback(snapback: &Snapback) -> Result<Vec<u8>> {
+    if snapback.velocity < 0 || snapback.velocity > 0xFF {
+        return Err(anyhow!(
+            "Snapback velocity {} outside of [0-255] range.",
+            snapback.velocity
+        ));
+    }
+    if snapback.velocity == 0 {
+        return Ok(Vec::new());
+    }
+    if snapback.max_overshoot < 1 || snapback.max_overshoot > 100 {
+        return Err(anyhow!(
+            "Snapback max overshoot {} outside of [1-100] range.",
+            snapback.max_overshoot
+        ));
+    }
+    if snapback.window < 1 || snapback.window > 0xFF {
+        return Err(anyhow!(
+            "Snapback window {} outside of [1-255] range.",
+            snapback.window
+        ));
+    }
+    Ok(vec![
+        SNAPBACK_TAG,
+        3,
+        snapback.velocity as u8,
+        snapback.max_overshoot as u8,
+        snapback.window as u8,
+    ])
+}
+
+fn encode_sectors(sectors: &Sectors) -> Result<Vec<u8>> {
+    if sectors.diagonal_width < 0 || sectors.diagonal_width > 90 {
+        return Err(anyhow!(
+            "Sector diagonal width {} outside of [0-90] range.",
+            sectors.diagonal_width
+        ));
+    }
+    if sectors.angle_hysteresis < 0 || sectors.angle_hysteresis > 45 {
+        return Err(anyhow!(
+            "Sector angle hysteresis {} outside of [0-45] range.",
+            sectors.angle_hysteresis
+        ));
+    }
+    if sectors.radius_hysteresis < 0 || sectors.radius_hysteresis > 100 {
+        return Err(anyhow!(
+            "Sector radius hysteresis {} outside of [0-100] range.",
+            sectors.radius_hysteresis
+        ));
+    }
+    Ok(vec![
+        SECTORS_TAG,
+        3,
+        sectors.diagonal_width as u8,
+        sectors.angle_hysteresis as u8,
+        sectors.radius_hysteresis as u8,
+    ])
+}
+
+fn encode_response_curve(layout: &Layout) -> Result<Vec<u8>> {
+    if layout.response_curve.len() > MAX_CURVE_POINTS {
+        return Err(anyhow!(
+            "Response curve has more than {} points.",
+            MAX_CURVE_POINTS
+        ));
+    }
+    let mut encoded: Vec<u8> = Vec::new();
+    let mut last_input = 0;
+    for point in layout.response_curve.iter() {
+        if point.input <= last_input || point.input > 99 {
+            return Err(anyhow!(
+                "Response curve input {} outside of [{}-99] range.",
+                point.input,
+                last_input + 1
+            ));
+        }
+        if point.output < 0 || point.output > 100 {
+            return Err(anyhow!(
+                "Response curve output {} outside of [0-100] range.",
+                point.output
+            ));
+        }
+        last_input = point.input;
+        encoded.push(point.input as u8);
+        encoded.push(point.output as u8);
+    }
+    Ok(vec![vec![RESPONSE_CURVE_TAG, encoded.len() as u8], encoded].concat())
+}
+
 fn encode_body(layout: &Layout) -> Result<Vec<u8>> {
     if layout.joystick_threshold < 0 || layout.joystick_threshold > 100 {
         return Err(anyhow!(
@@ -149,6 +355,65 @@ fn encode_body(layout: &Layout) -> Result<Vec<u8>> {
         ));
     }
     let mut encoded: Vec<u8> = vec![layout.joystick_threshold as u8];
+    let mut options: Vec<u8> = Vec::new();
+    if let Some(x) = layout.axis_policies.as_ref() {
+        let policies = [
+            x.left_x,
+            x.left_y,
+            x.right_x,
+            x.right_y,
+            x.slider_left,
+            x.slider_right,
+        ];
+        if policies.iter().any(|&policy| policy != 0) {
+            options.extend_from_slice(&[AXIS_POLICIES_TAG, 3]);
+            for pair in policies.chunks(2) {
+                for &policy in pair {
+                    if policy < 0 || policy >= 1 << AXIS_POLICY_BITS {
+                        return Err(anyhow!("Axis policy {} is not supported.", policy));
+                    }
+                }
+                options.push(((pair[0] << AXIS_POLICY_BITS) | pair[1]) as u8);
+            }
+        }
+    }
+    if layout.tap_hold_term < 0 || layout.tap_hold_term > 0xFFFF {
+        return Err(anyhow!(
+            "Tap-hold term {} outside of [0-65535] range.",
+            layout.tap_hold_term
+        ));
+    }
+    if layout.tap_hold_term != 0 {
+        options.extend_from_slice(&[
+            TAP_HOLD_TERM_TAG,
+            2,
+            (layout.tap_hold_term >> 8) as u8,
+            layout.tap_hold_term as u8,
+        ]);
+    }
+    if !layout.macros.is_empty() {
+        options.append(&mut encode_macros(layout)?);
+    }
+    if !layout.debounce.is_empty() {
+        options.append(&mut encode_debounce(layout)?);
+    }
+    if let Some(snapback) = layout.snapback.as_ref() {
+        options.append(&mut encode_snapback(snapback)?);
+    }
+    if let Some(sectors) = layout.sectors.as_ref() {
+        options.append(&mut encode_sectors(sectors)?);
+    }
+    if !layout.response_curve.is_empty() {
+        options.append(&mut encode_response_curve(layout)?);
+    }
+    if options.len() > u8::MAX as usize {
+        return Err(anyhow!("Layout options take more than 255 bytes."));
+    }
+    if !options.is_empty() {
+        encoded[0] |= OPTIONS_FLAG;
+        encoded.push(options.len() as u8);
+        encoded.append(&mut options);
+    }
     match layout.base.as_ref() {
         Some(x) => encoded.append(&mut encode_layer(x)?),
         None => return Err(anyhow!("Unable to get base layer.")),
@@ -165,16 +430,29 @@ fn encode_profile(profile: &Profile) -> Result<Vec<u8>> {
         None => return Err(anyhow!("Unable to get layout.")),
     };
     let mut header = encode_header(&profile.platform_config)?;
-    let mut body = encode_body(layout)?;
+    let mut body = encode_layout(layout)?;
     let mut encoded: Vec<u8> = Vec::new();
     encoded.append(&mut header);
+    encoded.append(&mut body);
+    Ok(encoded)
+}
+
+// Encodes the layout as a length-prefixed body, as stored in EEPROM after each
+// profile header and as sent in a live profile push.
+pub fn encode_layout(layout: &Layout) -> Result<Vec<u8>> {
+    let mut body = encode_body(layout)?;
+    // The body length prefix is a single byte.
+    if body.len() > u8::MAX as usize {
+        return Err(anyhow!("Profile body takes more than 255 bytes."));
+    }
+    let mut encoded: Vec<u8> = Vec::new();
     encoded.push(body.len() as u8);
     encoded.append(&mut body);
     Ok(encoded)
 }
 
 pub fn encode(profiles: &Vec<Profile>) -> Result<Vec<u8>> {
-    let mut encoded: Vec<u8> = Vec::new();
+    let mut encoded: Vec<u8> = vec![FORMAT_VERSION];
     for profile in profiles {
         encoded.append(&mut encode_profile(&profile)?);
     }
@@ -1,6 +1,6 @@
 // Copyright 2024 Hiram Silvey
 
-use profile::profile::layer::action::ActionType::{Analog, Digital};
+use profile::profile::layer::action::ActionType::{Analog, Digital, Macro, TapHold, Turbo};
 use profile::profile::layer::Action;
 use profile::profile::Layer;
 use profile::profile::Layout;
@@ -22,6 +22,9 @@ impl fmt::Display for Action {
         match action_type {
             Digital(x) => write!(f, "{}", x)?,
             Analog(x) => write!(f, "{}, {}", x.id, x.value)?,
+            TapHold(x) => write!(f, "tap {}, hold {}", x.tap, x.hold)?,
+            Turbo(x) => write!(f, "turbo {} at {}/s", x.action, x.rate)?,
+            Macro(x) => write!(f, "macro {}", x)?,
         }
         Ok(())
     }
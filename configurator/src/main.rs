@@ -20,8 +20,11 @@ use std::time::{Duration, Instant};
 const MAX_EEPROM_BYTES: usize = 1064;
 const JOYSTICK_CURSOR_RADIUS: f64 = 3.;
 const JOYSTICK_BOX_LENGTH: f64 = 400.;
+const JOYSTICK_OUTPUT_MAX: f64 = 1023.;
+const PREVIEW_SAMPLES: u16 = 1000;
 const SET_CURSOR: Selector<Point> = Selector::new("hs.set-cursor");
 const SET_DEFAULT_BOUNDS: Selector<Bounds> = Selector::new("hs.set-default-bounds");
+const SET_PREVIEW: Selector<Point> = Selector::new("hs.set-preview");
 
 #[derive(Clone, Copy)]
 enum Command {
@@ -30,6 +33,7 @@ enum Command {
     CalibrateJoystick,
     SaveCalibration,
     StoreProfiles,
+    PreviewCalibration,
 }
 
 #[derive(Clone, Copy, Data, Lens)]
@@ -91,6 +95,7 @@ struct JoystickState {
     default_bounds: Bounds,
     custom_bounds: Bounds,
     digital_threshold: f64,
+    preview: Option<Point>,
 }
 
 impl JoystickState {
@@ -100,6 +105,7 @@ impl JoystickState {
             default_bounds: Bounds::new(),
             custom_bounds: Bounds::new(),
             digital_threshold: 0.0,
+            preview: None,
         }
     }
 
@@ -107,6 +113,10 @@ impl JoystickState {
         self.cursor = *point;
     }
 
+    fn set_preview(&mut self, point: &Point) {
+        self.preview = Some(*point);
+    }
+
     fn set_bounds(&mut self, bounds: &Bounds) {
         self.default_bounds = *bounds;
         self.custom_bounds = *bounds;
@@ -218,6 +228,10 @@ impl Widget<JoystickState> for JoystickState {
                 let bounds = cmd.get_unchecked(SET_DEFAULT_BOUNDS).clone();
                 data.set_bounds(&bounds);
             }
+            Event::Command(cmd) if cmd.is(SET_PREVIEW) => {
+                let point = cmd.get_unchecked(SET_PREVIEW).clone();
+                data.set_preview(&point);
+            }
             _ => (),
         }
     }
@@ -476,6 +490,30 @@ impl Widget<JoystickState> for JoystickState {
             let cursor = Circle::new(Point::new(cursor_x, cursor_y), JOYSTICK_CURSOR_RADIUS);
             ctx.stroke(cursor, &cursor_color, 2.0);
         });
+
+        // Normalized output streamed back from the controller, drawn against the
+        // default bounds' box.
+        if let Some(preview) = data.preview {
+            let preview_x = map(
+                preview.x,
+                0.0,
+                JOYSTICK_OUTPUT_MAX,
+                default_x_min,
+                default_x_max,
+            );
+            let preview_y = map(
+                preview.y,
+                0.0,
+                JOYSTICK_OUTPUT_MAX,
+                default_y_max,
+                default_y_min,
+            );
+            let preview_color = env.get(theme::PRIMARY_LIGHT);
+            ctx.paint_with_z_index(1, move |ctx| {
+                let cursor = Circle::new(Point::new(preview_x, preview_y), JOYSTICK_CURSOR_RADIUS);
+                ctx.fill(cursor, &preview_color);
+            });
+        }
     }
 }
 
@@ -631,6 +669,40 @@ fn save_calibration(
     Ok(())
 }
 
+fn preview_calibration(
+    hs: &mut Box<dyn SerialPort>,
+    receiver: &Receiver<f64>,
+    event_sink: &ExtEventSink,
+) -> Result<()> {
+    let center_x = receiver.recv()?;
+    let center_y = receiver.recv()?;
+    let range = receiver.recv()?;
+    let angle_ticks = receiver.recv()?;
+    let threshold = receiver.recv()?;
+
+    hs.write_all(&float_to_bytes(center_x))?;
+    hs.write_all(&float_to_bytes(center_y))?;
+    hs.write_all(&float_to_bytes(range))?;
+    hs.write_all(&short_to_bytes(angle_ticks as i16))?;
+    hs.write_all(&[threshold as u8])?;
+    hs.write_all(&short_to_bytes(PREVIEW_SAMPLES as i16))?;
+
+    for _ in 0..PREVIEW_SAMPLES {
+        let mut x = vec![0u8; 2];
+        let mut y = vec![0u8; 2];
+        wait_for_data(hs, &mut x)?;
+        wait_for_data(hs, &mut y)?;
+
+        event_sink.submit_command(
+            SET_PREVIEW,
+            Point::new(bytes_to_short(&x)? as f64, bytes_to_short(&y)? as f64),
+            Target::Auto,
+        )?;
+    }
+
+    Ok(())
+}
+
 fn store_profiles(hs: &mut Box<dyn SerialPort>, sender: &Sender<f64>) -> Result<()> {
     let profiles = match profiles::load_all(&Path::new("../profiles")) {
         Ok(x) => x,
@@ -670,6 +742,7 @@ fn build_ui(
 ) -> impl Widget<JoystickState> {
     let (cmd_sender2, receiver2) = (cmd_sender.clone(), receiver.clone());
     let (cmd_sender3, receiver3) = (cmd_sender.clone(), receiver.clone());
+    let (cmd_sender4, data_sender2) = (cmd_sender.clone(), data_sender.clone());
 
     let threshold_display = Label::new(|data: &f64, _env: &_| format!("{}%", data))
         .with_text_size(14.0)
@@ -796,6 +869,33 @@ fn build_ui(
             ),
             1.0,
         )
+        .with_flex_child(
+            Button::new("Preview Calibration").on_click(
+                move |_event, data: &mut JoystickState, _env| {
+                    match cmd_sender4.send(Command::PreviewCalibration) {
+                        Ok(()) => println!("Previewing calibration..."),
+                        Err(e) => {
+                            println!("Failed issuing 'preview calibration' command: {}", e);
+                            return;
+                        }
+                    }
+                    let values = [
+                        data.custom_bounds.center.x,
+                        data.custom_bounds.center.y,
+                        data.custom_bounds.range,
+                        data.custom_bounds.angle_ticks.into(),
+                        data.digital_threshold,
+                    ];
+                    for value in values.iter() {
+                        if let Err(e) = data_sender2.send(*value) {
+                            println!("Failed to send preview calibration value: {}", e);
+                            return;
+                        }
+                    }
+                },
+            ),
+            1.0,
+        )
         .with_flex_child(
             Button::new("Store Profiles").on_click(move |_event, _data, _env| {
                 match cmd_sender3.send(Command::StoreProfiles) {
@@ -839,6 +939,9 @@ fn drive(
             Command::CalibrateJoystick => calibrate_joystick(&mut hs, &sender)?,
             Command::SaveCalibration => save_calibration(&mut hs, &sender, &data_receiver)?,
             Command::StoreProfiles => store_profiles(&mut hs, &sender)?,
+            Command::PreviewCalibration => {
+                preview_calibration(&mut hs, &data_receiver, &event_sink)?
+            }
         };
     }
 }
@@ -855,7 +958,7 @@ pub fn main() -> Result<(), PlatformError> {
             parent_data_receiver,
         ))
         .title("HS Configurator")
-        .window_size((JOYSTICK_BOX_LENGTH, JOYSTICK_BOX_LENGTH + 150.0))
+        .window_size((JOYSTICK_BOX_LENGTH, JOYSTICK_BOX_LENGTH + 180.0))
         .with_min_size((JOYSTICK_BOX_LENGTH, JOYSTICK_BOX_LENGTH)),
     );
 
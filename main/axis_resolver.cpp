@@ -0,0 +1,109 @@
+// Copyright 2024 Hiram Silvey
+
+#include "axis_resolver.h"
+
+#include <climits>
+
+#include "profile.pb.h"
+
+namespace hs {
+
+AxisResolver::AxisResolver()
+    : AxisResolver({}, hs_profile_Profile_Layout_AxisPolicy_OPPOSING_CANCEL,
+                   0, 0) {}
+
+AxisResolver::AxisResolver(const AnalogButtons& buttons, AxisPolicy policy,
+                           int neutral, int max)
+    : buttons_(buttons),
+      policy_(policy),
+      neutral_(neutral),
+      max_(max),
+      tabled_(false),
+      table_{},
+      last_held_(0),
+      press_seq_(0),
+      pressed_at_{} {
+  // LAST_PRESSED depends on press order, which the held buttons alone don't
+  // capture.
+  if (buttons_.size() > kMaxTableButtons ||
+      policy_ == hs_profile_Profile_Layout_AxisPolicy_LAST_PRESSED) {
+    return;
+  }
+  for (int held = 0; held < 1 << buttons_.size(); held++) {
+    table_[held] = Combine(held);
+  }
+  tabled_ = true;
+}
+
+int AxisResolver::Resolve(uint32_t inputs) {
+  const uint32_t held = Held(inputs);
+  if (tabled_) {
+    return table_[held];
+  }
+  if (policy_ != hs_profile_Profile_Layout_AxisPolicy_LAST_PRESSED) {
+    return Combine(held);
+  }
+
+  const uint32_t pressed = held & ~last_held_;
+  last_held_ = held;
+  int latest = -1;
+  for (size_t i = 0; i < buttons_.size(); i++) {
+    if (pressed & (1u << i)) {
+      pressed_at_[i] = ++press_seq_;
+    }
+    if (held & (1u << i) &&
+        (latest < 0 || pressed_at_[i] > pressed_at_[latest])) {
+      latest = i;
+    }
+  }
+  return latest < 0 ? neutral_ : buttons_[latest].value;
+}
+
+uint32_t AxisResolver::Held(uint32_t inputs) const {
+  uint32_t held = 0;
+  for (size_t i = 0; i < buttons_.size(); i++) {
+    if (inputs & (1u << buttons_[i].pin)) {
+      held |= 1u << i;
+    }
+  }
+  return held;
+}
+
+int AxisResolver::Combine(uint32_t held) const {
+  if (held == 0) {
+    return neutral_;
+  }
+
+  int lowest = INT_MAX;
+  int highest = INT_MIN;
+  int below = neutral_;
+  int above = neutral_;
+  int sum = neutral_;
+  for (size_t i = 0; i < buttons_.size(); i++) {
+    if (!(held & (1u << i))) {
+      continue;
+    }
+    const int value = buttons_[i].value;
+    lowest = value < lowest ? value : lowest;
+    highest = value > highest ? value : highest;
+    below = value < below ? value : below;
+    above = value > above ? value : above;
+    sum += value - neutral_;
+  }
+
+  switch (policy_) {
+    case hs_profile_Profile_Layout_AxisPolicy_HIGHEST:
+      return highest;
+    case hs_profile_Profile_Layout_AxisPolicy_LOWEST:
+      return lowest;
+    case hs_profile_Profile_Layout_AxisPolicy_SUM_CLAMPED:
+      return sum < 0 ? 0 : sum > max_ ? max_ : sum;
+    default:
+      if (below != neutral_ && above != neutral_) {
+        return neutral_;
+      }
+      return below != neutral_ ? below : above;
+  }
+}
+
+}  // namespace hs
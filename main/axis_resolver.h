@@ -0,0 +1,83 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef AXIS_RESOLVER_H_
+#define AXIS_RESOLVER_H_
+
+#include <stdint.h>
+
+#include "profile.pb.h"
+#include "tap_hold.h"
+#include "util.h"
+
+namespace hs {
+
+// `pin` is the input the button is mapped to, which is the pin itself unless
+// the pin is a tap-hold pin.
+struct AnalogButton {
+  int value;
+  int pin;
+};
+
+// Analog buttons driving a single axis. Each input holds one action per
+// layer, so the input count bounds the number of buttons.
+using AnalogButtons = util::FixedVector<AnalogButton, kNumInputs>;
+
+using AxisPolicy = hs_profile_Profile_Layout_AxisPolicy;
+
+// Axes which can be driven by analog buttons.
+enum Axis {
+  kLeftX,
+  kLeftY,
+  kRightX,
+  kRightY,
+  kSliderLeft,
+  kSliderRight,
+  kNumAxes
+};
+
+// Axes with up to this many buttons have the value of every combination of
+// held buttons computed when the layout is loaded.
+const int kMaxTableButtons = 5;
+
+// Resolves the value of one axis from the buttons driving it, combining
+// simultaneously held buttons according to the axis policy.
+class AxisResolver {
+ public:
+  AxisResolver();
+
+  // Compile the buttons and policy. Axis values range from 0 to `max` and
+  // rest at `neutral`.
+  AxisResolver(const AnalogButtons& buttons, AxisPolicy policy, int neutral,
+               int max);
+
+  // Axis value given the state of every input. Not const, as LAST_PRESSED
+  // tracks the order buttons were pressed in.
+  int Resolve(uint32_t inputs);
+
+ private:
+  // Bitfield of the held buttons, indexed by their position in `buttons_`.
+  uint32_t Held(uint32_t inputs) const;
+
+  // Combine the values of the held buttons according to the policy.
+  int Combine(uint32_t held) const;
+
+  AnalogButtons buttons_;
+  AxisPolicy policy_;
+  int neutral_;
+  int max_;
+
+  // Combined values indexed by the held buttons, if there are few enough
+  // buttons.
+  bool tabled_;
+  int table_[1 << kMaxTableButtons];
+
+  // LAST_PRESSED state: the buttons held last tick and the press sequence
+  // number of each button.
+  uint32_t last_held_;
+  uint32_t press_seq_;
+  uint32_t pressed_at_[kNumInputs];
+};
+
+}  // namespace hs
+
+#endif  // AXIS_RESOLVER_H_
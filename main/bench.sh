@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# Copyright 2024 Hiram Silvey
+
+# Build and run the benchmarks against the compiled profiles, exported by the
+# configurator exactly as it would flash them. Results are printed as JSON;
+# any arguments are passed through, e.g. --benchmark_out=results.json to also
+# save them.
+
+src_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" &>/dev/null && pwd)"
+image="$src_dir/build/profiles.bin"
+(cd "$src_dir/../configurator/src" &&
+  cargo +nightly run -Z configurable-env --bin export -- "$image") || exit 1
+cd "$src_dir/build"
+cmake .. && cmake --build . --target hs_bench && ./hs_bench "$image" "$@"
@@ -0,0 +1,292 @@
+// Copyright 2024 Hiram Silvey
+
+// Benchmarks for the hot paths, run against every profile in an EEPROM
+// profiles image written by the configurator's export binary:
+//
+//   cargo run --bin export -- profiles.bin
+//
+// Usage: hs_bench PROFILES_IMAGE [--benchmark_...]
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "axis_resolver.h"
+#include "controller.h"
+#include "decoder.h"
+#include "hall_joystick.h"
+#include "ns_controller.h"
+#include "pc_controller.h"
+#include "pins.h"
+#include "profile.pb.h"
+#include "test/sim_nspad.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+namespace bench {
+
+namespace {
+
+const unsigned long kTickMicros = 125;
+
+// Minimum time between hall sensor reads.
+const unsigned long kSensorMicros = 330;
+
+// Ticks between input changes in the controller benchmarks.
+const int kTicksPerSnapshot = 8;
+
+// Captured reports are dropped once this many have piled up.
+const size_t kMaxReports = 4096;
+
+const HallJoystick::Calibration kCalibration = {
+    .neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0};
+
+const SimTeensy::HallSample kHallSample = {
+    .micros = 0, .x = 0.0003, .y = -0.0002, .z = 1};
+
+// Button held at boot to select each profile position.
+const int kPositionPins[] = {
+    -1,  // Nothing held
+    pins::kIndexTop,     pins::kMiddleTop,   pins::kRingTop,
+    pins::kPinkyTop,     pins::kIndexMiddle, pins::kMiddleMiddle,
+    pins::kRingMiddle,   pins::kPinkyMiddle, pins::kThumbTop,
+    pins::kMiddleBottom, pins::kRingBottom,  pins::kPinkyBottom};
+
+// A profile stored in the image.
+struct Profile {
+  std::string name;
+  decoder::PlatformConfigs configs;
+  hs_profile_Profile_Layout layout;
+};
+
+// A stored profile, as selected on one platform.
+struct Case {
+  const Profile* profile;
+  hs_profile_Profile_Platform platform;
+  int position;
+  // Every stored profile, without the length prefix and format version.
+  const std::vector<uint8_t>* encoded;
+};
+
+// Read a profiles image, laid out as the configurator stores it in EEPROM
+// from address 14 on, and strip its 2-byte length prefix and format version.
+// Returns false if the file is unreadable, the prefix doesn't match its
+// length or the image is in another format.
+bool ReadImage(const std::string& path, std::vector<uint8_t>& encoded) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::vector<uint8_t> image((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  if (image.size() < 3 ||
+      static_cast<size_t>(image[0] << 8 | image[1]) != image.size() - 2 ||
+      image[2] != decoder::kFormatVersion) {
+    return false;
+  }
+  encoded.assign(image.begin() + 3, image.end());
+  return true;
+}
+
+// Decode every profile in the image, walking the headers the same way
+// decoder::internal::FindProfile() does.
+std::vector<Profile> DecodeProfiles(const std::vector<uint8_t>& encoded) {
+  SimTeensy teensy;
+  teensy.WriteProfiles(encoded);
+  std::vector<Profile> profiles;
+  const int end_addr = 17 + encoded.size();
+  int addr = 17;
+  while (addr < end_addr) {
+    Profile profile;
+    profile.name = "profile" + std::to_string(profiles.size());
+    profile.configs = decoder::internal::DecodeHeader(teensy, addr);
+    addr += profile.configs.size() / 2 + profile.configs.size() % 2 + 1;
+    const int body_addr = addr;
+    profile.layout = decoder::internal::DecodeBody(teensy, addr);
+    addr = body_addr + 1 + teensy.EEPROMRead(body_addr);
+    profiles.push_back(profile);
+  }
+  return profiles;
+}
+
+// Pseudo-random pin snapshots, so the benchmarks see a mix of held buttons,
+// edges and SOCD conflicts.
+std::vector<uint16_t> PinPattern() {
+  std::vector<uint16_t> pattern(1024);
+  uint32_t state = 0x12345678;
+  for (auto& pins : pattern) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    // Hold roughly a quarter of the buttons at a time.
+    pins = state & (state >> 16);
+  }
+  return pattern;
+}
+
+// Flash every profile and hold the button selecting the case's position,
+// ready for a controller to boot.
+std::unique_ptr<SimTeensy> Flash(const Case& c) {
+  auto teensy = std::make_unique<SimTeensy>();
+  teensy->WriteCalibration(kCalibration);
+  teensy->WriteProfiles(*c.encoded);
+  teensy->AddHallSample(kHallSample);
+  if (c.position > 0 &&
+      c.position < static_cast<int>(std::size(kPositionPins))) {
+    teensy->SetPins(1 << kPositionPins[c.position]);
+  }
+  return teensy;
+}
+
+template <typename Controller, typename Reports>
+void RunLoop(benchmark::State& state, SimTeensy& teensy,
+             Controller& controller, Reports& reports) {
+  const std::vector<uint16_t> pattern = PinPattern();
+  size_t tick = 0;
+  for (auto _ : state) {
+    teensy.SetPins(pattern[tick++ / kTicksPerSnapshot % pattern.size()]);
+    controller.Loop();
+    teensy.Advance(kTickMicros);
+    if (reports.reports().size() >= kMaxReports) {
+      reports.ClearReports();
+    }
+  }
+}
+
+void BM_PCController_Loop(benchmark::State& state, const Case& c) {
+  std::unique_ptr<SimTeensy> teensy = Flash(c);
+  SimTeensy* sim = teensy.get();
+  PCController controller(std::move(teensy));
+  RunLoop(state, *sim, controller, *sim);
+}
+
+void BM_NSController_Loop(benchmark::State& state, const Case& c) {
+  std::unique_ptr<SimTeensy> teensy = Flash(c);
+  SimTeensy* sim = teensy.get();
+  auto nspad = std::make_unique<SimNSPad>(*sim);
+  SimNSPad* pad = nspad.get();
+  NSController controller(std::move(teensy), std::move(nspad));
+  RunLoop(state, *sim, controller, *pad);
+}
+
+void BM_HallJoystick_GetCoordinates(benchmark::State& state, int threshold) {
+  SimTeensy teensy;
+  teensy.AddHallSample(kHallSample);
+  HallJoystick joystick(kCalibration, 0, 1023, threshold);
+  for (auto _ : state) {
+    // Step past the read interval so every call reads the sensor.
+    teensy.Advance(kSensorMicros);
+    benchmark::DoNotOptimize(joystick.GetCoordinates(teensy));
+  }
+}
+
+void BM_ResolveAxes(benchmark::State& state, const Case& c) {
+  PCController controller(Flash(c));
+  const ButtonPinMapping mapping =
+      controller.GetButtonPinMapping(c.profile->layout.base);
+  std::array<AxisResolver, kNumAxes> axes = CompileAxes(
+      mapping, c.profile->layout.axis_policies, /*neutral=*/512, /*max=*/1023);
+  const std::vector<uint16_t> pattern = PinPattern();
+  size_t i = 0;
+  for (auto _ : state) {
+    const uint16_t pins = pattern[i++ % pattern.size()];
+    for (auto& axis : axes) {
+      benchmark::DoNotOptimize(axis.Resolve(pins));
+    }
+  }
+}
+
+void BM_GetButtonPinMapping(benchmark::State& state, const Case& c) {
+  PCController controller(Flash(c));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        controller.GetButtonPinMapping(c.profile->layout.base));
+  }
+}
+
+void BM_Decode(benchmark::State& state, const Case& c) {
+  std::unique_ptr<SimTeensy> teensy = Flash(c);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        decoder::Decode(*teensy, c.platform, c.position));
+  }
+}
+
+void RegisterBenchmarks(const std::vector<Case>& cases) {
+  benchmark::RegisterBenchmark("BM_HallJoystick_GetCoordinates/analog",
+                               BM_HallJoystick_GetCoordinates, 0);
+  benchmark::RegisterBenchmark("BM_HallJoystick_GetCoordinates/digital",
+                               BM_HallJoystick_GetCoordinates, 50);
+
+  const Profile* last_profile = nullptr;
+  for (const auto& c : cases) {
+    const std::string name = "/" + c.profile->name;
+    // These don't depend on the platform, so only run them once per profile.
+    if (c.profile != last_profile) {
+      benchmark::RegisterBenchmark(("BM_ResolveAxes" + name).c_str(),
+                                   BM_ResolveAxes, c);
+      benchmark::RegisterBenchmark(("BM_GetButtonPinMapping" + name).c_str(),
+                                   BM_GetButtonPinMapping, c);
+      benchmark::RegisterBenchmark(("BM_Decode" + name).c_str(), BM_Decode,
+                                   c);
+      last_profile = c.profile;
+    }
+
+    if (c.platform == hs_profile_Profile_Platform_PC) {
+      benchmark::RegisterBenchmark(("BM_PCController_Loop" + name).c_str(),
+                                   BM_PCController_Loop, c);
+    } else if (c.platform == hs_profile_Profile_Platform_SWITCH) {
+      benchmark::RegisterBenchmark(("BM_NSController_Loop" + name).c_str(),
+                                   BM_NSController_Loop, c);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace hs
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: hs_bench PROFILES_IMAGE [--benchmark_...]\n");
+    return 2;
+  }
+  std::vector<uint8_t> encoded;
+  if (!hs::bench::ReadImage(argv[1], encoded)) {
+    fprintf(stderr, "Unreadable profiles image: %s\n", argv[1]);
+    return 2;
+  }
+  const std::vector<hs::bench::Profile> profiles =
+      hs::bench::DecodeProfiles(encoded);
+  std::vector<hs::bench::Case> cases;
+  for (const auto& profile : profiles) {
+    for (const auto& config : profile.configs) {
+      cases.push_back({.profile = &profile,
+                       .platform = config.platform,
+                       .position = config.position,
+                       .encoded = &encoded});
+    }
+  }
+  hs::bench::RegisterBenchmarks(cases);
+
+  // Report JSON by default so results can be compared between firmware
+  // versions. Flags passed on the command line still take precedence.
+  std::vector<char*> args(argv, argv + argc);
+  args.erase(args.begin() + 1);
+  char json_format[] = "--benchmark_format=json";
+  args.insert(args.begin() + 1, json_format);
+  int num_args = args.size();
+  benchmark::Initialize(&num_args, args.data());
+  if (benchmark::ReportUnrecognizedArguments(num_args, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
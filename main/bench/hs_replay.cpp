@@ -0,0 +1,116 @@
+// Copyright 2024 Hiram Silvey
+
+// Replays a recording dumped over serial against the same EEPROM image on
+// the host, reporting every tick whose report differs from the recorded one.
+//
+// Usage: hs_replay EEPROM_IMAGE RECORDING pc|switch [POSITION]
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench/replay.h"
+#include "controller.h"
+#include "ns_controller.h"
+#include "pc_controller.h"
+#include "pins.h"
+#include "recorder.h"
+#include "test/sim_nspad.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+namespace bench {
+
+namespace {
+
+// Button held at boot to select each profile position.
+const int kPositionPins[] = {
+    -1,  // Nothing held
+    pins::kIndexTop,     pins::kMiddleTop,   pins::kRingTop,
+    pins::kPinkyTop,     pins::kIndexMiddle, pins::kMiddleMiddle,
+    pins::kRingMiddle,   pins::kPinkyMiddle, pins::kThumbTop,
+    pins::kMiddleBottom, pins::kRingBottom,  pins::kPinkyBottom};
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>& bytes) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  bytes.assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+void PrintReport(const char* label, const OutputReport& report) {
+  printf("  %s: buttons=%08x dpad=%x left=(%u, %u) right=(%u, %u) "
+         "sliders=(%u, %u)\n",
+         label, report.buttons, report.dpad, report.left_x, report.left_y,
+         report.right_x, report.right_y, report.slider_left,
+         report.slider_right);
+}
+
+}  // namespace
+
+int Run(const std::string& eeprom_path, const std::string& recording_path,
+        const std::string& platform, int position) {
+  std::vector<uint8_t> dump;
+  std::vector<recorder::Entry> entries;
+  if (!ReadFile(recording_path, dump) || !ParseRecording(dump, entries)) {
+    fprintf(stderr, "Unreadable recording: %s\n", recording_path.c_str());
+    return 2;
+  }
+  if (std::ifstream(eeprom_path, std::ios::binary).fail()) {
+    fprintf(stderr, "Unreadable EEPROM image: %s\n", eeprom_path.c_str());
+    return 2;
+  }
+  if (position < 0 || position >= static_cast<int>(std::size(kPositionPins))) {
+    fprintf(stderr, "Invalid position: %d\n", position);
+    return 2;
+  }
+
+  auto teensy = std::make_unique<SimTeensy>(eeprom_path);
+  SimTeensy* sim = teensy.get();
+  if (position > 0) {
+    sim->SetPins(1 << kPositionPins[position]);
+  }
+  std::unique_ptr<ReportController> controller;
+  if (platform == "pc") {
+    controller = std::make_unique<PCController>(std::move(teensy));
+  } else if (platform == "switch") {
+    auto nspad = std::make_unique<SimNSPad>(*sim);
+    controller =
+        std::make_unique<NSController>(std::move(teensy), std::move(nspad));
+  } else {
+    fprintf(stderr, "Unsupported platform: %s\n", platform.c_str());
+    return 2;
+  }
+
+  const std::vector<Mismatch> mismatches = Replay(*controller, entries);
+  for (const Mismatch& mismatch : mismatches) {
+    printf("Entry %d at %u us, pins=%04x stick=(%u, %u)\n", mismatch.index,
+           mismatch.entry.micros, mismatch.entry.pins, mismatch.entry.x,
+           mismatch.entry.y);
+    PrintReport("recorded", mismatch.entry.report);
+    PrintReport("replayed", mismatch.replayed);
+  }
+  printf("%zu of %zu entries mismatched\n", mismatches.size(),
+         entries.size());
+  return mismatches.empty() ? 0 : 1;
+}
+
+}  // namespace bench
+}  // namespace hs
+
+int main(int argc, char** argv) {
+  if (argc < 4 || argc > 5) {
+    fprintf(stderr, "Usage: %s EEPROM_IMAGE RECORDING pc|switch [POSITION]\n",
+            argv[0]);
+    return 2;
+  }
+  return hs::bench::Run(argv[1], argv[2], argv[3],
+                        argc == 5 ? atoi(argv[4]) : 0);
+}
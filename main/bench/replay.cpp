@@ -0,0 +1,43 @@
+// Copyright 2024 Hiram Silvey
+
+#include "bench/replay.h"
+
+#include <string.h>
+
+namespace hs {
+namespace bench {
+
+bool ParseRecording(const std::vector<uint8_t>& dump,
+                    std::vector<recorder::Entry>& entries) {
+  if (dump.size() < 4) {
+    return false;
+  }
+  const uint32_t size = static_cast<uint32_t>(dump[0]) << 24 | dump[1] << 16 |
+                        dump[2] << 8 | dump[3];
+  if (dump.size() < 4 + static_cast<size_t>(size) * recorder::kEntrySize) {
+    return false;
+  }
+  entries.clear();
+  for (uint32_t i = 0; i < size; i++) {
+    entries.push_back(
+        recorder::Deserialize(&dump[4 + i * recorder::kEntrySize]));
+  }
+  return true;
+}
+
+std::vector<Mismatch> Replay(ReportController& controller,
+                             const std::vector<recorder::Entry>& entries) {
+  std::vector<Mismatch> mismatches;
+  for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+    const recorder::Entry& entry = entries[i];
+    const OutputReport replayed =
+        controller.Resolve(entry.pins, {entry.x, entry.y}, entry.micros);
+    if (memcmp(&replayed, &entry.report, sizeof(OutputReport)) != 0) {
+      mismatches.push_back({i, entry, replayed});
+    }
+  }
+  return mismatches;
+}
+
+}  // namespace bench
+}  // namespace hs
@@ -0,0 +1,37 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef BENCH_REPLAY_H_
+#define BENCH_REPLAY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "controller.h"
+#include "recorder.h"
+
+namespace hs {
+namespace bench {
+
+// A replayed tick whose report differs from the recorded one.
+struct Mismatch {
+  // Index of the entry in the recording.
+  int index;
+  recorder::Entry entry;
+  OutputReport replayed;
+};
+
+// Parse a recording as sent by the configurator: a 4-byte entry count, then
+// the serialized entries. Returns false if the dump is truncated.
+bool ParseRecording(const std::vector<uint8_t>& dump,
+                    std::vector<recorder::Entry>& entries);
+
+// Feed every recorded tick through the controller, which should have been
+// set up with the profile the recording was made with. A recording which
+// wrapped begins mid-press, so the first few ticks may not match.
+std::vector<Mismatch> Replay(ReportController& controller,
+                             const std::vector<recorder::Entry>& entries);
+
+}  // namespace bench
+}  // namespace hs
+
+#endif  // BENCH_REPLAY_H_
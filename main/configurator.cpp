@@ -3,8 +3,18 @@
 #include "configurator.h"
 
 #include <memory>
+#include <optional>
 
+#include "controller.h"
+#include "decoder.h"
+#include "hal.h"
+#include "hall_joystick.h"
+#include "latency_tracer.h"
 #include "math.h"
+#include "pins.h"
+#include "profile.pb.h"
+#include "profiler.h"
+#include "recorder.h"
 #include "teensy.h"
 #include "util.h"
 
@@ -13,6 +23,44 @@ namespace configurator {
 
 namespace {
 
+// Size of the emulated EEPROM on the Teensy 4.0.
+const int kEEPROMSize = 1080;
+
+// 0-13 are reserved for joystick calibration values, 14-15 hold the encoded
+// profiles length.
+const int kProfilesLenAddr = 14;
+const int kProfilesAddr = 16;
+
+// Block until the requested number of bytes have been read from serial.
+void ReadFromSerial(const Teensy& teensy, uint8_t* bytes, int size) {
+  int read = 0;
+  while (read < size) {
+    if (teensy.SerialAvailable()) {
+      bytes[read++] = teensy.SerialRead();
+    }
+  }
+}
+
+// Longest a whole live push may take before it's dropped, so an aborted
+// transfer can't stall the running controller for more than a few ticks. A
+// push is at most a few USB packets, which arrive well within this.
+const unsigned long kPushTimeoutMillis = 20;
+
+// Same as above, but give up once `deadline_millis` passes. Returns whether
+// every byte was read.
+bool ReadFromSerialWithDeadline(const Teensy& teensy, uint8_t* bytes, int size,
+                                unsigned long deadline_millis) {
+  int read = 0;
+  while (read < size) {
+    if (teensy.SerialAvailable()) {
+      bytes[read++] = teensy.SerialRead();
+    } else if (static_cast<long>(teensy.Millis() - deadline_millis) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void WriteIntToSerial(const Teensy& teensy, int val) {
   uint8_t bytes[4] = {
       static_cast<uint8_t>(val >> 24), static_cast<uint8_t>(val >> 16 & 0xFF),
@@ -101,6 +149,36 @@ void SaveCalibration(const Teensy& teensy) {
   teensy.SerialWrite(0);  // Done.
 }
 
+void PreviewCalibration(TeensyHal& teensy) {
+  // Same layout as the stored calibration, followed by the digital threshold
+  // and the number of samples to stream back.
+  uint8_t bytes[17];
+  ReadFromSerial(teensy, bytes, 17);
+  HallJoystick::Calibration calibration;
+  calibration.neutral_x =
+      bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+  calibration.neutral_y =
+      bytes[4] << 24 | bytes[5] << 16 | bytes[6] << 8 | bytes[7];
+  calibration.range =
+      bytes[8] << 24 | bytes[9] << 16 | bytes[10] << 8 | bytes[11];
+  calibration.angle_ticks = bytes[12] << 8 | bytes[13];
+  const int threshold = bytes[14];
+  const int num_samples = bytes[15] << 8 | bytes[16];
+
+  // Use the standard PC output range, which the configurator plots against.
+  // Drift tracking is off so the preview shows the calibration as sent.
+  HallJoystick joystick(calibration, 0, 1023, threshold);
+  joystick.DisableDriftTracking();
+  for (int i = 0; i < num_samples; i++) {
+    // Wait for a new sensor sample, so each pair streamed back is distinct.
+    while (!joystick.IsSampleDue(teensy)) {
+    }
+    HallJoystick::Coordinates coords = joystick.GetCoordinates(teensy);
+    WriteShortToSerial(teensy, coords.x);
+    WriteShortToSerial(teensy, coords.y);
+  }
+}
+
 void StoreProfiles(const Teensy& teensy) {
   while (teensy.SerialAvailable() < 2) {
   }
@@ -117,13 +195,125 @@ void StoreProfiles(const Teensy& teensy) {
   teensy.SerialWrite(0);  // Done.
 }
 
+bool StoreProfileBody(const Teensy& teensy, int addr, const uint8_t* body) {
+  const int profiles_len = teensy.EEPROMRead(kProfilesLenAddr) << 8 |
+                           teensy.EEPROMRead(kProfilesLenAddr + 1);
+  const int end_addr = kProfilesAddr + profiles_len;
+  const int delta = body[0] - teensy.EEPROMRead(addr);
+  if (end_addr + delta > kEEPROMSize) {
+    return false;
+  }
+
+  // Shift the profiles stored after this one to fit the new body length.
+  const int tail_addr = addr + teensy.EEPROMRead(addr) + 1;
+  if (delta > 0) {
+    for (int i = end_addr - 1; i >= tail_addr; i--) {
+      teensy.EEPROMUpdate(i + delta, teensy.EEPROMRead(i));
+    }
+  } else if (delta < 0) {
+    for (int i = tail_addr; i < end_addr; i++) {
+      teensy.EEPROMUpdate(i + delta, teensy.EEPROMRead(i));
+    }
+  }
+
+  for (int i = 0; i <= body[0]; i++) {
+    teensy.EEPROMUpdate(addr + i, body[i]);
+  }
+  teensy.EEPROMUpdate(kProfilesLenAddr, (profiles_len + delta) >> 8);
+  teensy.EEPROMUpdate(kProfilesLenAddr + 1, (profiles_len + delta) & 0xFF);
+  return true;
+}
+
+void PushProfile(const Teensy& teensy, Controller& controller,
+                 hs_profile_Profile_Platform platform, int position) {
+  uint8_t flags;
+  // Length-prefixed body, laid out the same as in EEPROM.
+  uint8_t body[256];
+  const unsigned long deadline_millis = teensy.Millis() + kPushTimeoutMillis;
+  if (!ReadFromSerialWithDeadline(teensy, &flags, 1, deadline_millis) ||
+      !ReadFromSerialWithDeadline(teensy, body, 1, deadline_millis) ||
+      !ReadFromSerialWithDeadline(teensy, body + 1, body[0], deadline_millis)) {
+    teensy.SerialWrite(1);  // Error.
+    return;
+  }
+  const bool persist = flags & 1;
+
+  const std::optional<hs_profile_Profile_Layout> layout =
+      decoder::Decode(body, body[0] + 1);
+  if (!layout) {
+    teensy.SerialWrite(1);  // Error.
+    return;
+  }
+
+  // Persist before staging, so a rejected push leaves both the running
+  // layout and EEPROM as they were.
+  if (persist) {
+    const int addr = decoder::internal::FindProfile(teensy, platform, position);
+    if (!decoder::internal::IsCurrentFormat(teensy) || addr < 0 ||
+        !StoreProfileBody(teensy, addr, body)) {
+      teensy.SerialWrite(1);  // Error.
+      return;
+    }
+  }
+  controller.StageLayout(*layout);
+  teensy.SerialWrite(0);  // Done.
+}
+
+void SendLatencyStats(const Teensy& teensy, const LatencyTracer& tracer) {
+  for (int pin = 0; pin < pins::kNumPins; pin++) {
+    const LatencyTracer::Stats stats = tracer.GetStats(pin);
+    WriteIntToSerial(teensy, stats.count);
+    WriteIntToSerial(teensy, stats.min);
+    WriteIntToSerial(teensy, stats.mean);
+    WriteIntToSerial(teensy, stats.p99);
+    WriteIntToSerial(teensy, stats.max);
+  }
+}
+
+void SendReportCounters(const Teensy& teensy, const SendCounters& counters) {
+  WriteIntToSerial(teensy, counters.sent);
+  WriteIntToSerial(teensy, counters.suppressed);
+}
+
+void SendNeutralOffset(const Teensy& teensy,
+                       const HallJoystick::Coordinates& offset) {
+  WriteIntToSerial(teensy, offset.x);
+  WriteIntToSerial(teensy, offset.y);
+}
+
+#ifdef HS_PROFILE
+void SendCycleHistograms(const Teensy& teensy) {
+  for (int stage = 0; stage < profiler::kNumStages; stage++) {
+    const profiler::Histogram& histogram =
+        profiler::Get(static_cast<profiler::Stage>(stage));
+    WriteIntToSerial(teensy, histogram.max);
+    for (const uint32_t count : histogram.buckets) {
+      WriteIntToSerial(teensy, count);
+    }
+  }
+  // Each dump covers the ticks since the previous one.
+  profiler::Reset();
+}
+#endif
+
+#ifdef HS_RECORD
+void SendRecording(const Teensy& teensy) {
+  WriteIntToSerial(teensy, recorder::Size());
+  uint8_t bytes[recorder::kEntrySize];
+  for (int i = 0; i < recorder::Size(); i++) {
+    recorder::Serialize(recorder::Get(i), bytes);
+    teensy.SerialWrite(bytes, recorder::kEntrySize);
+  }
+}
+#endif
+
 }  // namespace internal
 
-void Configure(std::unique_ptr<Teensy> teensy) {
+void Configure(std::unique_ptr<TeensyHal> teensy) {
   while (true) {
     if (teensy->SerialAvailable() > 0) {
       uint8_t data = teensy->SerialRead();
-      if (data > 4) {
+      if (data > 5) {
         teensy->SerialWrite(1);  // Error.
         continue;
       }
@@ -144,10 +334,48 @@ void Configure(std::unique_ptr<Teensy> teensy) {
         case 4:
           internal::StoreProfiles(*teensy);
           break;
+        case 5:
+          internal::PreviewCalibration(*teensy);
+          break;
       }
     }
   }
 }
 
+void ServeLive(Teensy& teensy, Controller& controller,
+               hs_profile_Profile_Platform platform, int position) {
+  uint8_t data = teensy.SerialRead();
+  if (data > 5 || (data == 1 && !profiler::kEnabled) ||
+      (data == 3 && !recorder::kEnabled)) {
+    teensy.SerialWrite(1);  // Error.
+    return;
+  }
+  teensy.SerialWrite(0);  // OK.
+  switch (data) {
+    case 0:
+      internal::PushProfile(teensy, controller, platform, position);
+      break;
+#ifdef HS_PROFILE
+    case 1:
+      internal::SendCycleHistograms(teensy);
+      break;
+#endif
+    case 2:
+      internal::SendLatencyStats(teensy, controller.GetLatencyTracer());
+      break;
+#ifdef HS_RECORD
+    case 3:
+      internal::SendRecording(teensy);
+      break;
+#endif
+    case 4:
+      internal::SendReportCounters(teensy, controller.GetSendCounters());
+      break;
+    case 5:
+      internal::SendNeutralOffset(teensy, controller.GetNeutralOffset());
+      break;
+  }
+}
+
 }  // namespace configurator
 }  // namespace hs
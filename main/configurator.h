@@ -5,6 +5,13 @@
 
 #include <memory>
 
+#include "controller.h"
+#include "hal.h"
+#include "hall_joystick.h"
+#include "latency_tracer.h"
+#include "profile.pb.h"
+#include "profiler.h"
+#include "recorder.h"
 #include "teensy.h"
 
 namespace hs {
@@ -15,11 +22,31 @@ void FetchStoredBounds(const Teensy& teensy);
 void FetchJoystickCoords(Teensy& teensy);
 void CalibrateJoystick(Teensy& teensy);
 void SaveCalibration(const Teensy& teensy);
+void PreviewCalibration(TeensyHal& teensy);
 void StoreProfiles(const Teensy& teensy);
+bool StoreProfileBody(const Teensy& teensy, int addr, const uint8_t* body);
+void PushProfile(const Teensy& teensy, Controller& controller,
+                 hs_profile_Profile_Platform platform, int position);
+void SendLatencyStats(const Teensy& teensy, const LatencyTracer& tracer);
+void SendReportCounters(const Teensy& teensy, const SendCounters& counters);
+void SendNeutralOffset(const Teensy& teensy,
+                       const HallJoystick::Coordinates& offset);
+#ifdef HS_PROFILE
+void SendCycleHistograms(const Teensy& teensy);
+#endif
+#ifdef HS_RECORD
+// Send every recorded entry, oldest first, after the entry count.
+void SendRecording(const Teensy& teensy);
+#endif
 
 }  // namespace internal
 
-void Configure(std::unique_ptr<Teensy> teensy);
+void Configure(std::unique_ptr<TeensyHal> teensy);
+
+// Serve a single command received over serial while the controller is
+// running. Expected to be called between ticks.
+void ServeLive(Teensy& teensy, Controller& controller,
+               hs_profile_Profile_Platform platform, int position);
 
 }  // namespace configurator
 }  // namespace hs
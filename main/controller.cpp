@@ -2,17 +2,35 @@
 
 #include "controller.h"
 
+#include <string.h>
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+#include "axis_resolver.h"
+#include "configurator.h"
+#include "debouncer.h"
 #include "decoder.h"
+#include "edge_capture.h"
+#include "hal.h"
+#include "hall_joystick.h"
+#include "latency_tracer.h"
 #include "pins.h"
 #include "profile.pb.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "response_curve.h"
 #include "teensy.h"
 
 namespace hs {
 
 using Layout = ::hs_profile_Profile_Layout;
 using Platform = ::hs_profile_Profile_Platform;
+using Layer = ::hs_profile_Profile_Layer;
 
-Layout FetchProfile(const Teensy& teensy, const Platform& platform) {
+int FetchPosition(const Teensy& teensy) {
   std::pair<int, int> button_to_position[] = {
       std::make_pair(pins::kIndexTop, 1),
       std::make_pair(pins::kMiddleTop, 2),
@@ -26,22 +44,75 @@ Layout FetchProfile(const Teensy& teensy, const Platform& platform) {
       std::make_pair(pins::kMiddleBottom, 10),
       std::make_pair(pins::kRingBottom, 11),
       std::make_pair(pins::kPinkyBottom, 12)};
-  int position = 0;
   for (const auto& element : button_to_position) {
     if (teensy.DigitalReadLow(element.first)) {
-      position = element.second;
-      break;
+      return element.second;
+    }
+  }
+  return 0;
+}
+
+Layout FetchProfile(const Teensy& teensy, const Platform& platform) {
+  return decoder::Decode(teensy, platform, FetchPosition(teensy));
+}
+
+uint16_t ReadPins(const TeensyHal& teensy) {
+  uint16_t pins = 0;
+  for (int pin = 0; pin < pins::kNumPins; pin++) {
+    if (teensy.DigitalReadLow(pin)) {
+      pins |= 1 << pin;
+    }
+  }
+  return pins;
+}
+
+bool IsHitbox(const ButtonPinMapping& mapping) {
+  return !mapping.left_x.empty() || !mapping.left_y.empty();
+}
+
+std::array<AxisResolver, kNumAxes> CompileAxes(
+    const ButtonPinMapping& mapping,
+    const hs_profile_Profile_Layout_AxisPolicies& policies, int neutral,
+    int max) {
+  return {AxisResolver(mapping.left_x, policies.left_x, neutral, max),
+          AxisResolver(mapping.left_y, policies.left_y, neutral, max),
+          AxisResolver(mapping.z_x, policies.right_x, neutral, max),
+          AxisResolver(mapping.z_y, policies.right_y, neutral, max),
+          AxisResolver(mapping.slider_left, policies.slider_left, neutral, max),
+          AxisResolver(mapping.slider_right, policies.slider_right, neutral,
+                       max)};
+}
+
+DebounceConfig CompileDebounce(const Layout& layout) {
+  DebounceConfig config = {};
+  for (pb_size_t i = 0; i < layout.debounce_count; i++) {
+    const hs_profile_Profile_Layout_Debounce& debounce = layout.debounce[i];
+    if (debounce.pin < 0 || debounce.pin >= pins::kNumPins ||
+        debounce.time <= 0) {
+      continue;
     }
+    const uint16_t bit = 1 << debounce.pin;
+    switch (debounce.mode) {
+      case hs_profile_Profile_Layout_DebounceMode_EAGER:
+        config.eager |= bit;
+        break;
+      case hs_profile_Profile_Layout_DebounceMode_DEFERRED:
+        config.deferred |= bit;
+        break;
+      default:
+        continue;
+    }
+    config.micros[debounce.pin] = debounce.time;
   }
-  return decoder::Decode(teensy, platform, position);
+  return config;
 }
 
-int ResolveSOCD(const Teensy& teensy, const std::vector<AnalogButton>& buttons,
+int ResolveSOCD(uint32_t inputs, const AnalogButtons& buttons,
                 int joystick_neutral) {
   int min_value = joystick_neutral;
   int max_value = joystick_neutral;
   for (const auto& button : buttons) {
-    if (teensy.DigitalReadLow(button.pin)) {
+    if (inputs & (1u << button.pin)) {
       if (button.value < min_value) {
         min_value = button.value;
       } else if (button.value > max_value) {
@@ -57,4 +128,465 @@ int ResolveSOCD(const Teensy& teensy, const std::vector<AnalogButton>& buttons,
   return max_value;
 }
 
+ReportController::ReportController(
+    std::unique_ptr<TeensyHal> teensy, Platform platform, int joystick_max,
+    int profile_max, const std::unordered_map<int, int>& action_to_button_id)
+    : teensy_(std::move(teensy)),
+      joystick_max_(joystick_max),
+      hitbox_(false),
+      platform_(platform),
+      profile_max_(profile_max),
+      action_to_button_id_(action_to_button_id),
+      base_mapping_({}),
+      mod_mapping_({}),
+      tap_hold_inputs_(0),
+      timed_(false),
+      now_(0),
+      position_(0),
+      edge_pins_(0),
+      edge_pressed_(0),
+      coords_({}),
+      sof_(kSofMarginMicros),
+      last_frame_index_(0),
+      last_frame_check_(0),
+      last_sent_({}),
+      last_sent_micros_(0),
+      send_counters_({}),
+      layout_staged_(false),
+      staged_hitbox_(false),
+      staged_tap_hold_(0),
+      staged_tap_hold_term_(kDefaultTapHoldTermMicros),
+      staged_timed_(false),
+      staged_debounce_({}) {
+  if (edge_capture::kEnabled) {
+    // Edges from here on are applied on top of the levels at boot.
+    edge_pins_ = ReadPins(*teensy_);
+  }
+  LoadProfile();
+}
+
+int ReportController::ScaleProfileValue(int value) const {
+  if (profile_max_ == joystick_max_) {
+    return value;
+  }
+  // Neutral as HallJoystick computes it for each range.
+  const int profile_neutral = (profile_max_ + 1) / 2;
+  const int neutral = (joystick_max_ + 1) / 2;
+  if (value <= profile_neutral) {
+    return value * neutral / profile_neutral;
+  }
+  return neutral + (value - profile_neutral) * (joystick_max_ - neutral) /
+                       (profile_max_ - profile_neutral);
+}
+
+void ReportController::MapDigitalAction(
+    hs_profile_Profile_Layer_DigitalAction digital, int input,
+    ButtonPinMapping& mapping) {
+  auto button_id = action_to_button_id_.find(digital);
+  if (button_id != action_to_button_id_.end()) {
+    mapping.buttons[input] |= 1 << button_id->second;
+    return;
+  }
+  switch (digital) {
+    case hs_profile_Profile_Layer_DigitalAction_L_STICK_UP:
+      mapping.left_y.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_L_STICK_DOWN:
+      mapping.left_y.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_L_STICK_LEFT:
+      mapping.left_x.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_L_STICK_RIGHT:
+      mapping.left_x.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_R_STICK_UP:
+      mapping.z_y.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_R_STICK_DOWN:
+      mapping.z_y.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_R_STICK_LEFT:
+      mapping.z_x.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_R_STICK_RIGHT:
+      mapping.z_x.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_SLIDER_LEFT_MIN:
+      mapping.slider_left.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_SLIDER_LEFT_MAX:
+      mapping.slider_left.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_SLIDER_RIGHT_MIN:
+      mapping.slider_right.push_back({0, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_SLIDER_RIGHT_MAX:
+      mapping.slider_right.push_back({joystick_max_, input});
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_D_PAD_UP:
+      mapping.dpad_up |= 1u << input;
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN:
+      mapping.dpad_down |= 1u << input;
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT:
+      mapping.dpad_left |= 1u << input;
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_D_PAD_RIGHT:
+      mapping.dpad_right |= 1u << input;
+      break;
+    case hs_profile_Profile_Layer_DigitalAction_MOD:
+      mapping.mod |= 1u << input;
+      break;
+    default:
+      break;
+  }
+}
+
+ButtonPinMapping ReportController::GetButtonPinMapping(const Layer& layer) {
+  ButtonPinMapping mapping = {};
+
+  for (const auto& action_pin : pins::GetActionPins(layer)) {
+    auto action = action_pin.action;
+    int pin = action_pin.pin;
+    if (action.which_action_type ==
+        hs_profile_Profile_Layer_Action_digital_tag) {
+      MapDigitalAction(action.action_type.digital, pin, mapping);
+    } else if (action.which_action_type ==
+               hs_profile_Profile_Layer_Action_tap_hold_tag) {
+      MapDigitalAction(action.action_type.tap_hold.hold, pin, mapping);
+      MapDigitalAction(action.action_type.tap_hold.tap, TapInput(pin),
+                       mapping);
+      mapping.tap_hold |= 1 << pin;
+    } else if (action.which_action_type ==
+               hs_profile_Profile_Layer_Action_turbo_tag) {
+      const auto& turbo = action.action_type.turbo;
+      MapDigitalAction(turbo.action, pin, mapping);
+      mapping.timed.turbo |= 1u << pin;
+      mapping.timed.turbo_half_period_micros[pin] =
+          500000 / (turbo.rate > 0 ? turbo.rate : 1);
+    } else if (action.which_action_type ==
+               hs_profile_Profile_Layer_Action_macro_tag) {
+      mapping.timed.macro |= 1u << pin;
+      mapping.timed.macro_index[pin] = action.action_type.macro;
+    } else {
+      auto analog = action.action_type.analog;
+      int value = ScaleProfileValue(analog.value);
+      switch (analog.id) {
+        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X:
+          mapping.z_x.push_back({value, pin});
+          break;
+        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_Y:
+          mapping.z_y.push_back({value, pin});
+          break;
+        case hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_LEFT:
+          mapping.slider_left.push_back({value, pin});
+          break;
+        case hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_RIGHT:
+          mapping.slider_right.push_back({value, pin});
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  return mapping;
+}
+
+Macros ReportController::CompileMacros(const Layout& layout) {
+  Macros macros;
+  for (pb_size_t i = 0; i < layout.macros_count; i++) {
+    const auto& steps = layout.macros[i];
+    Macro macro;
+    for (pb_size_t j = 0; j < steps.steps_count; j++) {
+      const auto& step = steps.steps[j];
+      MacroStep compiled = {.output = {},
+                            .duration_micros =
+                                static_cast<uint32_t>(step.duration) * 1000};
+      for (pb_size_t k = 0; k < step.actions_count; k++) {
+        auto button_id = action_to_button_id_.find(step.actions[k]);
+        if (button_id != action_to_button_id_.end()) {
+          compiled.output.buttons |= 1 << button_id->second;
+        }
+        switch (step.actions[k]) {
+          case hs_profile_Profile_Layer_DigitalAction_D_PAD_UP:
+            compiled.output.dpad |= 8;
+            break;
+          case hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN:
+            compiled.output.dpad |= 4;
+            break;
+          case hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT:
+            compiled.output.dpad |= 2;
+            break;
+          case hs_profile_Profile_Layer_DigitalAction_D_PAD_RIGHT:
+            compiled.output.dpad |= 1;
+            break;
+          default:
+            break;
+        }
+      }
+      macro.push_back(compiled);
+    }
+    macros.push_back(macro);
+  }
+  return macros;
+}
+
+void ReportController::LoadProfile() {
+  position_ = FetchPosition(*teensy_);
+  StageLayout(decoder::Decode(*teensy_, platform_, position_));
+  SwapStagedLayout();
+}
+
+void ReportController::StageLayout(const Layout& layout) {
+  staged_joystick_.emplace(*teensy_, 0, joystick_max_,
+                           layout.joystick_threshold);
+  if (layout.has_snapback) {
+    staged_joystick_->ConfigureSnapback({.velocity = layout.snapback.velocity,
+                                         .max_overshoot =
+                                             layout.snapback.max_overshoot,
+                                         .window = layout.snapback.window});
+  }
+  if (layout.has_sectors) {
+    staged_joystick_->ConfigureSectors(
+        {.diagonal_width = layout.sectors.diagonal_width,
+         .angle_hysteresis = layout.sectors.angle_hysteresis,
+         .radius_hysteresis = layout.sectors.radius_hysteresis});
+  }
+  if (layout.response_curve_count > 0) {
+    CurvePoint points[std::size(layout.response_curve)];
+    for (pb_size_t i = 0; i < layout.response_curve_count; i++) {
+      points[i] = {.input = layout.response_curve[i].input,
+                   .output = layout.response_curve[i].output};
+    }
+    staged_joystick_->ConfigureResponseCurve(points,
+                                             layout.response_curve_count);
+  }
+  staged_base_mapping_ = GetButtonPinMapping(layout.base);
+  if (layout.has_mod) {
+    staged_mod_mapping_ = GetButtonPinMapping(layout.mod);
+  } else {
+    staged_mod_mapping_ = {};
+  }
+  staged_hitbox_ = IsHitbox(staged_base_mapping_) ||
+                   IsHitbox(staged_mod_mapping_);
+  const int neutral = staged_joystick_->get_neutral();
+  staged_base_axes_ = CompileAxes(staged_base_mapping_, layout.axis_policies,
+                                  neutral, joystick_max_);
+  staged_mod_axes_ = CompileAxes(staged_mod_mapping_, layout.axis_policies,
+                                 neutral, joystick_max_);
+  staged_tap_hold_ = staged_base_mapping_.tap_hold |
+                     staged_mod_mapping_.tap_hold;
+  staged_tap_hold_term_ = layout.tap_hold_term > 0
+                              ? layout.tap_hold_term * 1000
+                              : kDefaultTapHoldTermMicros;
+  staged_timed_ = (staged_base_mapping_.timed.turbo |
+                   staged_base_mapping_.timed.macro |
+                   staged_mod_mapping_.timed.turbo |
+                   staged_mod_mapping_.timed.macro) != 0;
+  staged_macros_ = CompileMacros(layout);
+  staged_debounce_ = CompileDebounce(layout);
+  layout_staged_ = true;
+}
+
+const LatencyTracer& ReportController::GetLatencyTracer() const {
+  return tracer_;
+}
+
+SendCounters ReportController::GetSendCounters() const {
+  return send_counters_;
+}
+
+HallJoystick::Coordinates ReportController::GetNeutralOffset() const {
+  return joystick_ ? joystick_->GetNeutralOffset()
+                   : HallJoystick::Coordinates{};
+}
+
+void ReportController::SwapStagedLayout() {
+  if (joystick_) {
+    staged_joystick_->InheritDrift(*joystick_);
+  }
+  joystick_.emplace(*staged_joystick_);
+  base_mapping_ = std::move(staged_base_mapping_);
+  mod_mapping_ = std::move(staged_mod_mapping_);
+  base_axes_ = staged_base_axes_;
+  mod_axes_ = staged_mod_axes_;
+  hitbox_ = staged_hitbox_;
+  // Base layer pins which hold MOD hold back the other pins while pending.
+  tap_hold_.Configure(staged_tap_hold_, staged_tap_hold_term_,
+                      base_mapping_.tap_hold & base_mapping_.mod);
+  tap_hold_inputs_ = 0;
+  timed_ = staged_timed_;
+  macros_ = staged_macros_;
+  macro_engine_.Reset();
+  debouncer_.Configure(staged_debounce_);
+  layout_staged_ = false;
+}
+
+uint32_t ReportController::GetInputs(uint16_t pins, uint16_t tap_hold) const {
+  const uint32_t outputs =
+      tap_hold | static_cast<uint32_t>(tap_hold) << pins::kNumPins;
+  return (pins & ~tap_hold) | (tap_hold_inputs_ & outputs);
+}
+
+OutputReport ReportController::BuildReport(
+    uint16_t pins, const HallJoystick::Coordinates& coords) {
+  uint32_t inputs = GetInputs(pins, base_mapping_.tap_hold);
+  const bool mod = inputs & base_mapping_.mod;
+  const ButtonPinMapping& mapping = mod ? mod_mapping_ : base_mapping_;
+  std::array<AxisResolver, kNumAxes>& axes = mod ? mod_axes_ : base_axes_;
+  if (mod) {
+    inputs = GetInputs(pins, mod_mapping_.tap_hold);
+  }
+  MacroOutput macro_output = {};
+  if (timed_) {
+    inputs = macro_engine_.Update(inputs, mapping.timed, macros_, now_,
+                                  macro_output);
+  }
+
+  OutputReport report;
+  report.buttons = macro_output.buttons;
+  for (uint32_t rest = inputs; rest != 0; rest &= rest - 1) {
+    report.buttons |= mapping.buttons[__builtin_ctz(rest)];
+  }
+  report.dpad = macro_output.dpad |
+                (inputs & mapping.dpad_up ? 8 : 0) |    // 1000
+                (inputs & mapping.dpad_down ? 4 : 0) |  // 0100
+                (inputs & mapping.dpad_left ? 2 : 0) |  // 0010
+                (inputs & mapping.dpad_right ? 1 : 0);  // 0001
+  if (hitbox_) {
+    report.left_x = axes[kLeftX].Resolve(inputs);
+    report.left_y = axes[kLeftY].Resolve(inputs);
+  } else {
+    report.left_x = coords.x;
+    report.left_y = coords.y;
+  }
+  report.right_x = axes[kRightX].Resolve(inputs);
+  report.right_y = axes[kRightY].Resolve(inputs);
+  report.slider_left = axes[kSliderLeft].Resolve(inputs);
+  report.slider_right = axes[kSliderRight].Resolve(inputs);
+  return report;
+}
+
+OutputReport ReportController::Resolve(
+    uint16_t pins, const HallJoystick::Coordinates& coords, uint32_t now) {
+  now_ = now;
+  if (tap_hold_.IsActive()) {
+    tap_hold_inputs_ = tap_hold_.Update(pins, now);
+    pins = tap_hold_.Filter(pins);
+  }
+  return BuildReport(pins, coords);
+}
+
+void ReportController::Scan() {
+  if (layout_staged_) {
+    SwapStagedLayout();
+  }
+  if (hitbox_) {
+    coords_ = {};
+  } else {
+    profiler::Timer timer(*teensy_, profiler::kSensor);
+    coords_ = joystick_->GetCoordinates(*teensy_);
+  }
+  if (edge_capture::kEnabled) {
+    DrainPinEdges();
+  }
+}
+
+OutputReport ReportController::Poll() {
+  // A staged layout is still swapped in here, so the report never mixes the
+  // old layout's coordinates with the new one's mappings.
+  if (!sof_.IsLocked() || layout_staged_) {
+    Scan();
+  }
+  const HallJoystick::Coordinates coords = coords_;
+
+  profiler::Timer timer(*teensy_, profiler::kButtons);
+  uint16_t pins;
+  if (edge_capture::kEnabled) {
+    DrainPinEdges();
+    // Pins pressed and released since the last snapshot read as held for
+    // this one, so a tap shorter than a tick still reaches the host.
+    pins = edge_pins_ | edge_pressed_;
+    edge_pressed_ = 0;
+  } else {
+    pins = ReadPins(*teensy_);
+  }
+  const uint32_t now = tap_hold_.IsActive() || timed_ ||
+                               debouncer_.IsActive() || recorder::kEnabled
+                           ? teensy_->Micros()
+                           : 0;
+  if (debouncer_.IsActive()) {
+    pins = debouncer_.Update(pins, now);
+  }
+  if (tracer_.HasEdges(pins)) {
+    tracer_.OnSnapshot(pins, teensy_->CycleCount());
+  }
+  const OutputReport report = Resolve(pins, coords, now);
+  recorder::Record(now, pins, coords, report);
+  return report;
+}
+
+void ReportController::DrainPinEdges() {
+  edge_capture::Edge edge;
+  while (teensy_->PopPinEdge(edge)) {
+    if (edge.pin == edge_capture::kOverflowPin) {
+      edge_pins_ = ReadPins(*teensy_);
+      continue;
+    }
+    const uint16_t bit = 1 << edge.pin;
+    if (edge.pressed) {
+      edge_pins_ |= bit;
+      edge_pressed_ |= bit;
+    } else {
+      edge_pins_ &= ~bit;
+    }
+    tracer_.OnEdge(edge.pin, edge.cycles);
+  }
+}
+
+bool ReportController::IsReportDue() {
+  const uint32_t frame_index = teensy_->UsbFrameIndex();
+  const uint32_t now = teensy_->Micros();
+  if (frame_index != last_frame_index_) {
+    last_frame_index_ = frame_index;
+    // When the last tick read the sensor or served serial, the frame may
+    // have started any time during it.
+    sof_.OnSof(last_frame_check_, now);
+  }
+  last_frame_check_ = now;
+  return !sof_.IsLocked() || sof_.IsDue(now);
+}
+
+bool ReportController::ShouldSend(const OutputReport& report) {
+  // The clock is only read while idle, as changed reports are always sent.
+  if (send_counters_.sent > 0 &&
+      memcmp(&report, &last_sent_, sizeof(OutputReport)) == 0 &&
+      teensy_->Micros() - last_sent_micros_ < kKeepAliveMicros) {
+    send_counters_.suppressed++;
+    // Edges which didn't change the report are never sent, so would
+    // otherwise be timed to the next keep-alive.
+    tracer_.Discard();
+    return false;
+  }
+  last_sent_ = report;
+  last_sent_micros_ = teensy_->Micros();
+  send_counters_.sent++;
+  return true;
+}
+
+void ReportController::TraceSend() {
+  if (tracer_.HasPending()) {
+    tracer_.OnSend(teensy_->CycleCount());
+  }
+}
+
+void ReportController::PollSerial() {
+  if (teensy_->SerialAvailable() > 0) {
+    configurator::ServeLive(*teensy_, *this, platform_, position_);
+  }
+}
+
 }  // namespace hs
@@ -3,39 +3,266 @@
 #ifndef CONTROLLER_H_
 #define CONTROLLER_H_
 
+#include <array>
+#include <memory>
+#include <optional>
 #include <unordered_map>
-#include <vector>
 
+#include "axis_resolver.h"
+#include "debouncer.h"
+#include "hal.h"
+#include "hall_joystick.h"
+#include "latency_tracer.h"
+#include "macro_engine.h"
+#include "pins.h"
 #include "profile.pb.h"
+#include "sof_scheduler.h"
+#include "tap_hold.h"
 #include "teensy.h"
+#include "util.h"
 
 namespace hs {
 
-struct AnalogButton {
-  int value;
-  int pin;
+struct ButtonPinMapping {
+  // Platform buttons pressed by each input, as a bitfield indexed by button
+  // ID. See kNumInputs for how inputs relate to pins.
+  uint32_t buttons[kNumInputs];
+  // Input masks for each d-pad direction and the MOD action.
+  uint32_t dpad_up;
+  uint32_t dpad_down;
+  uint32_t dpad_left;
+  uint32_t dpad_right;
+  uint32_t mod;
+  // Pins with a TapHoldAction.
+  uint16_t tap_hold;
+  TimedActions timed;
+  AnalogButtons left_x;
+  AnalogButtons left_y;
+  AnalogButtons z_y;
+  AnalogButtons z_x;
+  AnalogButtons slider_left;
+  AnalogButtons slider_right;
 };
 
-struct ButtonPinMapping {
-  std::unordered_map<int, std::vector<int>> button_id_to_pins;
-  std::vector<int> mod;
+// Everything a controller reports to the host in a single tick, independent
+// of the output platform.
+struct __attribute__((packed)) OutputReport {
+  // Bitfield indexed by platform button ID.
+  uint32_t buttons;
+  // D-pad bits. Bit order: Up, Down, Left, Right
+  uint8_t dpad;
+  // Joystick coordinates, with larger Y values pointing up.
+  uint16_t left_x;
+  uint16_t left_y;
+  uint16_t right_x;
+  uint16_t right_y;
+  uint16_t slider_left;
+  uint16_t slider_right;
+};
+
+// Longest the host goes without a report while the inputs are idle.
+const uint32_t kKeepAliveMicros = 50000;
+
+// Reports sent to the host, and reports skipped because they matched the
+// last one sent.
+struct SendCounters {
+  uint32_t sent;
+  uint32_t suppressed;
 };
 
+// Fetch the profile position selected by the button held at boot.
+int FetchPosition(const Teensy& teensy);
+
 // Fetch the specified profile given the platform.
 hs_profile_Profile_Layout FetchProfile(
     const Teensy& teensy, const hs_profile_Profile_Platform& Platform);
 
+// Snapshot the state of every button pin. Bit N is set while pin N is pressed.
+uint16_t ReadPins(const TeensyHal& teensy);
+
+// Whether the mapping drives the left stick from buttons rather than the hall
+// joystick.
+bool IsHitbox(const ButtonPinMapping& mapping);
+
+// Compile the analog buttons of every axis in the mapping with the layout's
+// combine policies.
+std::array<AxisResolver, kNumAxes> CompileAxes(
+    const ButtonPinMapping& mapping,
+    const hs_profile_Profile_Layout_AxisPolicies& policies, int neutral,
+    int max);
+
+// Compile the debounce settings of the layout. Entries with an unknown pin
+// or mode, or without a time, are skipped.
+DebounceConfig CompileDebounce(const hs_profile_Profile_Layout& layout);
+
 // Resolve simultaneous opposing cardinal directions from button inputs.
-int ResolveSOCD(const Teensy& teensy, const std::vector<AnalogButton>& buttons,
+int ResolveSOCD(uint32_t inputs, const AnalogButtons& buttons,
                 int joystick_neutral);
 
 class Controller {
  public:
+  virtual ~Controller() {}
+
   // Load the controller profile settings based on the button held.
   virtual void LoadProfile() = 0;
 
+  // Compile the provided layout into a shadow mapping, which is swapped in at
+  // the start of the next tick.
+  virtual void StageLayout(const hs_profile_Profile_Layout& layout) = 0;
+
   // Main loop to be run each tick.
   virtual void Loop() = 0;
+
+  virtual const LatencyTracer& GetLatencyTracer() const = 0;
+
+  virtual SendCounters GetSendCounters() const = 0;
+
+  // Drift of the joystick's resting position tracked since boot.
+  virtual HallJoystick::Coordinates GetNeutralOffset() const = 0;
+};
+
+// Controller which resolves its inputs into an OutputReport each tick and
+// leaves only the serialization of that report to the platform. Platforms
+// implement Loop() as SendReport(Poll()) on ticks where IsReportDue() and
+// Scan() on the others, followed by PollSerial(), so that every call made
+// during a tick is resolved at compile time.
+class ReportController : public Controller {
+ public:
+  void LoadProfile() override;
+  void StageLayout(const hs_profile_Profile_Layout& layout) override;
+  const LatencyTracer& GetLatencyTracer() const override;
+  SendCounters GetSendCounters() const override;
+  HallJoystick::Coordinates GetNeutralOffset() const override;
+
+  ButtonPinMapping GetButtonPinMapping(const hs_profile_Profile_Layer& layer);
+
+  // Compile the layout's macros into the report bits of each step.
+  Macros CompileMacros(const hs_profile_Profile_Layout& layout);
+
+  // Fill an output report from the input snapshot. Tap-hold pins resolve to
+  // the outputs of the last Poll(), and turbo and macro actions play against
+  // the clock as of the last Poll().
+  OutputReport BuildReport(uint16_t pins,
+                           const HallJoystick::Coordinates& coords);
+
+  // Advance the timed actions to `now`, then fill an output report from the
+  // input snapshot taken at that time. Replaying the inputs recorded by
+  // Poll() through this reproduces the recorded reports.
+  OutputReport Resolve(uint16_t pins, const HallJoystick::Coordinates& coords,
+                       uint32_t now);
+
+ protected:
+  // Maps each DigitalAction that is a plain button to its platform button ID.
+  // Analog values in the profile range from 0 to `profile_max`, and are
+  // scaled to the joystick range.
+  ReportController(std::unique_ptr<TeensyHal> teensy,
+                   hs_profile_Profile_Platform platform, int joystick_max,
+                   int profile_max,
+                   const std::unordered_map<int, int>& action_to_button_id);
+
+  // Snapshot the inputs into a report. Once locked on to the USB frames,
+  // the slow inputs are left to Scan() on the ticks in between, so only the
+  // button snapshot and the report build fall within the margin before the
+  // host poll.
+  OutputReport Poll();
+
+  // Swap in any staged layout, read the hall sensor if it has a new sample
+  // and apply captured pin edges.
+  void Scan();
+
+  // Whether this tick should build and send a report, given where the next
+  // USB host poll is predicted to fall.
+  bool IsReportDue();
+
+  // Whether the report needs to be sent: it differs from the last report
+  // sent, or the host has heard nothing for kKeepAliveMicros. Counts the
+  // outcome.
+  bool ShouldSend(const OutputReport& report);
+
+  // Record the latency of any input edges carried by the report just sent.
+  void TraceSend();
+
+  // Serve a pending configurator command, if any.
+  void PollSerial();
+
+  std::unique_ptr<TeensyHal> teensy_;
+  std::optional<HallJoystick> joystick_;
+  const int joystick_max_;
+  // Set while the layout drives the left stick from buttons, in which case
+  // the hall sensor is never sampled.
+  bool hitbox_;
+
+ private:
+  const hs_profile_Profile_Platform platform_;
+  const int profile_max_;
+  const std::unordered_map<int, int>& action_to_button_id_;
+  ButtonPinMapping base_mapping_;
+  ButtonPinMapping mod_mapping_;
+  std::array<AxisResolver, kNumAxes> base_axes_;
+  std::array<AxisResolver, kNumAxes> mod_axes_;
+  TapHold tap_hold_;
+  // Tap and hold outputs as of the last pin snapshot.
+  uint32_t tap_hold_inputs_;
+  // Set while the layout has turbo or macro actions.
+  bool timed_;
+  Macros macros_;
+  MacroEngine macro_engine_;
+  Debouncer debouncer_;
+  // Time of the last pin snapshot. Only read while the layout has actions
+  // which depend on it, or while recording.
+  uint32_t now_;
+
+  // Profile position selected at boot.
+  int position_;
+
+  // Pin levels as of the last captured edge, and pins pressed since the last
+  // snapshot. Only tracked while capturing edges.
+  uint16_t edge_pins_;
+  uint16_t edge_pressed_;
+  // Joystick coordinates as of the last Scan().
+  HallJoystick::Coordinates coords_;
+
+  LatencyTracer tracer_;
+
+  SofScheduler sof_;
+  uint32_t last_frame_index_;
+  // When the frame index was last read, which bounds how early a newly seen
+  // frame could have started.
+  uint32_t last_frame_check_;
+
+  OutputReport last_sent_;
+  uint32_t last_sent_micros_;
+  SendCounters send_counters_;
+
+  // Layout compiled off the hot path, waiting to be swapped in.
+  bool layout_staged_;
+  std::optional<HallJoystick> staged_joystick_;
+  bool staged_hitbox_;
+  ButtonPinMapping staged_base_mapping_;
+  ButtonPinMapping staged_mod_mapping_;
+  std::array<AxisResolver, kNumAxes> staged_base_axes_;
+  std::array<AxisResolver, kNumAxes> staged_mod_axes_;
+  uint16_t staged_tap_hold_;
+  uint32_t staged_tap_hold_term_;
+  bool staged_timed_;
+  Macros staged_macros_;
+  DebounceConfig staged_debounce_;
+
+  void SwapStagedLayout();
+
+  // Apply every captured pin edge.
+  void DrainPinEdges();
+
+  // Scale an analog value from the profile range to the joystick range,
+  // keeping neutral at neutral.
+  int ScaleProfileValue(int value) const;
+
+  void MapDigitalAction(hs_profile_Profile_Layer_DigitalAction digital,
+                        int input, ButtonPinMapping& mapping);
+
+  // Inputs given the pin snapshot, with the given tap-hold pins replaced by
+  // their tap and hold outputs.
+  uint32_t GetInputs(uint16_t pins, uint16_t tap_hold) const;
 };
 
 }  // namespace hs
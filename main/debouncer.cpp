@@ -0,0 +1,53 @@
+// Copyright 2024 Hiram Silvey
+
+#include "debouncer.h"
+
+#include "pins.h"
+
+namespace hs {
+
+Debouncer::Debouncer()
+    : config_({}), settled_(false), output_(0), timing_(0), since_{} {}
+
+void Debouncer::Configure(const DebounceConfig& config) {
+  config_ = config;
+  settled_ = false;
+  timing_ = 0;
+}
+
+uint16_t Debouncer::Update(uint16_t pins, uint32_t now) {
+  if (!settled_) {
+    output_ = pins;
+    settled_ = true;
+  }
+
+  uint16_t expired = 0;
+  for (uint16_t rest = timing_; rest != 0; rest &= rest - 1) {
+    const int pin = __builtin_ctz(rest);
+    if (now - since_[pin] >= config_.micros[pin]) {
+      expired |= 1 << pin;
+    }
+  }
+  timing_ &= ~expired;
+
+  const uint16_t changed = pins ^ output_;
+  // Eager pins take a change unless locked out. Deferred pins take a change
+  // once their timer runs out on it.
+  const uint16_t flips = (changed & config_.eager & ~timing_) |
+                         (changed & config_.deferred & expired);
+  // A deferred pin which goes back before its timer runs out starts over.
+  timing_ &= ~(config_.deferred & ~changed);
+  const uint16_t started =
+      (flips & config_.eager) |
+      (changed & config_.deferred & ~timing_ & ~flips);
+  for (uint16_t rest = started; rest != 0; rest &= rest - 1) {
+    since_[__builtin_ctz(rest)] = now;
+  }
+  timing_ |= started;
+
+  const uint16_t passed = ~(config_.eager | config_.deferred);
+  output_ = ((output_ ^ flips) & ~passed) | (pins & passed);
+  return output_;
+}
+
+}  // namespace hs
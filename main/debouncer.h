@@ -0,0 +1,54 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef DEBOUNCER_H_
+#define DEBOUNCER_H_
+
+#include <stdint.h>
+
+#include "pins.h"
+
+namespace hs {
+
+// Debounce mode and time of every pin. Pins in neither mask are passed
+// through untouched.
+struct DebounceConfig {
+  // Pins which report their first edge at once, then ignore changes for
+  // their debounce time.
+  uint16_t eager;
+  // Pins which only report a change once it has held for their debounce
+  // time.
+  uint16_t deferred;
+  uint32_t micros[pins::kNumPins];
+};
+
+// Filters switch chatter out of the pin snapshot. The modes are bitmasks,
+// so every pin is updated at once with a few bitwise operations. Only pins
+// whose timer is running are visited, to stamp or expire it.
+class Debouncer {
+ public:
+  Debouncer();
+
+  // Set the mode and time of every pin. The next snapshot is taken as
+  // settled.
+  void Configure(const DebounceConfig& config);
+
+  // Whether any pin is debounced.
+  bool IsActive() const { return (config_.eager | config_.deferred) != 0; }
+
+  // Filter the pin snapshot taken at `now`. Bit N is set while pin N is
+  // reported pressed.
+  uint16_t Update(uint16_t pins, uint32_t now);
+
+ private:
+  DebounceConfig config_;
+  bool settled_;
+  uint16_t output_;
+  // Pins whose timer is running: locked out eager pins, and deferred pins
+  // waiting out a change.
+  uint16_t timing_;
+  uint32_t since_[pins::kNumPins];
+};
+
+}  // namespace hs
+
+#endif  // DEBOUNCER_H_
@@ -2,11 +2,14 @@
 
 #include "decoder.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
-#include <vector>
+#include <optional>
 
 #include "profile.pb.h"
 #include "teensy.h"
+#include "util.h"
 
 namespace hs {
 namespace decoder {
@@ -17,43 +20,92 @@ using Layout = hs_profile_Profile_Layout;
 using Layer = hs_profile_Profile_Layer;
 using Action = hs_profile_Profile_Layer_Action;
 using AnalogAction_ID = hs_profile_Profile_Layer_AnalogAction_ID;
+using AxisPolicies = hs_profile_Profile_Layout_AxisPolicies;
+using AxisPolicy = hs_profile_Profile_Layout_AxisPolicy;
+using CurvePoint = hs_profile_Profile_Layout_CurvePoint;
+using Debounce = hs_profile_Profile_Layout_Debounce;
+using DebounceMode = hs_profile_Profile_Layout_DebounceMode;
 using DigitalAction = hs_profile_Profile_Layer_DigitalAction;
+using TapHoldAction = hs_profile_Profile_Layer_TapHoldAction;
+using TurboAction = hs_profile_Profile_Layer_TurboAction;
+using Macro = hs_profile_Profile_Layout_Macro;
+using MacroStep = hs_profile_Profile_Layout_Macro_Step;
 
 const int kMinAddr = 14;
+const int kFormatAddr = 16;
 const int kMasks[10] = {
     0b1,      0b11,      0b111,      0b1111,      0b11111,
     0b111111, 0b1111111, 0b11111111, 0b111111111, 0b1111111111,
 };
-const int kLenActionID = 5;
+const int kLenActionID = 6;
+// Encoded action IDs above this value are analog actions, offset by their
+// analog ID. Lower values are reserved for digital actions.
+const int kAnalogActionIDOffset = 32;
+// Encoded action ID of a tap-hold action, followed by the IDs of its tap and
+// hold digital actions.
+const int kTapHoldActionID = kAnalogActionIDOffset;
+// Encoded action IDs of the remaining actions with parameters, counted down
+// from the top so analog IDs can grow. A turbo action is followed by its
+// digital action ID and rate, and a macro action by its macro index.
+const int kTurboActionID = 63;
+const int kMacroActionID = 62;
+const int kLenTurboRate = 8;
+const int kLenMacroIndex = 4;
 const int kLenAnalogActionValue = 10;
+// Set in the joystick threshold byte when an options block follows it. The
+// block is a length byte followed by options, each a tag byte, a length byte
+// and the option data. Options with unknown tags are skipped.
+const uint8_t kOptionsFlag = 0x80;
+enum OptionTag : uint8_t {
+  kAxisPoliciesTag = 1,
+  // Big-endian tap-hold term in milliseconds.
+  kTapHoldTermTag = 2,
+  // Each macro as a step count byte followed by its steps. Each step is an
+  // action count byte, a byte per digital action ID and a big-endian
+  // duration in milliseconds.
+  kMacrosTag = 3,
+  // Each debounced pin as a byte holding the pin in the high nibble and the
+  // mode in the low nibble, followed by a big-endian time in microseconds.
+  kDebounceTag = 4,
+  // Snapback velocity, max overshoot and window, a byte each.
+  kSnapbackTag = 5,
+  // Diagonal width, angle hysteresis and radius hysteresis, a byte each.
+  kSectorsTag = 6,
+  // Each response curve point as an input byte and an output byte.
+  kResponseCurveTag = 7,
+};
+const int kLenAxisPolicy = 4;
 
-namespace internal {
+namespace {
 
-std::vector<PlatformConfig> DecodeHeader(const Teensy& teensy, int addr) {
-  const uint8_t platform_bitmap = teensy.EEPROMRead(addr++);
-  std::vector<PlatformConfig> configs;
-  for (int platform = _hs_profile_Profile_Platform_MIN;
-       platform <= _hs_profile_Profile_Platform_MAX; platform++) {
-    if (platform_bitmap & (1 << (8 - platform))) {
-      PlatformConfig config;
-      config.platform = static_cast<Platform>(platform);
-      if (configs.size() % 2 == 0) {
-        config.position = teensy.EEPROMRead(addr) >> 4;
-      } else {
-        config.position = teensy.EEPROMRead(addr++) & 0xF;
-      }
-      configs.push_back(config);
+// Reads encoded profile bytes out of EEPROM.
+struct EEPROMReader {
+  const Teensy& teensy;
+  uint8_t operator()(int addr) const { return teensy.EEPROMRead(addr); }
+};
+
+// Reads encoded profile bytes out of a RAM buffer of `len` bytes. Reads past
+// it return 0 and set `overrun`.
+struct BufferReader {
+  const uint8_t* buf;
+  int len;
+  bool* overrun;
+  uint8_t operator()(int addr) const {
+    if (addr < 0 || addr >= len) {
+      *overrun = true;
+      return 0;
     }
+    return buf[addr];
   }
-  return configs;
-}
+};
 
-int FetchData(const Teensy& teensy, int remaining, int& addr,
-              uint8_t& curr_byte, int& unread) {
+template <typename Reader>
+int FetchData(const Reader& read, int remaining, int& addr, uint8_t& curr_byte,
+              int& unread) {
   int data = 0;
   while (remaining > 0) {
     if (unread == 0) {
-      curr_byte = teensy.EEPROMRead(addr++);
+      curr_byte = read(addr++);
       unread = 8;
     }
     int offset = unread - remaining;
@@ -69,7 +121,8 @@ int FetchData(const Teensy& teensy, int remaining, int& addr,
   return data;
 }
 
-Layer DecodeLayer(const Teensy& teensy, int& addr) {
+template <typename Reader>
+Layer DecodeLayer(const Reader& read, int& addr) {
   Layer layer;
   Action* actions[16] = {
       &layer.thumb_top,     &layer.thumb_middle,  &layer.thumb_bottom,
@@ -78,15 +131,32 @@ Layer DecodeLayer(const Teensy& teensy, int& addr) {
       &layer.ring_middle,   &layer.ring_bottom,   &layer.pinky_top,
       &layer.pinky_middle,  &layer.pinky_bottom,  &layer.left_outer,
       &layer.left_inner};
-  uint8_t curr_byte = teensy.EEPROMRead(addr++);
+  uint8_t curr_byte = read(addr++);
   int unread = 8;
   for (Action* action : actions) {
-    int button_id = FetchData(teensy, kLenActionID, addr, curr_byte, unread);
-    if (button_id > _hs_profile_Profile_Layer_DigitalAction_MAX) {
-      action->action_type.analog.id = static_cast<AnalogAction_ID>(
-          button_id - _hs_profile_Profile_Layer_DigitalAction_MAX);
+    int button_id = FetchData(read, kLenActionID, addr, curr_byte, unread);
+    if (button_id == kTapHoldActionID) {
+      TapHoldAction& tap_hold = action->action_type.tap_hold;
+      tap_hold.tap = static_cast<DigitalAction>(
+          FetchData(read, kLenActionID, addr, curr_byte, unread));
+      tap_hold.hold = static_cast<DigitalAction>(
+          FetchData(read, kLenActionID, addr, curr_byte, unread));
+      action->which_action_type = hs_profile_Profile_Layer_Action_tap_hold_tag;
+    } else if (button_id == kTurboActionID) {
+      TurboAction& turbo = action->action_type.turbo;
+      turbo.action = static_cast<DigitalAction>(
+          FetchData(read, kLenActionID, addr, curr_byte, unread));
+      turbo.rate = FetchData(read, kLenTurboRate, addr, curr_byte, unread);
+      action->which_action_type = hs_profile_Profile_Layer_Action_turbo_tag;
+    } else if (button_id == kMacroActionID) {
+      action->action_type.macro =
+          FetchData(read, kLenMacroIndex, addr, curr_byte, unread);
+      action->which_action_type = hs_profile_Profile_Layer_Action_macro_tag;
+    } else if (button_id > kAnalogActionIDOffset) {
+      action->action_type.analog.id =
+          static_cast<AnalogAction_ID>(button_id - kAnalogActionIDOffset);
       int button_value =
-          FetchData(teensy, kLenAnalogActionValue, addr, curr_byte, unread);
+          FetchData(read, kLenAnalogActionValue, addr, curr_byte, unread);
       action->action_type.analog.value = button_value;
       action->which_action_type = hs_profile_Profile_Layer_Action_analog_tag;
     } else {
@@ -97,32 +167,203 @@ Layer DecodeLayer(const Teensy& teensy, int& addr) {
   return layer;
 }
 
-Layout DecodeBody(const Teensy& teensy, int& addr) {
-  const int max_addr = addr + teensy.EEPROMRead(addr++) + 1;
+template <typename Reader>
+AxisPolicies DecodeAxisPolicies(const Reader& read, int& addr) {
+  AxisPolicies axis_policies;
+  AxisPolicy* policies[6] = {
+      &axis_policies.left_x,      &axis_policies.left_y,
+      &axis_policies.right_x,     &axis_policies.right_y,
+      &axis_policies.slider_left, &axis_policies.slider_right};
+  uint8_t curr_byte = read(addr++);
+  int unread = 8;
+  for (AxisPolicy* policy : policies) {
+    *policy = static_cast<AxisPolicy>(
+        FetchData(read, kLenAxisPolicy, addr, curr_byte, unread));
+  }
+  return axis_policies;
+}
+
+// Macros and steps past the capacity of the layout are skipped.
+template <typename Reader>
+void DecodeMacros(const Reader& read, int& addr, int end, Layout& layout) {
+  layout.macros_count = 0;
+  while (addr < end) {
+    Macro macro = {};
+    const int num_steps = read(addr++);
+    for (int i = 0; i < num_steps && addr < end; i++) {
+      MacroStep step = {};
+      const int num_actions = read(addr++);
+      for (int j = 0; j < num_actions && addr < end; j++) {
+        const uint8_t action = read(addr++);
+        if (step.actions_count < std::size(step.actions)) {
+          step.actions[step.actions_count++] =
+              static_cast<DigitalAction>(action);
+        }
+      }
+      step.duration = read(addr) << 8 | read(addr + 1);
+      addr += 2;
+      if (macro.steps_count < std::size(macro.steps)) {
+        macro.steps[macro.steps_count++] = step;
+      }
+    }
+    if (layout.macros_count < std::size(layout.macros)) {
+      layout.macros[layout.macros_count++] = macro;
+    }
+  }
+}
+
+// Pins past the capacity of the layout are skipped.
+template <typename Reader>
+void DecodeDebounce(const Reader& read, int& addr, int end, Layout& layout) {
+  layout.debounce_count = 0;
+  while (addr + 2 < end) {
+    Debounce debounce = {};
+    const uint8_t pin_mode = read(addr++);
+    debounce.pin = pin_mode >> 4;
+    debounce.mode = static_cast<DebounceMode>(pin_mode & 0xF);
+    debounce.time = read(addr) << 8 | read(addr + 1);
+    addr += 2;
+    if (layout.debounce_count < std::size(layout.debounce)) {
+      layout.debounce[layout.debounce_count++] = debounce;
+    }
+  }
+}
+
+// Points past the capacity of the layout are skipped.
+template <typename Reader>
+void DecodeResponseCurve(const Reader& read, int& addr, int end,
+                         Layout& layout) {
+  layout.response_curve_count = 0;
+  while (addr + 1 < end) {
+    CurvePoint point = {};
+    point.input = read(addr);
+    point.output = read(addr + 1);
+    addr += 2;
+    if (layout.response_curve_count < std::size(layout.response_curve)) {
+      layout.response_curve[layout.response_curve_count++] = point;
+    }
+  }
+}
+
+// Options never run past the end of the body at `max_addr`, whatever their
+// lengths claim.
+template <typename Reader>
+void DecodeOptions(const Reader& read, int& addr, int max_addr,
+                   Layout& layout) {
+  const int len = read(addr++);
+  const int end = std::min(addr + len, max_addr);
+  while (addr < end) {
+    const uint8_t tag = read(addr++);
+    const uint8_t option_len = read(addr++);
+    const int next = std::min(addr + option_len, end);
+    switch (tag) {
+      case kAxisPoliciesTag:
+        layout.has_axis_policies = true;
+        layout.axis_policies = DecodeAxisPolicies(read, addr);
+        break;
+      case kTapHoldTermTag:
+        layout.tap_hold_term = read(addr) << 8 | read(addr + 1);
+        break;
+      case kMacrosTag:
+        DecodeMacros(read, addr, next, layout);
+        break;
+      case kDebounceTag:
+        DecodeDebounce(read, addr, next, layout);
+        break;
+      case kSnapbackTag:
+        layout.has_snapback = true;
+        layout.snapback.velocity = read(addr);
+        layout.snapback.max_overshoot = read(addr + 1);
+        layout.snapback.window = read(addr + 2);
+        break;
+      case kSectorsTag:
+        layout.has_sectors = true;
+        layout.sectors.diagonal_width = read(addr);
+        layout.sectors.angle_hysteresis = read(addr + 1);
+        layout.sectors.radius_hysteresis = read(addr + 2);
+        break;
+      case kResponseCurveTag:
+        DecodeResponseCurve(read, addr, next, layout);
+        break;
+      default:
+        break;
+    }
+    addr = next;
+  }
+  addr = end;
+}
+
+template <typename Reader>
+Layout DecodeBody(const Reader& read, int& addr) {
+  const int len = read(addr++);
+  const int max_addr = addr + len;
 
-  Layout layout;
-  layout.joystick_threshold = teensy.EEPROMRead(addr++);
-  layout.base = DecodeLayer(teensy, addr);
+  Layout layout = {};
+  const uint8_t threshold = read(addr++);
+  layout.joystick_threshold = threshold & ~kOptionsFlag;
+  if (threshold & kOptionsFlag) {
+    DecodeOptions(read, addr, max_addr, layout);
+  }
+  layout.base = DecodeLayer(read, addr);
   if (addr < max_addr) {
     layout.has_mod = true;
-    layout.mod = DecodeLayer(teensy, addr);
+    layout.mod = DecodeLayer(read, addr);
   } else {
     layout.has_mod = false;
   }
   return layout;
 }
 
-}  // namespace internal
+}  // namespace
 
-Layout Decode(const Teensy& teensy, Platform platform, int position) {
+namespace internal {
+
+bool IsCurrentFormat(const Teensy& teensy) {
+  return teensy.EEPROMRead(kFormatAddr) == kFormatVersion;
+}
+
+PlatformConfigs DecodeHeader(const Teensy& teensy, int addr) {
+  const uint8_t platform_bitmap = teensy.EEPROMRead(addr++);
+  PlatformConfigs configs;
+  for (int platform = _hs_profile_Profile_Platform_MIN;
+       platform <= _hs_profile_Profile_Platform_MAX; platform++) {
+    if (platform_bitmap & (1 << (8 - platform))) {
+      PlatformConfig config;
+      config.platform = static_cast<Platform>(platform);
+      if (configs.size() % 2 == 0) {
+        config.position = teensy.EEPROMRead(addr) >> 4;
+      } else {
+        config.position = teensy.EEPROMRead(addr++) & 0xF;
+      }
+      configs.push_back(config);
+    }
+  }
+  return configs;
+}
+
+int FetchData(const Teensy& teensy, int remaining, int& addr,
+              uint8_t& curr_byte, int& unread) {
+  return decoder::FetchData(EEPROMReader{teensy}, remaining, addr, curr_byte,
+                            unread);
+}
+
+Layer DecodeLayer(const Teensy& teensy, int& addr) {
+  return decoder::DecodeLayer(EEPROMReader{teensy}, addr);
+}
+
+Layout DecodeBody(const Teensy& teensy, int& addr) {
+  return decoder::DecodeBody(EEPROMReader{teensy}, addr);
+}
+
+int FindProfile(const Teensy& teensy, Platform platform, int position) {
   int curr_addr = kMinAddr;
-  const int encoded_len =
-      (teensy.EEPROMRead(curr_addr++) << 8) | teensy.EEPROMRead(curr_addr++);
+  const int len_high = teensy.EEPROMRead(curr_addr++);
+  const int encoded_len = len_high << 8 | teensy.EEPROMRead(curr_addr++);
   const int max_addr = kMinAddr + encoded_len + 1;
+  curr_addr++;  // Skip the format version.
 
   while (curr_addr < max_addr) {
-    std::vector<PlatformConfig> configs =
-        internal::DecodeHeader(teensy, curr_addr);
+    const PlatformConfigs configs = DecodeHeader(teensy, curr_addr);
     // Advance past the header.
     curr_addr += configs.size() / 2 + configs.size() % 2 + 1;
     if ([&] {
@@ -133,17 +374,40 @@ Layout Decode(const Teensy& teensy, Platform platform, int position) {
           }
           return false;
         }()) {
-      break;
+      return curr_addr;
     }
     // Advance to the header of the next profile.
-    curr_addr += teensy.EEPROMRead(curr_addr++);
+    const int body_len = teensy.EEPROMRead(curr_addr++);
+    curr_addr += body_len;
   }
+  return -1;
+}
+
+}  // namespace internal
 
-  if (curr_addr >= max_addr) {
+Layout Decode(const Teensy& teensy, Platform platform, int position) {
+  if (!internal::IsCurrentFormat(teensy)) {
+    return {};
+  }
+  int addr = internal::FindProfile(teensy, platform, position);
+  if (addr < 0) {
     teensy.Exit(1);
+    return {};
   }
+  return internal::DecodeBody(teensy, addr);
+}
 
-  return internal::DecodeBody(teensy, curr_addr);
+std::optional<Layout> Decode(const uint8_t* body, int len) {
+  bool overrun = len < 1;
+  // Nothing past the length prefix belongs to the body.
+  const int body_len = overrun ? 0 : std::min(len, body[0] + 1);
+  int addr = 0;
+  const Layout layout =
+      DecodeBody(BufferReader{body, body_len, &overrun}, addr);
+  if (overrun) {
+    return std::nullopt;
+  }
+  return layout;
 }
 
 }  // namespace decoder
@@ -3,29 +3,54 @@
 #ifndef DECODER_H_
 #define DECODER_H_
 
-#include <vector>
+#include <optional>
 
 #include "profile.pb.h"
 #include "teensy.h"
+#include "util.h"
 
 namespace hs {
 namespace decoder {
 
+// Format of the stored profiles, written by the configurator as the first
+// byte after their length. Bump it whenever the encoding changes, so profiles
+// stored in an older format are rejected rather than misread. Images from
+// before the version was added hold a profile header in its place, whose
+// platform bits never equal it.
+const uint8_t kFormatVersion = 1;
+
+// A profile header holds one bit per platform.
+using PlatformConfigs = util::FixedVector<hs_profile_Profile_PlatformConfig, 8>;
+
 namespace internal {
 
-std::vector<hs_profile_Profile_PlatformConfig> DecodeHeader(
-    const Teensy& teensy, int addr);
+// Whether the stored profiles are in kFormatVersion.
+bool IsCurrentFormat(const Teensy& teensy);
+PlatformConfigs DecodeHeader(const Teensy& teensy, int addr);
 int FetchData(const Teensy& teensy, int remaining, int& addr,
               uint8_t& curr_byte, int& unread);
 hs_profile_Profile_Layer DecodeLayer(const Teensy& teensy, int& addr);
 hs_profile_Profile_Layout DecodeBody(const Teensy& teensy, int& addr);
 
+// Return the EEPROM address of the body of the profile stored for the given
+// platform and position, or -1 if there is no such profile.
+int FindProfile(const Teensy& teensy, hs_profile_Profile_Platform platform,
+                int position);
+
 }  // namespace internal
 
+// Decode the profile stored for the given platform and position. If the
+// stored profiles are in another format, returns an empty layout instead, so
+// the controller still runs and can be reflashed or sent a layout.
 hs_profile_Profile_Layout Decode(const Teensy& teensy,
                                  hs_profile_Profile_Platform Platform,
                                  int position);
 
+// Decode a length-prefixed profile body of `len` bytes held in RAM, laid out
+// exactly as it would be in EEPROM. Returns nothing if decoding would read
+// past the end of the buffer or of the body.
+std::optional<hs_profile_Profile_Layout> Decode(const uint8_t* body, int len);
+
 }  // namespace decoder
 }  // namespace hs
 
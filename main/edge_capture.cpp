@@ -0,0 +1,53 @@
+// Copyright 2024 Hiram Silvey
+
+#include "edge_capture.h"
+
+namespace hs {
+namespace edge_capture {
+
+#ifdef HS_EDGE_CAPTURE
+
+namespace {
+
+EdgeRing pin_edges;
+
+}  // namespace
+
+#endif  // HS_EDGE_CAPTURE
+
+EdgeRing::EdgeRing() : edges_{}, head_(0), tail_(0), overflowed_(false) {}
+
+void EdgeRing::Push(const Edge& edge) {
+  const uint32_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) == kCapacity) {
+    overflowed_.store(true, std::memory_order_relaxed);
+    return;
+  }
+  edges_[head % kCapacity] = edge;
+  // Publish the edge only once it is fully written.
+  head_.store(head + 1, std::memory_order_release);
+}
+
+bool EdgeRing::Pop(Edge& edge) {
+  const uint32_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail == head_.load(std::memory_order_acquire)) {
+    if (!overflowed_.exchange(false, std::memory_order_relaxed)) {
+      return false;
+    }
+    edge = {.micros = 0, .cycles = 0, .pin = kOverflowPin, .pressed = false};
+    return true;
+  }
+  edge = edges_[tail % kCapacity];
+  // Free the slot only once the edge is copied out.
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+#ifdef HS_EDGE_CAPTURE
+
+EdgeRing& PinEdges() { return pin_edges; }
+
+#endif  // HS_EDGE_CAPTURE
+
+}  // namespace edge_capture
+}  // namespace hs
@@ -0,0 +1,72 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef EDGE_CAPTURE_H_
+#define EDGE_CAPTURE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Uncomment to capture button edges from pin-change interrupts, so presses
+// shorter than a tick are still reported and the latency tracer measures from
+// the exact edge. Left undefined, pins are only sampled once per tick.
+// #define HS_EDGE_CAPTURE
+
+namespace hs {
+namespace edge_capture {
+
+// Edges held between drains. A power of two, so the free-running indices
+// wrap cleanly. Covers a full report interval of switch bounce on every pin.
+const uint32_t kCapacity = 256;
+
+// Pin of the marker popped once the ring drains after edges were dropped.
+// The pin levels must be resampled, as some edges were never seen.
+const uint8_t kOverflowPin = 0xFF;
+
+// A button pin changing level.
+struct Edge {
+  uint32_t micros;
+  uint32_t cycles;
+  uint8_t pin;
+  bool pressed;
+};
+
+// Lock-free single-producer, single-consumer ring. The pin-change interrupts
+// push and the main loop pops. Every button interrupt runs at the same
+// priority, so they never preempt one another and act as a single producer.
+class EdgeRing {
+ public:
+  EdgeRing();
+
+  // Producer. Drops the edge and flags an overflow if the ring is full.
+  void Push(const Edge& edge);
+
+  // Consumer. Pops the oldest edge, or the overflow marker once the ring is
+  // empty after edges were dropped. Returns false if there is nothing to pop.
+  bool Pop(Edge& edge);
+
+ private:
+  Edge edges_[kCapacity];
+  // Free-running counts of edges pushed and popped.
+  std::atomic<uint32_t> head_;
+  std::atomic<uint32_t> tail_;
+  std::atomic<bool> overflowed_;
+};
+
+#ifdef HS_EDGE_CAPTURE
+
+const bool kEnabled = true;
+
+// Ring filled by the button pin interrupts.
+EdgeRing& PinEdges();
+
+#else
+
+const bool kEnabled = false;
+
+#endif  // HS_EDGE_CAPTURE
+
+}  // namespace edge_capture
+}  // namespace hs
+
+#endif  // EDGE_CAPTURE_H_
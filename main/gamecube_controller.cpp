@@ -0,0 +1,141 @@
+// Copyright 2024 Hiram Silvey
+
+#include "gamecube_controller.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include "controller.h"
+#include "hal.h"
+#include "joybus.h"
+#include "profile.pb.h"
+#include "profiler.h"
+#include "teensy.h"
+
+namespace hs {
+
+namespace {
+
+// Joystick output range. Shares the PC scale so profiles written for Dolphin
+// carry over, and is narrowed to 8 bits when packed.
+const int kJoystickMax = 1023;
+
+// Button IDs are bit positions within the first two report bytes, read as a
+// big-endian 16-bit word.
+const int kButtonA = 8;
+const int kButtonB = 9;
+const int kButtonX = 10;
+const int kButtonY = 11;
+const int kButtonStart = 12;
+const int kButtonZ = 4;
+const int kButtonR = 5;
+const int kButtonL = 6;
+
+// Always set in the second report byte.
+const uint8_t kReportAlwaysSet = 0x80;
+
+const std::unordered_map<int, int> kActionToButtonId = {
+    {hs_profile_Profile_Layer_DigitalAction_X, kButtonA},
+    {hs_profile_Profile_Layer_DigitalAction_CIRCLE, kButtonB},
+    {hs_profile_Profile_Layer_DigitalAction_SQUARE, kButtonX},
+    {hs_profile_Profile_Layer_DigitalAction_TRIANGLE, kButtonY},
+    {hs_profile_Profile_Layer_DigitalAction_OPTIONS, kButtonStart},
+    {hs_profile_Profile_Layer_DigitalAction_R1, kButtonZ},
+    {hs_profile_Profile_Layer_DigitalAction_R2, kButtonR},
+    {hs_profile_Profile_Layer_DigitalAction_L2, kButtonL}};
+
+// DPad report bits with neutral SOCD.
+const uint8_t kDPadBits[16] = {
+    // Bit order: Up, Down, Left, Right
+    0b0000,  // 0000 None
+    0b0010,  // 0001 Right
+    0b0001,  // 0010 Left
+    0b0000,  // 0011 Left + Right cancel
+    0b0100,  // 0100 Down
+    0b0110,  // 0101 Down + Right
+    0b0101,  // 0110 Down + Left
+    0b0100,  // 0111 Down; Left + Right cancel
+    0b1000,  // 1000 Up
+    0b1010,  // 1001 Up + Right
+    0b1001,  // 1010 Up + Left
+    0b1000,  // 1011 Up; Left + Right cancel
+    0b0000,  // 1100 Up + Down cancel
+    0b0010,  // 1101 Right; Up + Down cancel
+    0b0001,  // 1110 Left; Up + Down cancel
+    0b0000,  // 1111 Up + Down cancel; Left + Right cancel
+};
+
+uint8_t PackAxis(int val) { return val >> 2; }
+
+// Triggers rest at 0, so only the half of the slider range above neutral is
+// used.
+uint8_t PackTrigger(int val, int neutral) {
+  if (val <= neutral) {
+    return 0;
+  }
+  return (val - neutral) * 255 / (kJoystickMax - neutral);
+}
+
+}  // namespace
+
+GameCubeController::GameCubeController(std::unique_ptr<TeensyHal> teensy)
+    : ReportController(std::move(teensy), hs_profile_Profile_Platform_GAMECUBE,
+                       kJoystickMax, kJoystickMax, kActionToButtonId),
+      reports_{},
+      active_report_(0) {
+  const uint16_t neutral = joystick_->get_neutral();
+  OutputReport report = {};
+  report.left_x = neutral;
+  report.left_y = neutral;
+  report.right_x = neutral;
+  report.right_y = neutral;
+  SendReport(report);
+}
+
+uint8_t GameCubeController::GetDPadBits(uint8_t dpad) {
+  return kDPadBits[dpad & 15];
+}
+
+void GameCubeController::SendReport(const OutputReport& report) {
+  const int neutral = joystick_->get_neutral();
+  // Only the main loop writes the index, so its own read needs no ordering.
+  const uint8_t next = active_report_.load(std::memory_order_relaxed) ^ 1;
+  uint8_t* packed = reports_[next];
+  packed[0] = report.buttons >> 8;
+  packed[1] = kReportAlwaysSet | (report.buttons & 0x70) |
+              GetDPadBits(report.dpad);
+  packed[2] = PackAxis(report.left_x);
+  packed[3] = PackAxis(report.left_y);
+  packed[4] = PackAxis(report.right_x);
+  packed[5] = PackAxis(report.right_y);
+  packed[6] = PackTrigger(report.slider_right, neutral);
+  packed[7] = PackTrigger(report.slider_left, neutral);
+  active_report_.store(next, std::memory_order_release);
+}
+
+void GameCubeController::Loop() {
+  {
+    profiler::Timer tick_timer(*teensy_, profiler::kTick);
+    const OutputReport report = Poll();
+    profiler::Timer send_timer(*teensy_, profiler::kSend);
+    SendReport(report);
+    TraceSend();
+  }
+  PollSerial();
+}
+
+void GameCubeController::ServeConsole() {
+  uint8_t command[joybus::kMaxCommandSize];
+  const int size = teensy_->JoybusReceive(command, joybus::kMaxCommandSize);
+  uint8_t response[joybus::kMaxResponseSize];
+  const int response_size =
+      joybus::Respond(command, size,
+                      reports_[active_report_.load(std::memory_order_acquire)],
+                      response);
+  if (response_size > 0) {
+    teensy_->JoybusSend(response, response_size);
+  }
+}
+
+}  // namespace hs
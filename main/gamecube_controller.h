@@ -0,0 +1,39 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef GAMECUBE_CONTROLLER_H_
+#define GAMECUBE_CONTROLLER_H_
+
+#include <atomic>
+#include <memory>
+
+#include "controller.h"
+#include "hal.h"
+#include "joybus.h"
+#include "teensy.h"
+
+namespace hs {
+
+class GameCubeController final : public ReportController {
+ public:
+  GameCubeController(std::unique_ptr<TeensyHal> teensy);
+  uint8_t GetDPadBits(uint8_t dpad);
+
+  // Pack the report into the buffer the console is answered from.
+  void SendReport(const OutputReport& report);
+  void Loop() override;
+
+  // Answer a single console command. Expected to be called from the Joybus
+  // line's falling edge interrupt.
+  void ServeConsole();
+
+ private:
+  // Double-buffered so the interrupt always reads a complete report while
+  // the main loop packs the next one. The index is published with release
+  // ordering, so the interrupt never sees it before the packed bytes.
+  uint8_t reports_[2][joybus::kReportSize];
+  std::atomic<uint8_t> active_report_;
+};
+
+}  // namespace hs
+
+#endif  // GAMECUBE_CONTROLLER_H_
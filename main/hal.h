@@ -0,0 +1,30 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include "nspad.h"
+#include "teensy.h"
+
+#ifdef ARDUINO
+#include "nspad_impl.h"
+#include "teensy_impl.h"
+#endif
+
+namespace hs {
+
+// Hardware types used on the hot path. Firmware builds bind these to the
+// final implementations so calls through them are resolved at compile time
+// and inlined, while host builds keep the abstract interfaces so tests can
+// inject mocks.
+#ifdef ARDUINO
+using TeensyHal = TeensyImpl;
+using NSPadHal = NSPadImpl;
+#else
+using TeensyHal = Teensy;
+using NSPadHal = NSPad;
+#endif
+
+}  // namespace hs
+
+#endif  // HAL_H_
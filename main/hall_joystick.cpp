@@ -2,31 +2,64 @@
 
 #include "hall_joystick.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
 #include <memory>
 
+#include "hal.h"
 #include "math.h"
 #include "teensy.h"
 #include "util.h"
 
 namespace hs {
 
+namespace {
+
+// Shortest interval between sensor reads.
+const unsigned long kSampleMicros = 330;
+
+HallJoystick::Calibration FetchCalibration(const Teensy& teensy) {
+  HallJoystick::Calibration calibration;
+  calibration.neutral_x = util::GetIntFromEEPROM(teensy, 0);
+  calibration.neutral_y = util::GetIntFromEEPROM(teensy, 4);
+  calibration.range = util::GetIntFromEEPROM(teensy, 8);
+  calibration.angle_ticks = util::GetShortFromEEPROM(teensy, 12);
+  return calibration;
+}
+
+}  // namespace
+
 HallJoystick::HallJoystick(const Teensy& teensy, int min, int max,
 			   int threshold)
-    : out_({.min = min, .max = max}),
+    : HallJoystick(FetchCalibration(teensy), min, max, threshold) {}
+
+HallJoystick::HallJoystick(const Calibration& calibration, int min, int max,
+			   int threshold)
+    : neutral_({.x = calibration.neutral_x, .y = calibration.neutral_y}),
+      drift_band_(calibration.range >> 4),
+      drift_motion_(calibration.range >> 6),
+      drift_max_step_(std::max(1, calibration.range >> 8)),
+      drift_max_((calibration.range >> 3) << kDriftFracBits),
+      drift_x_(0),
+      drift_y_(0),
+      last_sample_({.x = calibration.neutral_x, .y = calibration.neutral_y}),
+      still_samples_(0),
+      track_drift_(true),
+      out_({.min = min, .max = max}),
       out_neutral_((max - min + 1) / 2 + min),
       threshold_({threshold * -1, threshold}),
       last_fetch_micros_(0) {
-  int neutral_x = util::GetIntFromEEPROM(teensy, 0);
-  int neutral_y = util::GetIntFromEEPROM(teensy, 4);
-  int range = util::GetIntFromEEPROM(teensy, 8);
-  x_in_ = {.min = neutral_x - range, .max = neutral_x + range};
-  y_in_ = {.min = neutral_y - range, .max = neutral_y + range};
-  int16_t angle_ticks = util::GetShortFromEEPROM(teensy, 12);
-  angle_ = (M_PI * angle_ticks) / 2000.0;
+  const int range = calibration.range;
+  x_in_ = {.min = calibration.neutral_x - range,
+           .max = calibration.neutral_x + range};
+  y_in_ = {.min = calibration.neutral_y - range,
+           .max = calibration.neutral_y + range};
+  angle_ = (M_PI * calibration.angle_ticks) / 2000.0;
   curr_coords_ = {out_neutral_, out_neutral_};
 }
 
-int HallJoystick::Normalize(const Teensy& teensy, double val,
+int HallJoystick::Normalize(const TeensyHal& teensy, double val,
 			    const Bounds& in) {
   int mapped =
       round(static_cast<double>(val - in.min) /
@@ -47,8 +80,12 @@ int HallJoystick::ResolveDigitalCoord(int coord) {
   return out_neutral_;
 }
 
-HallJoystick::Coordinates HallJoystick::GetCoordinates(Teensy& teensy) {
-  if (teensy.Micros() - last_fetch_micros_ < 330) {
+bool HallJoystick::IsSampleDue(const TeensyHal& teensy) const {
+  return teensy.Micros() - last_fetch_micros_ >= kSampleMicros;
+}
+
+HallJoystick::Coordinates HallJoystick::GetCoordinates(TeensyHal& teensy) {
+  if (!IsSampleDue(teensy)) {
     return curr_coords_;
   }
 
@@ -64,12 +101,34 @@ HallJoystick::Coordinates HallJoystick::GetCoordinates(Teensy& teensy) {
   double rotated_x = x * cos(angle_) + y * sin(angle_);
   double rotated_y = -x * sin(angle_) + y * cos(angle_);
 
+  rotated_x -= drift_x_ >> kDriftFracBits;
+  rotated_y -= drift_y_ >> kDriftFracBits;
+  if (track_drift_) {
+    TrackNeutral(static_cast<int>(rotated_x), static_cast<int>(rotated_y));
+  }
+
   x = Normalize(teensy, rotated_x, x_in_);
   y = Normalize(teensy, rotated_y, y_in_);
+  if (snapback_x_.IsActive()) {
+    x = out_neutral_ + snapback_x_.Update(x - out_neutral_, last_fetch_micros_);
+    y = out_neutral_ + snapback_y_.Update(y - out_neutral_, last_fetch_micros_);
+  }
 
-  if (threshold_.first < 0) {
+  if (sectors_.IsActive()) {
+    // ANGULAR DIGITAL
+    const SectorResolver::Direction direction =
+        sectors_.Update(x - out_neutral_, y - out_neutral_);
+    curr_coords_ = {ToDigitalCoord(direction.x), ToDigitalCoord(direction.y)};
+  } else if (threshold_.first < 0) {
     // DIGITAL
     curr_coords_ = {ResolveDigitalCoord(x), ResolveDigitalCoord(y)};
+  } else if (curve_.IsActive()) {
+    // ANALOG, CURVED
+    curr_coords_ = {
+        std::clamp(out_neutral_ + curve_.Apply(x - out_neutral_), out_.min,
+                   out_.max),
+        std::clamp(out_neutral_ + curve_.Apply(y - out_neutral_), out_.min,
+                   out_.max)};
   } else {
     // ANALOG
     curr_coords_ = {x, y};
@@ -77,6 +136,65 @@ HallJoystick::Coordinates HallJoystick::GetCoordinates(Teensy& teensy) {
   return curr_coords_;
 }
 
+void HallJoystick::TrackNeutral(int x, int y) {
+  const int dx = x - neutral_.x;
+  const int dy = y - neutral_.y;
+  const bool resting =
+      abs(dx) <= drift_band_ && abs(dy) <= drift_band_ &&
+      abs(x - last_sample_.x) <= drift_motion_ &&
+      abs(y - last_sample_.y) <= drift_motion_;
+  last_sample_ = {x, y};
+  if (!resting) {
+    still_samples_ = 0;
+    return;
+  }
+  if (still_samples_ < kDriftSettleSamples) {
+    still_samples_++;
+    return;
+  }
+  // Divided rather than shifted, so the step rounds toward zero from both
+  // sides. Folds away while kDriftShift == kDriftFracBits.
+  const int step_x = dx * (1 << kDriftFracBits) / (1 << kDriftShift);
+  const int step_y = dy * (1 << kDriftFracBits) / (1 << kDriftShift);
+  drift_x_ = std::clamp(
+      drift_x_ + std::clamp(step_x, -drift_max_step_, drift_max_step_),
+      -drift_max_, drift_max_);
+  drift_y_ = std::clamp(
+      drift_y_ + std::clamp(step_y, -drift_max_step_, drift_max_step_),
+      -drift_max_, drift_max_);
+}
+
+HallJoystick::Coordinates HallJoystick::GetNeutralOffset() const {
+  return {drift_x_ >> kDriftFracBits, drift_y_ >> kDriftFracBits};
+}
+
+void HallJoystick::InheritDrift(const HallJoystick& other) {
+  drift_x_ = other.drift_x_;
+  drift_y_ = other.drift_y_;
+  last_sample_ = other.last_sample_;
+  still_samples_ = other.still_samples_;
+}
+
+void HallJoystick::ConfigureSnapback(const SnapbackConfig& config) {
+  snapback_x_.Configure(config, out_.max - out_neutral_);
+  snapback_y_.Configure(config, out_.max - out_neutral_);
+}
+
+void HallJoystick::ConfigureSectors(const SectorConfig& config) {
+  if (threshold_.first < 0) {
+    sectors_.Configure(config, out_neutral_ - out_.min, threshold_.second);
+  }
+}
+
+void HallJoystick::ConfigureResponseCurve(const CurvePoint* points,
+                                          int count) {
+  curve_.Configure(points, count, out_neutral_ - out_.min);
+}
+
+int HallJoystick::ToDigitalCoord(int direction) {
+  return direction < 0 ? out_.min : direction > 0 ? out_.max : out_neutral_;
+}
+
 int HallJoystick::get_min() { return out_.min; }
 
 int HallJoystick::get_max() { return out_.max; }
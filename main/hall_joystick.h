@@ -5,16 +5,48 @@
 
 #include <memory>
 
+#include "hal.h"
+#include "response_curve.h"
+#include "sector_resolver.h"
+#include "snapback_filter.h"
 #include "teensy.h"
 
 namespace hs {
 
+// Consecutive sensor samples the stick must rest near neutral before its
+// center is tracked. About a second at the sensor's read rate.
+const int kDriftSettleSamples = 3000;
+// Fractional bits of the tracked neutral offset.
+const int kDriftFracBits = 12;
+// Each sample, the tracked offset closes 1/2^kDriftShift of the gap to the
+// resting position.
+const int kDriftShift = 12;
+
+// Reads the hall sensor into joystick coordinates. The neutral position
+// slowly tracks where the stick rests, to follow drift from temperature and
+// mechanical settling during long sessions. Tracking only runs while the
+// stick has been still near neutral for kDriftSettleSamples, moves at a
+// bounded rate, and never strays more than an eighth of the range from the
+// calibrated neutral.
 class HallJoystick {
  public:
+  // Joystick calibration values, as stored in EEPROM.
+  struct Calibration {
+    int neutral_x;
+    int neutral_y;
+    int range;
+    int16_t angle_ticks;
+  };
+
   // Minimum and maximum values each joystick axis is expected to output +
   // digital joystick activation threshold.
   explicit HallJoystick(const Teensy& teensy, int min, int max, int threshold);
 
+  // Same as above, but using the provided calibration rather than the one
+  // stored in EEPROM.
+  HallJoystick(const Calibration& calibration, int min, int max,
+               int threshold);
+
   int get_min();
   int get_max();
   int get_neutral();
@@ -31,13 +63,41 @@ class HallJoystick {
 
   // Map the provided int value from the specified input range to the global
   // output range.
-  int Normalize(const Teensy& teensy, double val, const Bounds& in);
+  int Normalize(const TeensyHal& teensy, double val, const Bounds& in);
 
   // Resolve coordinate value based on digital activation threshold.
   int ResolveDigitalCoord(int coord);
 
-  // Read and return X and Y axes values.
-  Coordinates GetCoordinates(Teensy& teensy);
+  // Output coordinate of a digital direction: -1, 0 or 1.
+  int ToDigitalCoord(int direction);
+
+  // Read and return X and Y axes values. The sensor is only read once it has
+  // a new sample, and the last coordinates are returned until then.
+  Coordinates GetCoordinates(TeensyHal& teensy);
+
+  // Whether the next GetCoordinates call reads a new sample.
+  bool IsSampleDue(const TeensyHal& teensy) const;
+
+  // Keep the calibrated neutral, e.g. while previewing a calibration.
+  void DisableDriftTracking() { track_drift_ = false; }
+
+  // Tracked offset of the resting position from the calibrated neutral, in
+  // sensor units.
+  Coordinates GetNeutralOffset() const;
+
+  // Continue from the neutral tracking of another joystick with the same
+  // calibration, e.g. the one this replaces on a profile push.
+  void InheritDrift(const HallJoystick& other);
+
+  // Hold both axes at neutral while they overshoot after a release.
+  void ConfigureSnapback(const SnapbackConfig& config);
+
+  // Resolve digital mode by angle and radius rather than per axis. Only
+  // applies when the joystick is digital.
+  void ConfigureSectors(const SectorConfig& config);
+
+  // Map analog output through a response curve of `count` points.
+  void ConfigureResponseCurve(const CurvePoint* points, int count);
 
  private:
   // Input data bounds and rotation angle.
@@ -45,10 +105,36 @@ class HallJoystick {
   Bounds y_in_;
   double angle_;
 
+  // Move the tracked neutral offset toward the sample, which has had the
+  // current offset removed, if the stick has been resting near neutral.
+  void TrackNeutral(int x, int y);
+
+  // Calibrated neutral, in sensor units.
+  const Coordinates neutral_;
+  // Distance from neutral within which the stick may be resting, and the
+  // most it may move between samples while resting.
+  const int drift_band_;
+  const int drift_motion_;
+  // Largest step the offset takes per sample, and the furthest it may go,
+  // with kDriftFracBits fractional bits.
+  const int drift_max_step_;
+  const int drift_max_;
+  // Tracked neutral offset, with kDriftFracBits fractional bits.
+  int drift_x_;
+  int drift_y_;
+  Coordinates last_sample_;
+  int still_samples_;
+  bool track_drift_;
+
   // Output data bounds.
   const Bounds out_;
   const int out_neutral_;
 
+  SnapbackFilter snapback_x_;
+  SnapbackFilter snapback_y_;
+  SectorResolver sectors_;
+  ResponseCurve curve_;
+
   // Digital joystick activation thresholds (negative, positive).
   const std::pair<int, int> threshold_;
 
@@ -0,0 +1,95 @@
+// Copyright 2024 Hiram Silvey
+
+#include "joybus.h"
+
+#include <string.h>
+
+namespace hs {
+namespace joybus {
+
+namespace {
+
+// Standard controller device ID, followed by its status byte.
+const uint8_t kProbeResponse[] = {0x09, 0x00, 0x03};
+
+// Calibration origin: no buttons held, sticks centered and triggers released.
+const uint8_t kOriginResponse[] = {0x00, 0x80, 0x80, 0x80, 0x80,
+                                   0x80, 0x00, 0x00, 0x00, 0x00};
+
+}  // namespace
+
+int EncodeWaveform(const uint8_t* bytes, int size, Pulse* pulses) {
+  int count = 0;
+  for (int i = 0; i < size; i++) {
+    for (int bit = 7; bit >= 0; bit--) {
+      const uint16_t low_ns =
+          bytes[i] & (1 << bit) ? kShortLowNs : kLongLowNs;
+      pulses[count++] = {.high = false, .duration_ns = low_ns};
+      pulses[count++] = {
+          .high = true,
+          .duration_ns = static_cast<uint16_t>(kBitPeriodNs - low_ns)};
+    }
+  }
+  pulses[count++] = {.high = false, .duration_ns = kStopLowNs};
+  pulses[count++] = {.high = true, .duration_ns = 0};
+  return count;
+}
+
+int DecodeBits(const uint16_t* low_ns, int count, uint8_t* bytes,
+               int max_size) {
+  const int bits = count - 1;
+  int size = 0;
+  for (int i = 0; i + 8 <= bits && size < max_size; i += 8) {
+    uint8_t byte = 0;
+    for (int bit = 0; bit < 8; bit++) {
+      byte = byte << 1 | (low_ns[i + bit] < kBitThresholdNs);
+    }
+    bytes[size++] = byte;
+  }
+  return size;
+}
+
+int CommandPulses(const uint16_t* low_ns) {
+  uint8_t command;
+  // Counting a ninth pulse as the stop bit decodes all eight as data.
+  DecodeBits(low_ns, 9, &command, 1);
+  switch (command) {
+    case kProbe:
+    case kOrigin:
+    case kReset:
+      return 8 + 1;
+    case kPoll:
+      return kMaxCommandSize * 8 + 1;
+    default:
+      return 0;
+  }
+}
+
+int Respond(const uint8_t* command, int size, const uint8_t* report,
+            uint8_t* response) {
+  if (size < 1) {
+    return 0;
+  }
+  switch (command[0]) {
+    case kProbe:
+    case kReset:
+      memcpy(response, kProbeResponse, sizeof(kProbeResponse));
+      return sizeof(kProbeResponse);
+    case kOrigin:
+      memcpy(response, kOriginResponse, sizeof(kOriginResponse));
+      return sizeof(kOriginResponse);
+    case kPoll:
+      // The analog mode and rumble bytes are ignored; reports are always
+      // sent in mode 3, with full 8-bit triggers.
+      if (size < kMaxCommandSize) {
+        return 0;
+      }
+      memcpy(response, report, kReportSize);
+      return kReportSize;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace joybus
+}  // namespace hs
@@ -0,0 +1,64 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef JOYBUS_H_
+#define JOYBUS_H_
+
+#include <stdint.h>
+
+namespace hs {
+namespace joybus {
+
+// Each bit is a 4us cell starting with a falling edge. A 1 holds the line low
+// for 1us, a 0 for 3us. Transmissions end with a stop bit, which the console
+// holds low for 1us and the controller for 2us.
+const int kBitPeriodNs = 4000;
+const int kShortLowNs = 1000;
+const int kLongLowNs = 3000;
+const int kStopLowNs = 2000;
+
+// Low pulses shorter than this are decoded as a 1.
+const int kBitThresholdNs = 2000;
+
+// Console commands.
+const uint8_t kProbe = 0x00;
+const uint8_t kPoll = 0x40;
+const uint8_t kOrigin = 0x41;
+const uint8_t kReset = 0xFF;
+
+const int kMaxCommandSize = 3;
+const int kReportSize = 8;
+const int kMaxResponseSize = 10;
+
+// One segment of a waveform: the line level and how long to hold it.
+struct Pulse {
+  bool high;
+  uint16_t duration_ns;
+};
+
+// Enough pulses for the largest response: 2 per bit plus the stop bit.
+const int kMaxPulses = (kMaxResponseSize * 8 + 1) * 2;
+
+// Encode the bytes, MSB first, into the waveform the controller drives onto
+// the line, followed by the stop bit and the final release. Returns the
+// number of pulses written.
+int EncodeWaveform(const uint8_t* bytes, int size, Pulse* pulses);
+
+// Decode measured low pulse widths into bytes. The trailing stop bit and any
+// incomplete byte are dropped. Returns the number of bytes decoded.
+int DecodeBits(const uint16_t* low_ns, int count, uint8_t* bytes,
+               int max_size);
+
+// Given the low pulse widths of a command's first byte, the number of low
+// pulses in the whole command, including its stop bit. Returns 0 for an
+// unknown command, whose end can only be found by the line going idle.
+int CommandPulses(const uint16_t* low_ns);
+
+// Build the response to a console command from the pre-packed 8-byte report.
+// Returns the response size, or 0 if the command should go unanswered.
+int Respond(const uint8_t* command, int size, const uint8_t* report,
+            uint8_t* response);
+
+}  // namespace joybus
+}  // namespace hs
+
+#endif  // JOYBUS_H_
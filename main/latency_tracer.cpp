@@ -0,0 +1,75 @@
+// Copyright 2024 Hiram Silvey
+
+#include "latency_tracer.h"
+
+#include <algorithm>
+
+#include "pins.h"
+
+namespace hs {
+
+LatencyTracer::LatencyTracer()
+    : last_pins_(0),
+      pending_(0),
+      edge_cycles_{},
+      samples_{},
+      next_sample_{},
+      num_samples_{} {}
+
+void LatencyTracer::OnSnapshot(uint16_t pins, uint32_t now) {
+  // Keep the earliest stamp if a pin flips again before being sent.
+  const uint16_t edges = (pins ^ last_pins_) & ~pending_;
+  for (int pin = 0; pin < pins::kNumPins; pin++) {
+    if (edges & (1 << pin)) {
+      edge_cycles_[pin] = now;
+    }
+  }
+  pending_ |= edges;
+  last_pins_ = pins;
+}
+
+void LatencyTracer::OnEdge(int pin, uint32_t cycles) {
+  if (!(pending_ & (1 << pin))) {
+    edge_cycles_[pin] = cycles;
+    pending_ |= 1 << pin;
+  }
+}
+
+void LatencyTracer::OnSend(uint32_t now) {
+  for (int pin = 0; pin < pins::kNumPins; pin++) {
+    if (pending_ & (1 << pin)) {
+      samples_[pin][next_sample_[pin]] = now - edge_cycles_[pin];
+      next_sample_[pin] = (next_sample_[pin] + 1) % kLatencySamples;
+      if (num_samples_[pin] < kLatencySamples) {
+        num_samples_[pin]++;
+      }
+    }
+  }
+  pending_ = 0;
+}
+
+LatencyTracer::Stats LatencyTracer::GetStats(int pin) const {
+  const int count = num_samples_[pin];
+  if (count == 0) {
+    return {};
+  }
+
+  uint32_t sorted[kLatencySamples];
+  std::copy(samples_[pin], samples_[pin] + count, sorted);
+  std::sort(sorted, sorted + count);
+
+  uint64_t sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += sorted[i];
+  }
+  // Nearest-rank percentile.
+  const int p99_rank = (count * 99 + 99) / 100;
+
+  return {.count = static_cast<uint32_t>(count),
+          .min = sorted[0],
+          .mean = static_cast<uint32_t>(sum / count),
+          .p99 = sorted[p99_rank - 1],
+          .max = sorted[count - 1]};
+}
+
+}  // namespace hs
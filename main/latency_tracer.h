@@ -0,0 +1,66 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef LATENCY_TRACER_H_
+#define LATENCY_TRACER_H_
+
+#include <stdint.h>
+
+#include "pins.h"
+
+namespace hs {
+
+// Latencies kept per pin. Older samples are overwritten.
+const int kLatencySamples = 128;
+
+// Measures how long each button edge in the input snapshot takes to reach
+// the host, from the snapshot that first sees it to the report send that
+// first carries it. Edges captured by interrupt are measured from the edge
+// itself instead. Timestamps are in CPU cycles.
+class LatencyTracer {
+ public:
+  struct Stats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t mean;
+    uint32_t p99;
+    uint32_t max;
+  };
+
+  LatencyTracer();
+
+  // Whether the snapshot contains any edges, i.e. whether OnSnapshot needs a
+  // timestamp.
+  bool HasEdges(uint16_t pins) const { return pins != last_pins_; }
+
+  // Whether an edge is waiting on OnSend.
+  bool HasPending() const { return pending_ != 0; }
+
+  // Stamp every pin whose state changed since the previous snapshot.
+  void OnSnapshot(uint16_t pins, uint32_t now);
+
+  // Stamp an edge on `pin` at the exact time it was captured. The next
+  // snapshot keeps this stamp rather than its own.
+  void OnEdge(int pin, uint32_t cycles);
+
+  // Record the latency of every pending edge.
+  void OnSend(uint32_t now);
+
+  // Drop every pending edge without recording it, when the report it would
+  // have gone out in is unchanged and so never sent.
+  void Discard() { pending_ = 0; }
+
+  Stats GetStats(int pin) const;
+
+ private:
+  uint16_t last_pins_;
+  uint16_t pending_;
+  uint32_t edge_cycles_[pins::kNumPins];
+
+  uint32_t samples_[pins::kNumPins][kLatencySamples];
+  int next_sample_[pins::kNumPins];
+  int num_samples_[pins::kNumPins];
+};
+
+}  // namespace hs
+
+#endif  // LATENCY_TRACER_H_
@@ -0,0 +1,75 @@
+// Copyright 2024 Hiram Silvey
+
+#include "macro_engine.h"
+
+namespace hs {
+
+MacroEngine::MacroEngine()
+    : last_inputs_(0), pressed_at_{}, queue_{}, queue_size_(0) {}
+
+void MacroEngine::Reset() {
+  last_inputs_ = 0;
+  queue_size_ = 0;
+}
+
+uint32_t MacroEngine::Update(uint32_t inputs, const TimedActions& actions,
+                             const Macros& macros, uint32_t now,
+                             MacroOutput& output) {
+  const uint32_t pressed = inputs & ~last_inputs_;
+  last_inputs_ = inputs;
+
+  for (uint32_t rest = pressed & actions.macro; rest != 0; rest &= rest - 1) {
+    const int input = __builtin_ctz(rest);
+    if (actions.macro_index[input] < macros.size()) {
+      Play(macros[actions.macro_index[input]], now);
+    }
+  }
+
+  // Turbo presses start on the tick the input is pressed, so the first one
+  // adds no latency.
+  uint32_t between_presses = 0;
+  for (uint32_t rest = inputs & actions.turbo; rest != 0; rest &= rest - 1) {
+    const int input = __builtin_ctz(rest);
+    if (pressed & (1u << input)) {
+      pressed_at_[input] = now;
+    }
+    const uint32_t half_periods = (now - pressed_at_[input]) /
+                                  actions.turbo_half_period_micros[input];
+    if (half_periods % 2 == 1) {
+      between_presses |= 1u << input;
+    }
+  }
+
+  int kept = 0;
+  for (int i = 0; i < queue_size_; i++) {
+    const ScheduledStep& step = queue_[i];
+    // Signed, as steps later in a macro start in the future.
+    const int32_t elapsed = now - step.start;
+    if (elapsed >= 0 &&
+        static_cast<uint32_t>(elapsed) >= step.duration_micros) {
+      continue;
+    }
+    if (elapsed >= 0) {
+      output.buttons |= step.output.buttons;
+      output.dpad |= step.output.dpad;
+    }
+    queue_[kept++] = step;
+  }
+  queue_size_ = kept;
+
+  return inputs & ~between_presses;
+}
+
+void MacroEngine::Play(const Macro& macro, uint32_t now) {
+  uint32_t start = now;
+  for (const MacroStep& step : macro) {
+    // Steps which output nothing only need to delay the steps after them.
+    if ((step.output.buttons != 0 || step.output.dpad != 0) &&
+        queue_size_ < kMacroQueueSize) {
+      queue_[queue_size_++] = {start, step.duration_micros, step.output};
+    }
+    start += step.duration_micros;
+  }
+}
+
+}  // namespace hs
@@ -0,0 +1,83 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef MACRO_ENGINE_H_
+#define MACRO_ENGINE_H_
+
+#include <stdint.h>
+
+#include "tap_hold.h"
+#include "util.h"
+
+namespace hs {
+
+// Macro limits, matching the max_count options of the profile.
+const int kMaxMacros = 4;
+const int kMaxMacroSteps = 8;
+
+// Steps which can be scheduled at once across every playing macro.
+const int kMacroQueueSize = 16;
+
+// Report bits output while a macro step plays.
+struct MacroOutput {
+  // Bitfield indexed by platform button ID.
+  uint32_t buttons;
+  // D-pad bits. Bit order: Up, Down, Left, Right
+  uint8_t dpad;
+};
+
+struct MacroStep {
+  MacroOutput output;
+  uint32_t duration_micros;
+};
+
+using Macro = util::FixedVector<MacroStep, kMaxMacroSteps>;
+using Macros = util::FixedVector<Macro, kMaxMacros>;
+
+// Turbo and macro actions of one layer, indexed by input.
+struct TimedActions {
+  // Inputs with a TurboAction.
+  uint32_t turbo;
+  // Inputs with a macro action.
+  uint32_t macro;
+  // Time each turbo press and each gap between presses lasts.
+  uint32_t turbo_half_period_micros[kNumInputs];
+  uint8_t macro_index[kNumInputs];
+};
+
+// Plays turbo and macro actions against the microsecond clock. Playing
+// macros are a fixed-capacity queue of scheduled steps, so updating never
+// blocks or allocates.
+class MacroEngine {
+ public:
+  MacroEngine();
+
+  // Stop every playing macro and forget which inputs are held.
+  void Reset();
+
+  // Advance to `now` given the inputs of the active layer. Starts the macro
+  // of each macro input pressed since the last update, and ORs the outputs
+  // of every step playing at `now` into `output`. Returns the inputs with
+  // turbo inputs between presses cleared.
+  uint32_t Update(uint32_t inputs, const TimedActions& actions,
+                  const Macros& macros, uint32_t now, MacroOutput& output);
+
+ private:
+  struct ScheduledStep {
+    uint32_t start;
+    uint32_t duration_micros;
+    MacroOutput output;
+  };
+
+  // Schedule every step of the macro, starting at `now`. Steps which don't
+  // fit in the queue are dropped.
+  void Play(const Macro& macro, uint32_t now);
+
+  uint32_t last_inputs_;
+  uint32_t pressed_at_[kNumInputs];
+  ScheduledStep queue_[kMacroQueueSize];
+  int queue_size_;
+};
+
+}  // namespace hs
+
+#endif  // MACRO_ENGINE_H_
@@ -4,13 +4,17 @@
 
 #include "configurator.h"
 #include "controller.h"
+#include "edge_capture.h"
+#include "gamecube_controller.h"
 #include "ns_controller.h"
 #include "nspad_impl.h"
 #include "pc_controller.h"
+#include "pc_hid.h"
 #include "pins.h"
 #include "teensy_impl.h"
 
 std::unique_ptr<hs::Controller> controller;
+hs::GameCubeController* gamecube = nullptr;
 extern uint8_t nsgamepad_active;
 extern volatile uint8_t usb_configuration;
 
@@ -34,8 +38,78 @@ void InitPins() {
   delayMicroseconds(50);  // Allow the resistors time to pull up the pins fully.
 }
 
+#ifdef HS_EDGE_CAPTURE
+
+// Log the level of the pin on every change, before the main loop sees it.
+// Templated on the pin so the read compiles to a single register access.
+template <int pin>
+void CapturePinEdge() {
+  hs::edge_capture::PinEdges().Push({.micros = micros(),
+                                     .cycles = ARM_DWT_CYCCNT,
+                                     .pin = pin,
+                                     .pressed = digitalReadFast(pin) == LOW});
+}
+
+template <int pin>
+void AttachEdgeCapture() {
+  attachInterrupt(digitalPinToInterrupt(pin), CapturePinEdge<pin>, CHANGE);
+}
+
+void InitEdgeCapture() {
+  AttachEdgeCapture<hs::pins::kThumbTop>();
+  AttachEdgeCapture<hs::pins::kThumbMiddle>();
+  AttachEdgeCapture<hs::pins::kThumbBottom>();
+  AttachEdgeCapture<hs::pins::kIndexTop>();
+  AttachEdgeCapture<hs::pins::kIndexMiddle>();
+  AttachEdgeCapture<hs::pins::kMiddleTop>();
+  AttachEdgeCapture<hs::pins::kMiddleMiddle>();
+  AttachEdgeCapture<hs::pins::kMiddleBottom>();
+  AttachEdgeCapture<hs::pins::kRingTop>();
+  AttachEdgeCapture<hs::pins::kRingMiddle>();
+  AttachEdgeCapture<hs::pins::kRingBottom>();
+  AttachEdgeCapture<hs::pins::kPinkyTop>();
+  AttachEdgeCapture<hs::pins::kPinkyMiddle>();
+  AttachEdgeCapture<hs::pins::kPinkyBottom>();
+  AttachEdgeCapture<hs::pins::kLeftOuter>();
+  AttachEdgeCapture<hs::pins::kLeftInner>();
+}
+
+#endif  // HS_EDGE_CAPTURE
+
+// Without USB enumeration by then, assume a GameCube console is powering the
+// controller. Enumeration is still watched for afterwards, so a slow host
+// only costs the switch-over rather than leaving the controller stuck.
+const unsigned long kUSBTimeoutMillis = 1000;
+
+void InitUSB(std::unique_ptr<hs::TeensyImpl> teensy) {
+  if (nsgamepad_active) {
+    auto nspad = std::make_unique<hs::NSPadImpl>();
+    controller = std::make_unique<hs::NSController>(std::move(teensy),
+                                                    std::move(nspad));
+  } else {
+    controller = std::make_unique<hs::PCController>(std::move(teensy),
+                                                    hs::kPCHighResolution);
+  }
+}
+
+void ServeConsole() { gamecube->ServeConsole(); }
+
+void InitGameCube(std::unique_ptr<hs::TeensyImpl> teensy) {
+  pinMode(hs::pins::kJoybus, OUTPUT_OPENDRAIN);
+  digitalWriteFast(hs::pins::kJoybus, HIGH);
+  auto controller_impl =
+      std::make_unique<hs::GameCubeController>(std::move(teensy));
+  gamecube = controller_impl.get();
+  controller = std::move(controller_impl);
+  attachInterrupt(digitalPinToInterrupt(hs::pins::kJoybus), ServeConsole,
+		  FALLING);
+}
+
 void setup() {
   InitPins();
+#ifdef HS_EDGE_CAPTURE
+  InitEdgeCapture();
+#endif
 
   auto teensy = std::make_unique<hs::TeensyImpl>();
   if (teensy->DigitalReadLow(hs::pins::kLeftOuter)) {
@@ -43,19 +117,29 @@ void setup() {
     exit(0);
   }
 
+  const unsigned long start = millis();
   while (true) {
     if (usb_configuration) {
-      if (nsgamepad_active) {
-	auto nspad = std::make_unique<hs::NSPadImpl>();
-	controller = std::make_unique<hs::NSController>(std::move(teensy),
-							std::move(nspad));
-      } else {
-	controller = std::make_unique<hs::PCController>(std::move(teensy));
-      }
+      InitUSB(std::move(teensy));
+      break;
+    }
+    if (millis() - start > kUSBTimeoutMillis) {
+      InitGameCube(std::move(teensy));
       break;
     }
     delay(50);
   }
 }
 
-void loop() { controller->Loop(); }
+void loop() {
+  if (gamecube != nullptr && usb_configuration) {
+    // The host enumerated after the timeout. Stop answering the console
+    // before its controller goes away.
+    detachInterrupt(digitalPinToInterrupt(hs::pins::kJoybus));
+    pinMode(hs::pins::kJoybus, INPUT);
+    gamecube = nullptr;
+    controller.reset();
+    InitUSB(std::make_unique<hs::TeensyImpl>());
+  }
+  controller->Loop();
+}
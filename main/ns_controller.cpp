@@ -3,25 +3,49 @@
 #include "ns_controller.h"
 
 #include <memory>
+#include <unordered_map>
 
-#include "hall_joystick.h"
+#include "controller.h"
+#include "hal.h"
 #include "nspad.h"
-#include "pins.h"
 #include "profile.pb.h"
+#include "profiler.h"
 #include "teensy.h"
 
 namespace hs {
 
-using Layout = hs_profile_Profile_Layout;
-using Layer = hs_profile_Profile_Layer;
-using Action = hs_profile_Profile_Layer_Action;
-
-NSController::NSController(std::unique_ptr<Teensy> teensy,
-                           std::unique_ptr<NSPad> nspad)
-    : teensy_(std::move(teensy)),
-      nspad_(std::move(nspad)),
-      base_mapping_({}),
-      mod_mapping_({}) {
+namespace {
+
+// Joystick output range.
+const int kJoystickMax = 255;
+
+// Highest NSPad button ID.
+const int kMaxButtonId = 13;
+
+const std::unordered_map<int, int> kActionToButtonId = {
+    {hs_profile_Profile_Layer_DigitalAction_X, 1},
+    {hs_profile_Profile_Layer_DigitalAction_CIRCLE, 2},
+    {hs_profile_Profile_Layer_DigitalAction_TRIANGLE, 3},
+    {hs_profile_Profile_Layer_DigitalAction_SQUARE, 0},
+    {hs_profile_Profile_Layer_DigitalAction_L1, 4},
+    {hs_profile_Profile_Layer_DigitalAction_L2, 6},
+    {hs_profile_Profile_Layer_DigitalAction_L3, 10},
+    {hs_profile_Profile_Layer_DigitalAction_R1, 5},
+    {hs_profile_Profile_Layer_DigitalAction_R2, 7},
+    {hs_profile_Profile_Layer_DigitalAction_R3, 11},
+    {hs_profile_Profile_Layer_DigitalAction_OPTIONS, 9},
+    {hs_profile_Profile_Layer_DigitalAction_SHARE, 8},
+    {hs_profile_Profile_Layer_DigitalAction_HOME, 12},
+    {hs_profile_Profile_Layer_DigitalAction_CAPTURE, 13},
+};
+
+}  // namespace
+
+NSController::NSController(std::unique_ptr<TeensyHal> teensy,
+                           std::unique_ptr<NSPadHal> nspad)
+    : ReportController(std::move(teensy), hs_profile_Profile_Platform_SWITCH,
+                       kJoystickMax, kJoystickMax, kActionToButtonId),
+      nspad_(std::move(nspad)) {
   // DPad direction with neutral SOCD. Bit order: Up, Down, Left, Right
   dpad_direction_[0] = nspad_->DPadCentered();   // 0000 None
   dpad_direction_[1] = nspad_->DPadRight();      // 0001
@@ -40,178 +64,41 @@ NSController::NSController(std::unique_ptr<Teensy> teensy,
   dpad_direction_[14] = nspad_->DPadLeft();      // 1110 Up + Down cancel
   dpad_direction_[15] =
       nspad_->DPadCentered();  // 1111 Up + Down cancel; Left + Right cancel
-
-  LoadProfile();
-}
-
-NSButtonPinMapping NSController::GetButtonPinMapping(const Layer& layer) {
-  NSButtonPinMapping mapping;
-
-  std::vector<pins::ActionPin> action_pins = pins::GetActionPins(layer);
-
-  std::unordered_map<int, int> action_to_button_id = {
-      {hs_profile_Profile_Layer_DigitalAction_X, 1},
-      {hs_profile_Profile_Layer_DigitalAction_CIRCLE, 2},
-      {hs_profile_Profile_Layer_DigitalAction_TRIANGLE, 3},
-      {hs_profile_Profile_Layer_DigitalAction_SQUARE, 0},
-      {hs_profile_Profile_Layer_DigitalAction_L1, 4},
-      {hs_profile_Profile_Layer_DigitalAction_L2, 6},
-      {hs_profile_Profile_Layer_DigitalAction_L3, 10},
-      {hs_profile_Profile_Layer_DigitalAction_R1, 5},
-      {hs_profile_Profile_Layer_DigitalAction_R2, 7},
-      {hs_profile_Profile_Layer_DigitalAction_R3, 11},
-      {hs_profile_Profile_Layer_DigitalAction_OPTIONS, 9},
-      {hs_profile_Profile_Layer_DigitalAction_SHARE, 8},
-      {hs_profile_Profile_Layer_DigitalAction_HOME, 12},
-      {hs_profile_Profile_Layer_DigitalAction_CAPTURE, 13},
-  };
-
-  for (const auto& action_pin : action_pins) {
-    auto action = action_pin.action;
-    int pin = action_pin.pin;
-    if (action.which_action_type ==
-        hs_profile_Profile_Layer_Action_digital_tag) {
-      auto digital = action.action_type.digital;
-      if (action_to_button_id.find(digital) != action_to_button_id.end()) {
-        int button_id = action_to_button_id[digital];
-        if (mapping.button_id_to_pins.find(button_id) !=
-            mapping.button_id_to_pins.end()) {
-          mapping.button_id_to_pins[button_id].push_back(pin);
-        } else {
-          mapping.button_id_to_pins[button_id] = {pin};
-        }
-      } else {
-        switch (digital) {
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_UP:
-            mapping.z_y.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_DOWN:
-            mapping.z_y.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_LEFT:
-            mapping.z_x.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_RIGHT:
-            mapping.z_x.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_UP:
-            mapping.dpad_up.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN:
-            mapping.dpad_down.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT:
-            mapping.dpad_left.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_RIGHT:
-            mapping.dpad_right.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_MOD:
-            mapping.mod.push_back(pin);
-            break;
-          default:
-            break;
-        }
-      }
-    } else {
-      auto analog = action.action_type.analog;
-      int value = analog.value;
-      switch (analog.id) {
-        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X:
-          mapping.z_x.push_back({value, pin});
-          break;
-        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_Y:
-          mapping.z_y.push_back({value, pin});
-          break;
-        default:
-          break;
-      }
-    }
-  }
-
-  return mapping;
 }
 
-void NSController::LoadProfile() {
-  Layout layout = FetchProfile(*teensy_, hs_profile_Profile_Platform_SWITCH);
-  joystick_ = std::make_unique<HallJoystick>(*teensy_, 0, 255,
-                                             layout.joystick_threshold);
-  base_mapping_ = GetButtonPinMapping(layout.base);
-  if (layout.has_mod) {
-    mod_mapping_ = GetButtonPinMapping(layout.mod);
-  }
+int NSController::GetDPadDirection(uint8_t dpad) {
+  return dpad_direction_[dpad & 15];
 }
 
-int NSController::GetDPadDirection(const NSButtonPinMapping& mapping) {
-  int bits = 0;
-  for (const int pin : mapping.dpad_up) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 8;  // 1000
-      break;
-    }
-  }
-  for (const int pin : mapping.dpad_down) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 4;  // 0100
-      break;
-    }
-  }
-  for (const int pin : mapping.dpad_left) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 2;  // 0010
-      break;
-    }
-  }
-  for (const int pin : mapping.dpad_right) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 1;  // 0001
-      break;
-    }
-  }
-  return dpad_direction_[bits];
+NSReport NSController::GetNSReport(const OutputReport& report) {
+  // Platform button IDs are the report's bit positions.
+  return {.buttons = static_cast<uint16_t>(report.buttons &
+                                           ((1 << (kMaxButtonId + 1)) - 1)),
+          .dpad = static_cast<uint8_t>(GetDPadDirection(report.dpad)),
+          .left_x = static_cast<uint8_t>(report.left_x),
+          .left_y = static_cast<uint8_t>(joystick_max_ - report.left_y),
+          .right_x = static_cast<uint8_t>(report.right_x),
+          .right_y = static_cast<uint8_t>(joystick_max_ - report.right_y),
+          .filler = 0};
 }
 
-void NSController::UpdateButtons(const NSButtonPinMapping& mapping) {
-  nspad_->SetRightYAxis(
-      joystick_->get_max() -
-      ResolveSOCD(*teensy_, mapping.z_y, joystick_->get_neutral()));
-  nspad_->SetRightXAxis(
-      ResolveSOCD(*teensy_, mapping.z_x, joystick_->get_neutral()));
-
-  for (const auto& element : mapping.button_id_to_pins) {
-    for (const auto& pin : element.second) {
-      if (teensy_->DigitalReadLow(pin)) {
-        nspad_->Press(element.first);
-        break;
-      }
-    }
-  }
-
-  nspad_->SetDPad(GetDPadDirection(mapping));
+void NSController::SendReport(const OutputReport& report) {
+  nspad_->SendReport(GetNSReport(report));
 }
 
 void NSController::Loop() {
-  nspad_->ReleaseAll();
-
-  HallJoystick::Coordinates coords = joystick_->GetCoordinates(*teensy_);
-  nspad_->SetLeftYAxis(joystick_->get_max() - coords.y);
-  nspad_->SetLeftXAxis(coords.x);
-
-  bool mod_active = false;
-  for (const auto& pin : base_mapping_.mod) {
-    if (teensy_->DigitalReadLow(pin)) {
-      mod_active = true;
-      break;
+  if (IsReportDue()) {
+    profiler::Timer tick_timer(*teensy_, profiler::kTick);
+    const OutputReport report = Poll();
+    if (ShouldSend(report)) {
+      profiler::Timer send_timer(*teensy_, profiler::kSend);
+      SendReport(report);
+      TraceSend();
     }
-  }
-
-  if (mod_active) {
-    UpdateButtons(mod_mapping_);
   } else {
-    UpdateButtons(base_mapping_);
+    Scan();
   }
-
-  nspad_->Loop();
+  PollSerial();
 }
 
 }  // namespace hs
@@ -4,41 +4,26 @@
 #define NS_CONTROLLER_H_
 
 #include <memory>
-#include <unordered_map>
-#include <vector>
 
 #include "controller.h"
-#include "hall_joystick.h"
+#include "hal.h"
 #include "nspad.h"
 #include "teensy.h"
 
 namespace hs {
 
-struct NSButtonPinMapping : ButtonPinMapping {
-  std::vector<AnalogButton> z_y;
-  std::vector<AnalogButton> z_x;
-  std::vector<int> dpad_up;
-  std::vector<int> dpad_down;
-  std::vector<int> dpad_left;
-  std::vector<int> dpad_right;
-};
-
-class NSController : public Controller {
+class NSController final : public ReportController {
  public:
-  NSController(std::unique_ptr<Teensy> teensy, std::unique_ptr<NSPad> nspad);
-  NSButtonPinMapping GetButtonPinMapping(const hs_profile_Profile_Layer& layer);
-  void LoadProfile() override;
-  int GetDPadDirection(const NSButtonPinMapping& mapping);
-  void UpdateButtons(const NSButtonPinMapping& mapping);
+  NSController(std::unique_ptr<TeensyHal> teensy,
+               std::unique_ptr<NSPadHal> nspad);
+  int GetDPadDirection(uint8_t dpad);
+  NSReport GetNSReport(const OutputReport& report);
+  void SendReport(const OutputReport& report);
   void Loop() override;
 
  private:
-  std::unique_ptr<Teensy> teensy_;
-  std::unique_ptr<NSPad> nspad_;
-  std::unique_ptr<HallJoystick> joystick_;
+  std::unique_ptr<NSPadHal> nspad_;
   int dpad_direction_[16];
-  NSButtonPinMapping base_mapping_;
-  NSButtonPinMapping mod_mapping_;
 };
 
 }  // namespace hs
@@ -3,8 +3,25 @@
 #ifndef NSPAD_H_
 #define NSPAD_H_
 
+#include <stdint.h>
+
 namespace hs {
 
+// USB input report of the Switch gamepad, as sent to the console.
+struct __attribute__((packed)) NSReport {
+  // Bitfield indexed by button ID.
+  uint16_t buttons;
+  // One of the DPad*() directions.
+  uint8_t dpad;
+  uint8_t left_x;
+  uint8_t left_y;
+  uint8_t right_x;
+  uint8_t right_y;
+  uint8_t filler;
+};
+
+static_assert(sizeof(NSReport) == 8);
+
 class NSPad {
  public:
   virtual ~NSPad() {}
@@ -19,14 +36,8 @@ class NSPad {
   virtual int DPadDownLeft() const = 0;
   virtual int DPadDownRight() const = 0;
 
-  virtual void SetLeftXAxis(uint8_t val) const = 0;
-  virtual void SetLeftYAxis(uint8_t val) const = 0;
-  virtual void SetRightXAxis(uint8_t val) const = 0;
-  virtual void SetRightYAxis(uint8_t val) const = 0;
-  virtual void SetDPad(int8_t direction) const = 0;
-  virtual void Press(uint8_t button_id) const = 0;
-  virtual void ReleaseAll() const = 0;
-  virtual void Loop() const = 0;
+  // Send the whole report to the console in one call.
+  virtual void SendReport(const NSReport& report) const = 0;
 };
 
 }  // namespace hs
@@ -8,7 +8,7 @@
 
 namespace hs {
 
-class NSPadImpl : public NSPad {
+class NSPadImpl final : public NSPad {
  public:
   inline int DPadCentered() const override { return NSGAMEPAD_DPAD_CENTERED; }
   inline int DPadUp() const override { return NSGAMEPAD_DPAD_UP; }
@@ -22,26 +22,11 @@ class NSPadImpl : public NSPad {
     return NSGAMEPAD_DPAD_DOWN_RIGHT;
   }
 
-  inline void SetLeftXAxis(uint8_t val) const override {
-    NSGamepad.leftXAxis(val);
+  // NSReport has the layout of the library's report, so it is copied in and
+  // sent as is.
+  inline void SendReport(const NSReport& report) const override {
+    NSGamepad.write(const_cast<NSReport*>(&report));
   }
-  inline void SetLeftYAxis(uint8_t val) const override {
-    NSGamepad.leftYAxis(val);
-  }
-  inline void SetRightXAxis(uint8_t val) const override {
-    NSGamepad.rightXAxis(val);
-  }
-  inline void SetRightYAxis(uint8_t val) const override {
-    NSGamepad.rightYAxis(val);
-  }
-  inline void SetDPad(int8_t direction) const override {
-    NSGamepad.dPad(direction);
-  }
-  inline void Press(uint8_t button_id) const override {
-    NSGamepad.press(button_id);
-  }
-  inline void ReleaseAll() const override { NSGamepad.releaseAll(); }
-  inline void Loop() const override { NSGamepad.loop(); }
 };
 
 }  // namespace hs
@@ -3,18 +3,39 @@
 #include "pc_controller.h"
 
 #include <memory>
+#include <unordered_map>
 
 #include "controller.h"
-#include "hall_joystick.h"
-#include "pins.h"
+#include "hal.h"
+#include "pc_hid.h"
 #include "profile.pb.h"
+#include "profiler.h"
 #include "teensy.h"
 
 namespace hs {
 
-using Layout = hs_profile_Profile_Layout;
-using Layer = hs_profile_Profile_Layer;
-using Action = hs_profile_Profile_Layer_Action;
+namespace {
+
+// Joystick output range.
+const int kJoystickMax = 1023;
+
+// Joystick button IDs start at 1.
+const int kMinButtonId = 1;
+const int kMaxButtonId = 12;
+
+const std::unordered_map<int, int> kActionToButtonId = {
+    {hs_profile_Profile_Layer_DigitalAction_X, 2},
+    {hs_profile_Profile_Layer_DigitalAction_CIRCLE, 3},
+    {hs_profile_Profile_Layer_DigitalAction_TRIANGLE, 4},
+    {hs_profile_Profile_Layer_DigitalAction_SQUARE, 1},
+    {hs_profile_Profile_Layer_DigitalAction_L1, 5},
+    {hs_profile_Profile_Layer_DigitalAction_L2, 7},
+    {hs_profile_Profile_Layer_DigitalAction_L3, 11},
+    {hs_profile_Profile_Layer_DigitalAction_R1, 6},
+    {hs_profile_Profile_Layer_DigitalAction_R2, 8},
+    {hs_profile_Profile_Layer_DigitalAction_R3, 12},
+    {hs_profile_Profile_Layer_DigitalAction_OPTIONS, 10},
+    {hs_profile_Profile_Layer_DigitalAction_SHARE, 9}};
 
 // DPad degrees with neutral SOCD.
 const int kDPadAngle[16] = {
@@ -37,198 +58,70 @@ const int kDPadAngle[16] = {
     -1,   // 1111 Up + Down cancel; Left + Right cancel
 };
 
-PCController::PCController(std::unique_ptr<Teensy> teensy)
-    : teensy_(std::move(teensy)), base_mapping_({}), mod_mapping_({}) {
-  LoadProfile();
+}  // namespace
+
+PCController::PCController(std::unique_ptr<TeensyHal> teensy,
+                           bool high_resolution)
+    : ReportController(std::move(teensy), hs_profile_Profile_Platform_PC,
+                       high_resolution ? kHiResJoystickMax : kJoystickMax,
+                       kJoystickMax, kActionToButtonId),
+      high_resolution_(high_resolution) {
   teensy_->JoystickUseManualSend();
 }
 
-PCButtonPinMapping PCController::GetButtonPinMapping(const Layer& layer) {
-  PCButtonPinMapping mapping;
-
-  std::vector<pins::ActionPin> action_pins = pins::GetActionPins(layer);
-
-  std::unordered_map<int, int> action_to_button_id = {
-      {hs_profile_Profile_Layer_DigitalAction_X, 2},
-      {hs_profile_Profile_Layer_DigitalAction_CIRCLE, 3},
-      {hs_profile_Profile_Layer_DigitalAction_TRIANGLE, 4},
-      {hs_profile_Profile_Layer_DigitalAction_SQUARE, 1},
-      {hs_profile_Profile_Layer_DigitalAction_L1, 5},
-      {hs_profile_Profile_Layer_DigitalAction_L2, 7},
-      {hs_profile_Profile_Layer_DigitalAction_L3, 11},
-      {hs_profile_Profile_Layer_DigitalAction_R1, 6},
-      {hs_profile_Profile_Layer_DigitalAction_R2, 8},
-      {hs_profile_Profile_Layer_DigitalAction_R3, 12},
-      {hs_profile_Profile_Layer_DigitalAction_OPTIONS, 10},
-      {hs_profile_Profile_Layer_DigitalAction_SHARE, 9}};
-
-  for (const auto& action_pin : action_pins) {
-    auto action = action_pin.action;
-    int pin = action_pin.pin;
-    if (action.which_action_type ==
-        hs_profile_Profile_Layer_Action_digital_tag) {
-      auto digital = action.action_type.digital;
-      if (action_to_button_id.find(digital) != action_to_button_id.end()) {
-        int button_id = action_to_button_id[digital];
-        if (mapping.button_id_to_pins.find(button_id) !=
-            mapping.button_id_to_pins.end()) {
-          mapping.button_id_to_pins[button_id].push_back(pin);
-        } else {
-          mapping.button_id_to_pins[button_id] = {pin};
-        }
-      } else {
-        switch (digital) {
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_UP:
-            mapping.z_y.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_DOWN:
-            mapping.z_y.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_LEFT:
-            mapping.z_x.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_R_STICK_RIGHT:
-            mapping.z_x.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_SLIDER_LEFT_MIN:
-            mapping.slider_left.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_SLIDER_LEFT_MAX:
-            mapping.slider_left.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_SLIDER_RIGHT_MIN:
-            mapping.slider_right.push_back({joystick_->get_min(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_SLIDER_RIGHT_MAX:
-            mapping.slider_right.push_back({joystick_->get_max(), pin});
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_UP:
-            mapping.hat_up.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN:
-            mapping.hat_down.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT:
-            mapping.hat_left.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_D_PAD_RIGHT:
-            mapping.hat_right.push_back(pin);
-            break;
-          case hs_profile_Profile_Layer_DigitalAction_MOD:
-            mapping.mod.push_back(pin);
-            break;
-          default:
-            break;
-        }
-      }
-    } else {
-      auto analog = action.action_type.analog;
-      int value = analog.value;
-      switch (analog.id) {
-        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X:
-          mapping.z_x.push_back({value, pin});
-          break;
-        case hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_Y:
-          mapping.z_y.push_back({value, pin});
-          break;
-        case hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_LEFT:
-          mapping.slider_left.push_back({value, pin});
-          break;
-        case hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_RIGHT:
-          mapping.slider_right.push_back({value, pin});
-          break;
-        default:
-          break;
-      }
-    }
-  }
-
-  return mapping;
+int PCController::GetDPadAngle(uint8_t dpad) { return kDPadAngle[dpad & 15]; }
+
+HiResReport PCController::GetHiResReport(const OutputReport& report) {
+  const int angle = GetDPadAngle(report.dpad);
+  return {.buttons = static_cast<uint16_t>(report.buttons >> kMinButtonId),
+          .x = report.left_x,
+          .y = static_cast<uint16_t>(joystick_max_ - report.left_y),
+          .z = report.right_y,
+          .z_rotate = report.right_x,
+          .slider_left = report.slider_left,
+          .slider_right = report.slider_right,
+          .hat = static_cast<uint8_t>(angle < 0 ? kHiResHatCentered
+                                                : angle / 45)};
 }
 
-void PCController::LoadProfile() {
-  Layout layout = FetchProfile(*teensy_, hs_profile_Profile_Platform_PC);
-  joystick_ = std::make_unique<HallJoystick>(*teensy_, 0, 1023,
-                                             layout.joystick_threshold);
-  base_mapping_ = GetButtonPinMapping(layout.base);
-  if (layout.has_mod) {
-    mod_mapping_ = GetButtonPinMapping(layout.mod);
+void PCController::SendReport(const OutputReport& report) {
+  if (high_resolution_) {
+    const HiResReport hires = GetHiResReport(report);
+    teensy_->JoystickSendReport(reinterpret_cast<const uint8_t*>(&hires),
+                                sizeof(hires));
+    return;
   }
-}
 
-int PCController::GetDPadAngle(const PCButtonPinMapping& mapping) {
-  int bits = 0;
-  for (const int pin : mapping.hat_up) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 8;  // 1000
-      break;
-    }
-  }
-  for (const int pin : mapping.hat_down) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 4;  // 0100
-      break;
-    }
-  }
-  for (const int pin : mapping.hat_left) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 2;  // 0010
-      break;
-    }
-  }
-  for (const int pin : mapping.hat_right) {
-    if (teensy_->DigitalReadLow(pin)) {
-      bits |= 1;  // 0001
-      break;
-    }
-  }
-  return kDPadAngle[bits];
-}
+  teensy_->SetJoystickX(report.left_x);
+  teensy_->SetJoystickY(joystick_max_ - report.left_y);
+  teensy_->SetJoystickZ(report.right_y);
+  teensy_->SetJoystickZRotate(report.right_x);
+  teensy_->SetJoystickSliderLeft(report.slider_left);
+  teensy_->SetJoystickSliderRight(report.slider_right);
 
-void PCController::UpdateButtons(const PCButtonPinMapping& mapping) {
-  teensy_->SetJoystickZ(
-      ResolveSOCD(*teensy_, mapping.z_y, joystick_->get_neutral()));
-  teensy_->SetJoystickZRotate(
-      ResolveSOCD(*teensy_, mapping.z_x, joystick_->get_neutral()));
-  teensy_->SetJoystickSliderLeft(
-      ResolveSOCD(*teensy_, mapping.slider_left, joystick_->get_neutral()));
-  teensy_->SetJoystickSliderRight(
-      ResolveSOCD(*teensy_, mapping.slider_right, joystick_->get_neutral()));
-
-  for (const auto& element : mapping.button_id_to_pins) {
-    bool active = false;
-    for (const auto& pin : element.second) {
-      if (teensy_->DigitalReadLow(pin)) {
-        active = true;
-        break;
-      }
-    }
-    teensy_->SetJoystickButton(element.first, active);
+  for (int id = kMinButtonId; id <= kMaxButtonId; id++) {
+    teensy_->SetJoystickButton(id, report.buttons & (1 << id));
   }
 
-  teensy_->SetJoystickHat(GetDPadAngle(mapping));
+  teensy_->SetJoystickHat(GetDPadAngle(report.dpad));
+  teensy_->JoystickSendNow();
 }
 
 void PCController::Loop() {
-  HallJoystick::Coordinates coords = joystick_->GetCoordinates(*teensy_);
-  teensy_->SetJoystickX(coords.x);
-  teensy_->SetJoystickY(joystick_->get_max() - coords.y);
-
-  bool mod_active = false;
-  for (const auto& pin : base_mapping_.mod) {
-    if (teensy_->DigitalReadLow(pin)) {
-      mod_active = true;
-      break;
+  if (IsReportDue()) {
+    profiler::Timer tick_timer(*teensy_, profiler::kTick);
+    const OutputReport report = Poll();
+    // JoystickSendNow() can block until the endpoint is free, so unchanged
+    // reports are left to the keep-alive and the loop goes back to scanning.
+    if (ShouldSend(report)) {
+      profiler::Timer send_timer(*teensy_, profiler::kSend);
+      SendReport(report);
+      TraceSend();
     }
-  }
-
-  if (mod_active) {
-    UpdateButtons(mod_mapping_);
   } else {
-    UpdateButtons(base_mapping_);
+    Scan();
   }
-
-  teensy_->JoystickSendNow();
+  PollSerial();
 }
 
 }  // namespace hs
@@ -4,42 +4,29 @@
 #define PC_CONTROLLER_H_
 
 #include <memory>
-#include <unordered_map>
-#include <vector>
 
 #include "controller.h"
-#include "hall_joystick.h"
+#include "hal.h"
+#include "pc_hid.h"
 #include "teensy.h"
 
 namespace hs {
 
-struct PCButtonPinMapping : ButtonPinMapping {
-  std::vector<AnalogButton> z_y;
-  std::vector<AnalogButton> z_x;
-  std::vector<AnalogButton> slider_left;
-  std::vector<AnalogButton> slider_right;
-  std::vector<int> hat_up;
-  std::vector<int> hat_down;
-  std::vector<int> hat_left;
-  std::vector<int> hat_right;
-};
-
-class PCController : public Controller {
+class PCController final : public ReportController {
  public:
-  PCController(std::unique_ptr<Teensy> teensy);
-  PCButtonPinMapping GetButtonPinMapping(const hs_profile_Profile_Layer& layer);
-  void LoadProfile() override;
-  int GetDPadAngle(const PCButtonPinMapping& mapping);
-  void UpdateButtons(const PCButtonPinMapping& mapping);
+  // With `high_resolution`, axes span kHiResJoystickMax and reports are sent
+  // as a HiResReport, which needs the matching HID descriptor.
+  explicit PCController(std::unique_ptr<TeensyHal> teensy,
+                        bool high_resolution = false);
+  int GetDPadAngle(uint8_t dpad);
+  HiResReport GetHiResReport(const OutputReport& report);
+  void SendReport(const OutputReport& report);
   void Loop() override;
 
  private:
-  std::unique_ptr<Teensy> teensy_;
-  std::unique_ptr<HallJoystick> joystick_;
-  PCButtonPinMapping base_mapping_;
-  PCButtonPinMapping mod_mapping_;
+  const bool high_resolution_;
 };
 
-#endif  // PC_CONTROLLER_H_
-
 }  // namespace hs
+
+#endif  // PC_CONTROLLER_H_
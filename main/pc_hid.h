@@ -0,0 +1,93 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef PC_HID_H_
+#define PC_HID_H_
+
+#include <stdint.h>
+
+// Uncomment to report to the PC with 16-bit axes through the HID report
+// below, rather than the 10-bit axes of the stock Teensy joystick. The Teensy
+// core must be built with joystick_report_desc in usb_desc.c replaced by
+// a copy of kHiResReportDescriptor, and JOYSTICK_SIZE in usb_desc.h set to
+// sizeof(HiResReport), which the build checks.
+// #define HS_PC_HIRES
+
+namespace hs {
+
+#ifdef HS_PC_HIRES
+const bool kPCHighResolution = true;
+#else
+const bool kPCHighResolution = false;
+#endif
+
+// Axis range of the high-resolution report.
+const int kHiResJoystickMax = 65535;
+
+// Hat value while the D-pad is centered. Outside the logical range, so hosts
+// read it as the null state.
+const uint8_t kHiResHatCentered = 15;
+
+// Input report described by kHiResReportDescriptor, sent as is.
+struct __attribute__((packed)) HiResReport {
+  // Bit N is HID button N + 1.
+  uint16_t buttons;
+  uint16_t x;
+  uint16_t y;
+  uint16_t z;
+  uint16_t z_rotate;
+  uint16_t slider_left;
+  uint16_t slider_right;
+  // Low nibble: D-pad direction in 45 degree steps clockwise from up, or
+  // kHiResHatCentered. High nibble: padding.
+  uint8_t hat;
+};
+
+static_assert(sizeof(HiResReport) == 15);
+
+// Reference copy of the descriptor for HiResReport. The firmware never reads
+// it: the Teensy core compiles its own descriptor from usb_desc.c, so this is
+// what to paste there, and it lives here to be changed along with the struct.
+const uint8_t kHiResReportDescriptor[] = {
+    0x05, 0x01,  // Usage Page (Generic Desktop)
+    0x09, 0x04,  // Usage (Joystick)
+    0xA1, 0x01,  // Collection (Application)
+    // 16 buttons.
+    0x05, 0x09,  //   Usage Page (Button)
+    0x19, 0x01,  //   Usage Minimum (1)
+    0x29, 0x10,  //   Usage Maximum (16)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x01,  //   Logical Maximum (1)
+    0x75, 0x01,  //   Report Size (1)
+    0x95, 0x10,  //   Report Count (16)
+    0x81, 0x02,  //   Input (Data, Variable, Absolute)
+    // 6 axes of 16 bits.
+    0x05, 0x01,                    //   Usage Page (Generic Desktop)
+    0x09, 0x30,                    //   Usage (X)
+    0x09, 0x31,                    //   Usage (Y)
+    0x09, 0x32,                    //   Usage (Z)
+    0x09, 0x35,                    //   Usage (Rz)
+    0x09, 0x36,                    //   Usage (Slider)
+    0x09, 0x36,                    //   Usage (Slider)
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x27, 0xFF, 0xFF, 0x00, 0x00,  //   Logical Maximum (65535)
+    0x75, 0x10,                    //   Report Size (16)
+    0x95, 0x06,                    //   Report Count (6)
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+    // Hat switch, then padding to the byte.
+    0x09, 0x39,        //   Usage (Hat Switch)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x07,        //   Logical Maximum (7)
+    0x35, 0x00,        //   Physical Minimum (0)
+    0x46, 0x3B, 0x01,  //   Physical Maximum (315)
+    0x65, 0x14,        //   Unit (Degrees)
+    0x75, 0x04,        //   Report Size (4)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x42,        //   Input (Data, Variable, Absolute, Null State)
+    0x65, 0x00,        //   Unit (None)
+    0x81, 0x03,        //   Input (Constant)
+    0xC0,              // End Collection
+};
+
+}  // namespace hs
+
+#endif  // PC_HID_H_
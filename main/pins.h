@@ -3,7 +3,7 @@
 #ifndef PINS_H_
 #define PINS_H_
 
-#include <vector>
+#include <array>
 
 #include "profile.pb.h"
 
@@ -28,13 +28,19 @@ const int kPinkyBottom = 13;
 const int kLeftOuter = 14;
 const int kLeftInner = 15;
 
+const int kNumPins = 16;
+
+// GameCube console data line.
+const int kJoybus = 23;
+
 struct ActionPin {
   hs_profile_Profile_Layer_Action action;
   int pin;
 };
 
 // Get pins associated with each profile layer action.
-std::vector<ActionPin> GetActionPins(const hs_profile_Profile_Layer& layer);
+std::array<ActionPin, kNumPins> GetActionPins(
+    const hs_profile_Profile_Layer& layer);
 
 }  // namespace pins
 }  // namespace hs
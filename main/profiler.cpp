@@ -0,0 +1,37 @@
+// Copyright 2024 Hiram Silvey
+
+#include "profiler.h"
+
+#include <string.h>
+
+namespace hs {
+namespace profiler {
+
+#ifdef HS_PROFILE
+
+namespace {
+
+Histogram histograms[kNumStages];
+
+}  // namespace
+
+void Record(Stage stage, uint32_t cycles) {
+  int bucket = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+  if (bucket >= kNumBuckets) {
+    bucket = kNumBuckets - 1;
+  }
+  Histogram& histogram = histograms[stage];
+  histogram.buckets[bucket]++;
+  if (cycles > histogram.max) {
+    histogram.max = cycles;
+  }
+}
+
+const Histogram& Get(Stage stage) { return histograms[stage]; }
+
+void Reset() { memset(histograms, 0, sizeof(histograms)); }
+
+#endif  // HS_PROFILE
+
+}  // namespace profiler
+}  // namespace hs
@@ -0,0 +1,70 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+
+#include "hal.h"
+
+// Uncomment to collect per-tick cycle histograms, retrievable over serial
+// while the controller is running. Left undefined, profiling compiles away.
+// #define HS_PROFILE
+
+namespace hs {
+namespace profiler {
+
+// Timed sections of a tick.
+enum Stage {
+  kTick = 0,  // The whole tick, excluding serial commands.
+  kSensor,    // Joystick sensor read.
+  kButtons,   // Pin snapshot and report resolution.
+  kSend,      // Report serialization.
+  kNumStages,
+};
+
+// Bucket N counts samples taking [2^(N-1), 2^N) cycles. Bucket 0 counts
+// zero-cycle samples and the last bucket absorbs anything longer.
+const int kNumBuckets = 32;
+
+struct Histogram {
+  uint32_t buckets[kNumBuckets];
+  uint32_t max;
+};
+
+#ifdef HS_PROFILE
+
+const bool kEnabled = true;
+
+void Record(Stage stage, uint32_t cycles);
+const Histogram& Get(Stage stage);
+void Reset();
+
+// Records the cycles elapsed over its lifetime against the stage.
+class Timer {
+ public:
+  Timer(const TeensyHal& teensy, Stage stage)
+      : teensy_(teensy), stage_(stage), start_(teensy.CycleCount()) {}
+  ~Timer() { Record(stage_, teensy_.CycleCount() - start_); }
+
+ private:
+  const TeensyHal& teensy_;
+  const Stage stage_;
+  const uint32_t start_;
+};
+
+#else
+
+const bool kEnabled = false;
+
+class Timer {
+ public:
+  Timer(const TeensyHal&, Stage) {}
+};
+
+#endif  // HS_PROFILE
+
+}  // namespace profiler
+}  // namespace hs
+
+#endif  // PROFILER_H_
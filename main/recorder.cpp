@@ -0,0 +1,119 @@
+// Copyright 2024 Hiram Silvey
+
+#include "recorder.h"
+
+#include <string.h>
+
+namespace hs {
+namespace recorder {
+
+namespace {
+
+uint8_t* WriteInt(uint8_t* bytes, uint32_t val) {
+  *bytes++ = val >> 24;
+  *bytes++ = val >> 16 & 0xFF;
+  *bytes++ = val >> 8 & 0xFF;
+  *bytes++ = val & 0xFF;
+  return bytes;
+}
+
+uint8_t* WriteShort(uint8_t* bytes, uint16_t val) {
+  *bytes++ = val >> 8;
+  *bytes++ = val & 0xFF;
+  return bytes;
+}
+
+uint32_t ReadInt(const uint8_t*& bytes) {
+  const uint32_t val = static_cast<uint32_t>(bytes[0]) << 24 |
+                       bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+  bytes += 4;
+  return val;
+}
+
+uint16_t ReadShort(const uint8_t*& bytes) {
+  const uint16_t val = bytes[0] << 8 | bytes[1];
+  bytes += 2;
+  return val;
+}
+
+#ifdef HS_RECORD
+
+Entry entries[kCapacity];
+// Index of the oldest entry, and the number held.
+int head = 0;
+int size = 0;
+
+#endif  // HS_RECORD
+
+}  // namespace
+
+void Serialize(const Entry& entry, uint8_t* bytes) {
+  bytes = WriteInt(bytes, entry.micros);
+  bytes = WriteShort(bytes, entry.pins);
+  bytes = WriteShort(bytes, entry.x);
+  bytes = WriteShort(bytes, entry.y);
+  bytes = WriteInt(bytes, entry.report.buttons);
+  *bytes++ = entry.report.dpad;
+  bytes = WriteShort(bytes, entry.report.left_x);
+  bytes = WriteShort(bytes, entry.report.left_y);
+  bytes = WriteShort(bytes, entry.report.right_x);
+  bytes = WriteShort(bytes, entry.report.right_y);
+  bytes = WriteShort(bytes, entry.report.slider_left);
+  WriteShort(bytes, entry.report.slider_right);
+}
+
+Entry Deserialize(const uint8_t* bytes) {
+  Entry entry;
+  entry.micros = ReadInt(bytes);
+  entry.pins = ReadShort(bytes);
+  entry.x = ReadShort(bytes);
+  entry.y = ReadShort(bytes);
+  entry.report.buttons = ReadInt(bytes);
+  entry.report.dpad = *bytes++;
+  entry.report.left_x = ReadShort(bytes);
+  entry.report.left_y = ReadShort(bytes);
+  entry.report.right_x = ReadShort(bytes);
+  entry.report.right_y = ReadShort(bytes);
+  entry.report.slider_left = ReadShort(bytes);
+  entry.report.slider_right = ReadShort(bytes);
+  return entry;
+}
+
+#ifdef HS_RECORD
+
+void Record(uint32_t micros, uint16_t pins,
+            const HallJoystick::Coordinates& coords,
+            const OutputReport& report) {
+  const Entry entry = {.micros = micros,
+                       .pins = pins,
+                       .x = static_cast<uint16_t>(coords.x),
+                       .y = static_cast<uint16_t>(coords.y),
+                       .report = report};
+  if (size > 0) {
+    const Entry& last = entries[(head + size - 1) % kCapacity];
+    if (entry.pins == last.pins && entry.x == last.x && entry.y == last.y &&
+        memcmp(&entry.report, &last.report, sizeof(OutputReport)) == 0) {
+      return;
+    }
+  }
+  if (size < kCapacity) {
+    entries[(head + size++) % kCapacity] = entry;
+  } else {
+    entries[head] = entry;
+    head = (head + 1) % kCapacity;
+  }
+}
+
+int Size() { return size; }
+
+const Entry& Get(int i) { return entries[(head + i) % kCapacity]; }
+
+void Reset() {
+  head = 0;
+  size = 0;
+}
+
+#endif  // HS_RECORD
+
+}  // namespace recorder
+}  // namespace hs
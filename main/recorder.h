@@ -0,0 +1,71 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <stdint.h>
+
+#include "controller.h"
+#include "hall_joystick.h"
+
+// Uncomment to record recent ticks into a RAM ring buffer, retrievable over
+// serial while the controller is running. Left undefined, recording compiles
+// away.
+// #define HS_RECORD
+
+namespace hs {
+namespace recorder {
+
+// Entries kept. Older entries are overwritten. Only ticks whose inputs or
+// report differ from the last recorded tick are kept, so this covers several
+// seconds of button presses, or around a second of continuous stick motion.
+const int kCapacity = 4096;
+
+// Inputs and report of one tick.
+struct Entry {
+  uint32_t micros;
+  uint16_t pins;
+  // Joystick coordinates passed to BuildReport.
+  uint16_t x;
+  uint16_t y;
+  OutputReport report;
+};
+
+// Size of a serialized entry.
+const int kEntrySize = 27;
+
+// Entries are serialized big-endian, field by field, like every other value
+// sent over serial.
+void Serialize(const Entry& entry, uint8_t* bytes);
+Entry Deserialize(const uint8_t* bytes);
+
+#ifdef HS_RECORD
+
+const bool kEnabled = true;
+
+// Record the tick, unless nothing changed since the last recorded tick.
+void Record(uint32_t micros, uint16_t pins,
+            const HallJoystick::Coordinates& coords,
+            const OutputReport& report);
+
+// Number of entries held.
+int Size();
+
+// Entry `i`, oldest first.
+const Entry& Get(int i);
+
+void Reset();
+
+#else
+
+const bool kEnabled = false;
+
+inline void Record(uint32_t, uint16_t, const HallJoystick::Coordinates&,
+                   const OutputReport&) {}
+
+#endif  // HS_RECORD
+
+}  // namespace recorder
+}  // namespace hs
+
+#endif  // RECORDER_H_
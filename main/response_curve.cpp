@@ -0,0 +1,45 @@
+// Copyright 2024 Hiram Silvey
+
+#include "response_curve.h"
+
+#include "math.h"
+
+namespace hs {
+
+ResponseCurve::ResponseCurve() : active_(false), shift_(0), table_{} {}
+
+void ResponseCurve::Configure(const CurvePoint* points, int count,
+                              int full_tilt) {
+  shift_ = 0;
+  while ((full_tilt >> shift_) >= kCurveTableSize) {
+    shift_++;
+  }
+
+  // Walk the segments between the anchors and the usable points.
+  CurvePoint from = {0, 0};
+  int next = 0;
+  const int last = full_tilt >> shift_;
+  for (int i = 0; i <= last; i++) {
+    const double input = 100.0 * (i << shift_) / full_tilt;
+    CurvePoint to = {100, 100};
+    for (; next < count; next++) {
+      const CurvePoint& point = points[next];
+      if (point.input <= from.input || point.input >= 100 ||
+          point.output < 0 || point.output > 100) {
+        continue;
+      }
+      if (point.input >= input) {
+        to = point;
+        break;
+      }
+      from = point;
+    }
+    const double output =
+        from.output + (input - from.input) * (to.output - from.output) /
+                          (to.input - from.input);
+    table_[i] = round(output * full_tilt / 100);
+  }
+  active_ = true;
+}
+
+}  // namespace hs
@@ -0,0 +1,52 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef RESPONSE_CURVE_H_
+#define RESPONSE_CURVE_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace hs {
+
+// Most entries in a response curve table. Axes with a longer reach from
+// neutral index it at a coarser step.
+const int kCurveTableSize = 1025;
+
+// A point of a response curve, as stored in the profile: tilt in and out, in
+// percent of full tilt.
+struct CurvePoint {
+  int input;
+  int output;
+};
+
+// Maps joystick tilt through a response curve. The curve is linear between
+// its points, anchored at neutral and full tilt, and shared by both sides of
+// neutral. It's expanded into a table when configured, so mapping a sample
+// is a single indexed load.
+class ResponseCurve {
+ public:
+  ResponseCurve();
+
+  // Expand `count` points, sorted by input, over an axis which reaches
+  // `full_tilt` output units from neutral. Points out of order or outside
+  // of [0, 100] are skipped.
+  void Configure(const CurvePoint* points, int count, int full_tilt);
+
+  bool IsActive() const { return active_; }
+
+  // Map a tilt, given as its offset from neutral.
+  int Apply(int value) const {
+    const int mapped = table_[abs(value) >> shift_];
+    return value < 0 ? -mapped : mapped;
+  }
+
+ private:
+  bool active_;
+  // Right shift from an offset to its table index.
+  int shift_;
+  uint16_t table_[kCurveTableSize];
+};
+
+}  // namespace hs
+
+#endif  // RESPONSE_CURVE_H_
@@ -0,0 +1,95 @@
+// Copyright 2024 Hiram Silvey
+
+#include "sector_resolver.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "math.h"
+
+namespace hs {
+
+namespace {
+
+// Fractional bits of the boundary sines and cosines. Sample offsets stay
+// within 2^16, so the cross-products fit in an int.
+const int kBoundaryBits = 14;
+
+}  // namespace
+
+SectorResolver::SectorResolver()
+    : active_(false),
+      press_radius_sq_(0),
+      release_radius_sq_(0),
+      cardinal_({}),
+      narrow_({}),
+      wide_({}),
+      sector_(kNeutral) {}
+
+SectorResolver::Boundary SectorResolver::GetBoundary(double degrees) {
+  const double radians = std::clamp(degrees, 0.0, 90.0) * M_PI / 180;
+  return {static_cast<int>(round(cos(radians) * (1 << kBoundaryBits))),
+          static_cast<int>(round(sin(radians) * (1 << kBoundaryBits)))};
+}
+
+void SectorResolver::Configure(const SectorConfig& config, int full_tilt,
+                               int threshold) {
+  const int press_radius = threshold * full_tilt / 100;
+  const int release_radius = std::max(
+      0, (threshold - config.radius_hysteresis) * full_tilt / 100);
+  press_radius_sq_ = static_cast<int64_t>(press_radius) * press_radius;
+  release_radius_sq_ = static_cast<int64_t>(release_radius) * release_radius;
+  const double edge = 45 - config.diagonal_width / 2.0;
+  cardinal_ = GetBoundary(edge);
+  narrow_ = GetBoundary(edge - config.angle_hysteresis);
+  wide_ = GetBoundary(edge + config.angle_hysteresis);
+  sector_ = kNeutral;
+  active_ = true;
+}
+
+SectorResolver::Direction SectorResolver::Update(int x, int y) {
+  const int64_t radius_sq = static_cast<int64_t>(x) * x +
+                            static_cast<int64_t>(y) * y;
+  if (radius_sq < (sector_ == kNeutral ? press_radius_sq_
+                                       : release_radius_sq_)) {
+    sector_ = kNeutral;
+    return {0, 0};
+  }
+
+  // Folded into the first quadrant, where each cardinal sector spans from
+  // its axis to its boundary and the diagonal lies between them.
+  const int abs_x = abs(x);
+  const int abs_y = abs(y);
+  const Boundary& x_edge = sector_ == kCardinalX  ? wide_
+                           : sector_ == kDiagonal ? narrow_
+                                                  : cardinal_;
+  const Boundary& y_edge = sector_ == kCardinalY  ? wide_
+                           : sector_ == kDiagonal ? narrow_
+                                                  : cardinal_;
+  const bool in_x = Within(x_edge, abs_x, abs_y);
+  const bool in_y = Within(y_edge, abs_y, abs_x);
+  if (in_x && in_y) {
+    // Only while a widened sector overlaps the other, which it then keeps.
+    sector_ = sector_ == kCardinalY ? kCardinalY : kCardinalX;
+  } else if (in_x) {
+    sector_ = kCardinalX;
+  } else if (in_y) {
+    sector_ = kCardinalY;
+  } else {
+    sector_ = kDiagonal;
+  }
+
+  const int sign_x = (x > 0) - (x < 0);
+  const int sign_y = (y > 0) - (y < 0);
+  switch (sector_) {
+    case kCardinalX:
+      return {sign_x, 0};
+    case kCardinalY:
+      return {0, sign_y};
+    default:
+      return {sign_x, sign_y};
+  }
+}
+
+}  // namespace hs
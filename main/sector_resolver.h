@@ -0,0 +1,77 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef SECTOR_RESOLVER_H_
+#define SECTOR_RESOLVER_H_
+
+#include <stdint.h>
+
+namespace hs {
+
+// Angular digital mode tuning, as stored in the profile.
+struct SectorConfig {
+  // Width of each diagonal sector in degrees. Cardinal sectors take the rest
+  // of each quadrant, so 0 gives 4-way output.
+  int diagonal_width;
+  // Degrees the current sector stretches into its neighbours before the
+  // output changes.
+  int angle_hysteresis;
+  // Percent of full tilt below the activation radius the stick must fall
+  // back to before the output returns to neutral.
+  int radius_hysteresis;
+};
+
+// Resolves the joystick into one of 8 digital directions by its angle and
+// radius, rather than thresholding each axis. Sector boundaries are stored
+// as integer sine and cosine pairs, so a sample is placed with a few
+// cross-products and no trig or division.
+class SectorResolver {
+ public:
+  // Each axis of a direction is -1, 0 or 1.
+  struct Direction {
+    int x;
+    int y;
+  };
+
+  SectorResolver();
+
+  // `full_tilt` is the distance from neutral to either end of each axis, in
+  // output units, and `threshold` the activation radius in percent of it.
+  void Configure(const SectorConfig& config, int full_tilt, int threshold);
+
+  bool IsActive() const { return active_; }
+
+  // Resolve a sample, given as its offset from neutral.
+  Direction Update(int x, int y);
+
+ private:
+  enum Sector { kNeutral, kCardinalX, kCardinalY, kDiagonal };
+
+  // Angle from an axis, scaled by 2^kBoundaryBits.
+  struct Boundary {
+    int cos;
+    int sin;
+  };
+
+  static Boundary GetBoundary(double degrees);
+
+  // Whether the sample (major, minor) is closer to the major axis than
+  // `boundary`.
+  static bool Within(const Boundary& boundary, int major, int minor) {
+    return minor * boundary.cos < major * boundary.sin;
+  }
+
+  bool active_;
+  // Squared activation and release radii.
+  int64_t press_radius_sq_;
+  int64_t release_radius_sq_;
+  // Edge of the cardinal sectors, from their axis: as configured, narrowed
+  // while in a diagonal and widened while in the cardinal itself.
+  Boundary cardinal_;
+  Boundary narrow_;
+  Boundary wide_;
+  Sector sector_;
+};
+
+}  // namespace hs
+
+#endif  // SECTOR_RESOLVER_H_
@@ -0,0 +1,58 @@
+// Copyright 2024 Hiram Silvey
+
+#include "snapback_filter.h"
+
+#include <stdlib.h>
+
+namespace hs {
+
+SnapbackFilter::SnapbackFilter()
+    : velocity_(0),
+      max_overshoot_(0),
+      window_micros_(0),
+      last_value_(0),
+      last_micros_(0),
+      last_side_(0),
+      held_side_(0),
+      held_since_(0) {}
+
+void SnapbackFilter::Configure(const SnapbackConfig& config, int full_tilt) {
+  velocity_ = config.velocity * full_tilt / 100;
+  max_overshoot_ = config.max_overshoot * full_tilt / 100;
+  window_micros_ = config.window * 1000;
+  held_side_ = 0;
+}
+
+int SnapbackFilter::Update(int value, uint32_t now) {
+  const int side = (value > 0) - (value < 0);
+  const int delta = abs(value - last_value_);
+  const uint32_t elapsed = now - last_micros_;
+  const int last_side = last_side_;
+  last_value_ = value;
+  last_micros_ = now;
+  if (side != 0) {
+    last_side_ = side;
+  }
+
+  if (held_side_ != 0) {
+    if (side == held_side_ && abs(value) <= max_overshoot_ &&
+        now - held_since_ < window_micros_) {
+      return 0;
+    }
+    held_side_ = 0;
+  }
+
+  // Compared as units per millisecond without dividing.
+  if (side != 0 && side == -last_side &&
+      static_cast<int64_t>(delta) * 1000 >=
+          static_cast<int64_t>(velocity_) * elapsed) {
+    if (abs(value) <= max_overshoot_) {
+      held_side_ = side;
+      held_since_ = now;
+      return 0;
+    }
+  }
+  return value;
+}
+
+}  // namespace hs
@@ -0,0 +1,62 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef SNAPBACK_FILTER_H_
+#define SNAPBACK_FILTER_H_
+
+#include <stdint.h>
+
+namespace hs {
+
+// Snapback filter tuning, as stored in the profile.
+struct SnapbackConfig {
+  // Speed toward neutral, in percent of full tilt per millisecond, at or
+  // above which crossing neutral is taken to be a release. 0 disables the
+  // filter.
+  int velocity;
+  // Furthest past neutral, in percent of full tilt, an overshoot is held at
+  // neutral. Anything further is a real change of direction.
+  int max_overshoot;
+  // Longest an overshoot is held at neutral, in milliseconds.
+  int window;
+};
+
+// Holds one joystick axis at neutral while it overshoots after a release.
+// Released from a tilt, the stick's spring carries it past neutral for a few
+// milliseconds, which games can read as a brief input in the opposite
+// direction. When the axis crosses neutral at least as fast as the
+// configured velocity, output on the far side is held at neutral until the
+// axis comes back, the window runs out, or it goes further than an
+// overshoot can, in which case it passes through at once.
+class SnapbackFilter {
+ public:
+  SnapbackFilter();
+
+  // `full_tilt` is the distance from neutral to either end of the axis, in
+  // output units.
+  void Configure(const SnapbackConfig& config, int full_tilt);
+
+  bool IsActive() const { return velocity_ > 0; }
+
+  // Filter a sample taken at `now`, given as its offset from neutral.
+  // Returns the offset to output.
+  int Update(int value, uint32_t now);
+
+ private:
+  // In output units per millisecond.
+  int velocity_;
+  int max_overshoot_;
+  uint32_t window_micros_;
+
+  int last_value_;
+  uint32_t last_micros_;
+  // Side of neutral of the last sample off neutral: -1 or 1, or 0 before
+  // the first.
+  int last_side_;
+  // Side being held at neutral, or 0 while nothing is held.
+  int held_side_;
+  uint32_t held_since_;
+};
+
+}  // namespace hs
+
+#endif  // SNAPBACK_FILTER_H_
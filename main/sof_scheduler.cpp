@@ -0,0 +1,122 @@
+// Copyright 2024 Hiram Silvey
+
+#include "sof_scheduler.h"
+
+namespace hs {
+
+namespace {
+
+// Fraction bits of the period.
+const int kPeriodShift = 4;
+
+// A gap this long means USB was suspended or reset, so the frames are
+// learned again from scratch.
+const uint32_t kMaxGapMicros = 65535;
+
+// Frames which may go unseen between two SOFs before the period is learned
+// again.
+const uint32_t kMaxMissedFrames = 8;
+
+// Widest bounds on an SOF that are learned from before locking on. Wider
+// ones come from a tick which was busy, e.g. reading the sensor, when the
+// frame started.
+const uint32_t kMaxSofUncertaintyMicros = 20;
+
+}  // namespace
+
+SofScheduler::SofScheduler(uint32_t margin_micros)
+    : margin_micros_(margin_micros),
+      has_sof_(false),
+      last_sof_(0),
+      frame_(0),
+      period_(0),
+      steady_frames_(0),
+      built_for_(0) {}
+
+void SofScheduler::OnSof(uint32_t not_before, uint32_t micros) {
+  const uint32_t elapsed = micros - last_sof_;
+  const bool had_sof = has_sof_;
+  has_sof_ = true;
+  if (!had_sof || elapsed > kMaxGapMicros) {
+    last_sof_ = micros;
+    period_ = 0;
+    steady_frames_ = 0;
+    frame_++;
+    return;
+  }
+
+  uint32_t sof = micros;
+  uint32_t frames;
+  if (IsLocked()) {
+    // The SOF may have come any time within the bounds, so the latest
+    // predicted one within them is kept. Failing that, the bound closest to
+    // a predicted SOF is taken.
+    frames = FramesSince(micros);
+    const uint32_t latest = last_sof_ + ((frames * period_) >> kPeriodShift);
+    if (frames == 0 || static_cast<int32_t>(latest - not_before) < 0) {
+      const uint32_t next =
+          last_sof_ + (((frames + 1) * period_) >> kPeriodShift);
+      if (frames > 0 && not_before - latest < next - micros) {
+        sof = not_before;
+      } else {
+        frames++;
+      }
+    } else {
+      sof = latest;
+    }
+  } else {
+    // Until locked, only SOFs seen soon after they came are learned from.
+    if (micros - not_before > kMaxSofUncertaintyMicros) {
+      return;
+    }
+    const uint32_t interval = elapsed << kPeriodShift;
+    frames = period_ == 0 ? 1 : (interval + period_ / 2) / period_;
+  }
+  if (frames == 0 || frames > kMaxMissedFrames) {
+    last_sof_ = sof;
+    period_ = elapsed << kPeriodShift;
+    steady_frames_ = 0;
+    frame_++;
+    return;
+  }
+  frame_ += frames;
+
+  const uint32_t measured = ((sof - last_sof_) << kPeriodShift) / frames;
+  last_sof_ = sof;
+  if (period_ == 0 || measured > period_ + period_ / 8 ||
+      measured < period_ - period_ / 8) {
+    period_ = measured;
+    steady_frames_ = 0;
+    return;
+  }
+  // Average out the jitter of when each SOF is noticed.
+  period_ = period_ + static_cast<int32_t>(measured - period_) / 8;
+  if (steady_frames_ < kSofLockFrames) {
+    steady_frames_++;
+  }
+}
+
+uint32_t SofScheduler::FramesSince(uint32_t now) const {
+  return ((now - last_sof_) << kPeriodShift) / period_;
+}
+
+uint32_t SofScheduler::NextSof(uint32_t now) const {
+  return last_sof_ + (((FramesSince(now) + 1) * period_) >> kPeriodShift);
+}
+
+bool SofScheduler::IsDue(uint32_t now) {
+  if (!IsLocked() || now - last_sof_ > kMaxGapMicros ||
+      margin_micros_ >= period_ >> kPeriodShift) {
+    return true;
+  }
+  const uint32_t frames = FramesSince(now) + 1;
+  const uint32_t next = last_sof_ + ((frames * period_) >> kPeriodShift);
+  const uint32_t target = frame_ + frames;
+  if (next - now > margin_micros_ || target == built_for_) {
+    return false;
+  }
+  built_for_ = target;
+  return true;
+}
+
+}  // namespace hs
@@ -0,0 +1,69 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef SOF_SCHEDULER_H_
+#define SOF_SCHEDULER_H_
+
+#include <stdint.h>
+
+namespace hs {
+
+// Time left before the predicted host poll when the report is built. Covers
+// the pin snapshot, the report build and the send. Define
+// HS_SOF_MARGIN_MICROS to tune it for a slower or faster loop.
+#ifndef HS_SOF_MARGIN_MICROS
+#define HS_SOF_MARGIN_MICROS 50
+#endif
+const uint32_t kSofMarginMicros = HS_SOF_MARGIN_MICROS;
+
+// Consecutive frames of a steady period needed before the scheduler trusts
+// its prediction.
+const int kSofLockFrames = 8;
+
+// Learns the phase and period of USB start-of-frame from SOF timestamps, and
+// decides when each tick's report should be built so it is ready a margin
+// before the next host poll. Until it locks on, and whenever it loses the
+// frames, every tick is due.
+class SofScheduler {
+ public:
+  explicit SofScheduler(uint32_t margin_micros);
+
+  // Record a start-of-frame seen at `micros`. Frames missed between calls are
+  // inferred from the period.
+  void OnSof(uint32_t micros) { OnSof(micros, micros); }
+
+  // Same as above, for a start-of-frame only known to have come after
+  // `not_before`, e.g. when it was noticed once a sensor read ended. Until
+  // locked, such a start-of-frame is ignored unless the bounds are narrow.
+  // Once locked, the predicted phase is kept wherever it falls within them.
+  void OnSof(uint32_t not_before, uint32_t micros);
+
+  bool IsLocked() const { return steady_frames_ >= kSofLockFrames; }
+
+  // Predicted time of the first start-of-frame after `now`. Only meaningful
+  // once locked.
+  uint32_t NextSof(uint32_t now) const;
+
+  // Whether the report for the next host poll should be built at `now`. Once
+  // locked, true on the first call within the margin of each frame.
+  bool IsDue(uint32_t now);
+
+ private:
+  // Frames since the last SOF seen at `now`, rounded down.
+  uint32_t FramesSince(uint32_t now) const;
+
+  uint32_t margin_micros_;
+  bool has_sof_;
+  uint32_t last_sof_;
+  // Frames counted since the first SOF, including inferred ones.
+  uint32_t frame_;
+  // Frame period, in 1/16 microseconds so 125us microframes keep their
+  // precision. Zero until the first interval.
+  uint32_t period_;
+  int steady_frames_;
+  // Frame the last report was built for.
+  uint32_t built_for_;
+};
+
+}  // namespace hs
+
+#endif  // SOF_SCHEDULER_H_
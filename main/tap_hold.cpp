@@ -0,0 +1,98 @@
+// Copyright 2024 Hiram Silvey
+
+#include "tap_hold.h"
+
+#include "pins.h"
+
+namespace hs {
+
+TapHold::TapHold()
+    : mask_(0),
+      layer_mask_(0),
+      term_micros_(kDefaultTapHoldTermMicros),
+      last_pins_(0),
+      state_{},
+      since_{},
+      interrupts_{},
+      held_back_(0),
+      replayed_(0),
+      replayed_since_(0) {}
+
+void TapHold::Configure(uint16_t pins, uint32_t term_micros,
+                        uint16_t layer_pins) {
+  mask_ = pins;
+  layer_mask_ = layer_pins & pins;
+  term_micros_ = term_micros;
+  held_back_ = 0;
+  replayed_ = 0;
+  // Pins already held when the layout is swapped in only count once they
+  // are pressed again.
+  for (int pin = 0; pin < pins::kNumPins; pin++) {
+    state_[pin] = kIdle;
+  }
+}
+
+uint32_t TapHold::Update(uint16_t pins, uint32_t now) {
+  const uint16_t pressed = pins & ~last_pins_;
+  const uint16_t released = last_pins_ & ~pins;
+  last_pins_ = pins;
+  if (replayed_ != 0 && now - replayed_since_ >= kTapMicros) {
+    replayed_ = 0;
+  }
+
+  uint32_t outputs = 0;
+  held_back_ = 0;
+  for (uint16_t rest = mask_; rest != 0; rest &= rest - 1) {
+    const int pin = __builtin_ctz(rest);
+    const uint16_t bit = 1 << pin;
+    const bool was_pending = state_[pin] == kPending;
+    switch (state_[pin]) {
+      case kTap:
+        if (now - since_[pin] >= kTapMicros) {
+          state_[pin] = kIdle;
+        }
+        [[fallthrough]];
+      case kIdle:
+        if (pressed & bit) {
+          state_[pin] = kPending;
+          since_[pin] = now;
+          // Pins pressed in the same snapshot count as pressed after it.
+          interrupts_[pin] = pressed & ~bit;
+        }
+        break;
+      case kPending:
+        interrupts_[pin] |= pressed & ~bit;
+        if (released & bit) {
+          state_[pin] = kTap;
+          since_[pin] = now;
+        } else if (now - since_[pin] >= term_micros_ ||
+                   (interrupts_[pin] & released)) {
+          state_[pin] = kHold;
+        }
+        break;
+      case kHold:
+        if (released & bit) {
+          state_[pin] = kIdle;
+        }
+        break;
+    }
+
+    if (layer_mask_ & bit) {
+      if (state_[pin] == kPending) {
+        held_back_ |= interrupts_[pin];
+      } else if (was_pending && (interrupts_[pin] & ~pins)) {
+        replayed_ |= interrupts_[pin] & ~pins;
+        replayed_since_ = now;
+      }
+    }
+
+    if (state_[pin] == kHold) {
+      outputs |= 1u << pin;
+    } else if (state_[pin] == kTap) {
+      outputs |= 1u << TapInput(pin);
+    }
+  }
+  return outputs;
+}
+
+}  // namespace hs
@@ -0,0 +1,81 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef TAP_HOLD_H_
+#define TAP_HOLD_H_
+
+#include <stdint.h>
+
+#include "pins.h"
+
+namespace hs {
+
+// Inputs a layout can map actions to. Input N below kNumPins is pin N, or the
+// hold output of pin N if it has a TapHoldAction. Input kNumPins + N is the
+// tap output of pin N.
+const int kNumInputs = 2 * pins::kNumPins;
+
+// Hold term used when the layout doesn't set one.
+const uint32_t kDefaultTapHoldTermMicros = 200000;
+
+// How long a tap is output for after the button is released. Long enough for
+// hosts which only sample the report once per 60Hz frame to see it.
+const uint32_t kTapMicros = 20000;
+
+// Tap output of the pin.
+constexpr int TapInput(int pin) { return pins::kNumPins + pin; }
+
+// Resolves tap-hold pins into their tap and hold outputs. Each pin has a
+// fixed-size state machine driven by the pin snapshot and the microsecond
+// clock, so updating it never blocks.
+class TapHold {
+ public:
+  TapHold();
+
+  // Set the tap-hold pins and the hold term, resetting every pin.
+  // `layer_pins` are the tap-hold pins whose hold switches layer.
+  void Configure(uint16_t pins, uint32_t term_micros, uint16_t layer_pins = 0);
+
+  // Whether any pin is a tap-hold pin.
+  bool IsActive() const { return mask_ != 0; }
+
+  // Advance every tap-hold pin given the pin snapshot taken at `now`. Returns
+  // the tap and hold outputs, as a bitfield indexed by input. Pins that
+  // aren't tap-hold pins are left out.
+  uint32_t Update(uint16_t pins, uint32_t now);
+
+  // The pin snapshot as the layout should see it. Other pins pressed while a
+  // layer pin is pending are held back until it resolves, so they act on the
+  // layer it resolves to. Those released in the meantime are then output
+  // for kTapMicros, as a tap would be.
+  uint16_t Filter(uint16_t pins) const {
+    return (pins & ~held_back_) | replayed_;
+  }
+
+ private:
+  enum State : uint8_t {
+    kIdle,
+    // Pressed, waiting to tell a tap from a hold.
+    kPending,
+    kHold,
+    // Released as a tap, outputting the tap until kTapMicros pass.
+    kTap,
+  };
+
+  uint16_t mask_;
+  uint16_t layer_mask_;
+  uint32_t term_micros_;
+  uint16_t last_pins_;
+  State state_[pins::kNumPins];
+  uint32_t since_[pins::kNumPins];
+  // Other pins pressed with or while the pin is pending. Releasing any of
+  // them before the term resolves the pin as a hold.
+  uint16_t interrupts_[pins::kNumPins];
+  // Pins held back and replayed by Filter(), and when the replay began.
+  uint16_t held_back_;
+  uint16_t replayed_;
+  uint32_t replayed_since_;
+};
+
+}  // namespace hs
+
+#endif  // TAP_HOLD_H_
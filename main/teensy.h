@@ -3,6 +3,8 @@
 #ifndef TEENSY_H_
 #define TEENSY_H_
 
+#include "edge_capture.h"
+
 namespace hs {
 
 class Teensy {
@@ -11,6 +13,8 @@ class Teensy {
 
   // Arduino
   virtual bool DigitalReadLow(uint8_t pin) const = 0;
+  // Pop the oldest button edge captured by the pin-change interrupts.
+  virtual bool PopPinEdge(edge_capture::Edge& edge) const = 0;
   virtual void Exit(int status) const = 0;
 
   // Arduino: Math
@@ -26,6 +30,12 @@ class Teensy {
   virtual unsigned long Millis() const = 0;
   virtual unsigned long Micros() const = 0;
 
+  // Cortex-M7
+  virtual uint32_t CycleCount() const = 0;
+
+  // USB: Frame index, which changes at every start-of-frame.
+  virtual uint32_t UsbFrameIndex() const = 0;
+
   // Arduino: Joystick
   virtual void JoystickUseManualSend() const = 0;
   virtual void SetJoystickX(int val) const = 0;
@@ -37,6 +47,8 @@ class Teensy {
   virtual void SetJoystickButton(uint8_t pin, bool active) const = 0;
   virtual void SetJoystickHat(int angle) const = 0;
   virtual void JoystickSendNow() const = 0;
+  // Send a whole joystick report in one call, bypassing the setters.
+  virtual void JoystickSendReport(const uint8_t* report, int size) const = 0;
 
   // EEPROM
   virtual uint8_t EEPROMRead(int addr) const = 0;
@@ -47,6 +59,10 @@ class Teensy {
   virtual float GetHallX() = 0;
   virtual float GetHallY() = 0;
   virtual float GetHallZ() = 0;
+
+  // Joybus
+  virtual int JoybusReceive(uint8_t* bytes, int max_size) const = 0;
+  virtual void JoybusSend(const uint8_t* bytes, int size) const = 0;
 };
 
 }  // namespace hs
@@ -5,13 +5,17 @@
 
 #include <EEPROM.h>
 #include <Tlv493d.h>
+#include <string.h>
 
 #include "Arduino.h"
+#include "joybus.h"
+#include "pc_hid.h"
+#include "pins.h"
 #include "teensy.h"
 
 namespace hs {
 
-class TeensyImpl : public Teensy {
+class TeensyImpl final : public Teensy {
  public:
   TeensyImpl() {
     sensor_.begin();
@@ -21,6 +25,13 @@ class TeensyImpl : public Teensy {
   inline bool DigitalReadLow(uint8_t pin) const override {
     return digitalRead(pin) == LOW;
   }
+  inline bool PopPinEdge(edge_capture::Edge& edge) const override {
+#ifdef HS_EDGE_CAPTURE
+    return edge_capture::PinEdges().Pop(edge);
+#else
+    return false;
+#endif
+  }
   inline void Exit(int status) const override { exit(status); }
 
   inline int Constrain(int amount, int low, int high) const override {
@@ -37,6 +48,10 @@ class TeensyImpl : public Teensy {
   inline unsigned long Millis() const override { return millis(); }
   inline unsigned long Micros() const override { return micros(); }
 
+  inline uint32_t CycleCount() const override { return ARM_DWT_CYCCNT; }
+
+  inline uint32_t UsbFrameIndex() const override { return USB1_FRINDEX; }
+
   inline void JoystickUseManualSend() const override {
     Joystick.useManualSend(true);
   }
@@ -57,6 +72,18 @@ class TeensyImpl : public Teensy {
   }
   inline void SetJoystickHat(int angle) const override { Joystick.hat(angle); }
   inline void JoystickSendNow() const override { Joystick.send_now(); }
+  inline void JoystickSendReport(const uint8_t* report,
+                                 int size) const override {
+#ifdef HS_PC_HIRES
+    // Only ever sent a HiResReport, which must fill the endpoint exactly.
+    static_assert(JOYSTICK_SIZE == sizeof(HiResReport),
+                  "Set JOYSTICK_SIZE in the Teensy core's usb_desc.h to "
+                  "sizeof(HiResReport)");
+    memcpy(usb_joystick_data, report, size);
+    usb_joystick_send();
+#endif
+    // Otherwise the stock report is only built through the setters above.
+  }
 
   inline uint8_t EEPROMRead(int addr) const override {
     return EEPROM.read(addr);
@@ -70,6 +97,63 @@ class TeensyImpl : public Teensy {
   inline float GetHallY() override { return sensor_.getY(); }
   inline float GetHallZ() override { return sensor_.getZ(); }
 
+  // Called on the falling edge of a command's first bit, so the line is
+  // expected to be low already. Bits are timed off the cycle counter. Known
+  // commands end on the rising edge of their stop bit, so the response can
+  // start right away; unknown ones end once the line idles.
+  inline int JoybusReceive(uint8_t* bytes, int max_size) const override {
+    const uint32_t cycles_per_us = F_CPU_ACTUAL / 1000000;
+    // The line idles high for longer than any gap within a command.
+    const uint32_t idle_cycles = 5 * cycles_per_us;
+    uint16_t low_ns[joybus::kMaxCommandSize * 8 + 1];
+    // Low pulses expected, including the stop bit, once the first byte
+    // gives the command's length.
+    int expected = joybus::kMaxCommandSize * 8 + 1;
+    int count = 0;
+    if (digitalReadFast(pins::kJoybus)) {
+      // Edge from our own response; nothing to receive.
+      return 0;
+    }
+    while (count < expected) {
+      uint32_t start = ARM_DWT_CYCCNT;
+      while (!digitalReadFast(pins::kJoybus)) {
+        if (ARM_DWT_CYCCNT - start > idle_cycles) {
+          return 0;
+        }
+      }
+      low_ns[count++] = (ARM_DWT_CYCCNT - start) * 1000 / cycles_per_us;
+      if (count == expected) {
+        break;
+      }
+      if (count == 8) {
+        const int pulses = joybus::CommandPulses(low_ns);
+        if (pulses > 0) {
+          expected = pulses;
+        }
+      }
+      start = ARM_DWT_CYCCNT;
+      while (digitalReadFast(pins::kJoybus)) {
+        if (ARM_DWT_CYCCNT - start > idle_cycles) {
+          return joybus::DecodeBits(low_ns, count, bytes, max_size);
+        }
+      }
+    }
+    return joybus::DecodeBits(low_ns, count, bytes, max_size);
+  }
+  inline void JoybusSend(const uint8_t* bytes, int size) const override {
+    joybus::Pulse pulses[joybus::kMaxPulses];
+    const int count = joybus::EncodeWaveform(bytes, size, pulses);
+    const uint32_t cycles_per_us = F_CPU_ACTUAL / 1000000;
+    uint32_t deadline = ARM_DWT_CYCCNT;
+    for (int i = 0; i < count; i++) {
+      // The pin is open drain, so writing high releases the line.
+      digitalWriteFast(pins::kJoybus, pulses[i].high ? HIGH : LOW);
+      deadline += pulses[i].duration_ns * cycles_per_us / 1000;
+      while (static_cast<int32_t>(ARM_DWT_CYCCNT - deadline) < 0) {
+      }
+    }
+  }
+
  private:
   Tlv493d sensor_;
 };
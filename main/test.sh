@@ -5,12 +5,28 @@
 src_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" &>/dev/null && pwd)"
 cd "$src_dir/build"
 cmake .. && cmake --build . --verbose && {
+	./alloc_test
+	./axis_resolver_test
 	./configurator_test
 	./controller_test
+	./debouncer_test
 	./decoder_test
+	./edge_capture_test
+	./gamecube_controller_test
 	./hall_joystick_test
+	./joybus_test
+	./latency_tracer_test
+	./macro_engine_test
 	./ns_controller_test
 	./pc_controller_test
 	./pins_test
+	./profiler_test
+	./recorder_test
+	./sim_test
+	./response_curve_test
+	./sector_resolver_test
+	./snapback_filter_test
+	./sof_scheduler_test
+	./tap_hold_test
 	./util_test
 }
@@ -0,0 +1,148 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "ns_controller.h"
+#include "pc_controller.h"
+#include "test/sim_nspad.h"
+#include "test/sim_teensy.h"
+
+namespace {
+
+// Heap allocations made while counting is enabled.
+bool counting = false;
+int allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (counting) {
+    allocations++;
+  }
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace hs {
+
+namespace {
+
+const int kTicks = 1000000;
+const unsigned long kTickMicros = 125;
+
+// One profile at position 1 for both PC and Switch, with a MOD layer and
+// analog actions. Taken from the decoder tests.
+const std::vector<uint8_t> kProfiles = {
+    192,  // 11000000; PC + Switch
+    17,   // 0001 0001; Position = 1, Position = 1
+    33,   // Body length
+    50,   // Joystick threshold
+    // Base layer
+    0, 16, 131, 132, 1, 32, 146, 139, 136, 2, 65, 20, 147, 140, 3, 96,
+    // Mod layer
+    0, 16, 131, 132, 1, 32, 146, 139, 136, 2, 65, 20, 147, 140, 3, 96};
+
+// PushProfile command carrying the base layer above, not persisted.
+const std::vector<uint8_t> kPushProfile = {
+    0,   // PushProfile
+    0,   // Don't persist
+    17,  // Body length
+    50, 0, 16, 131, 132, 1, 32, 146, 139, 136, 2, 65, 20, 147, 140, 3, 96};
+
+// Run the function, returning the number of heap allocations it made.
+template <typename F>
+int CountAllocations(F&& f) {
+  allocations = 0;
+  counting = true;
+  f();
+  counting = false;
+  return allocations;
+}
+
+// Move the stick between two positions every 50ms for the whole run.
+void AddHallSamples(SimTeensy& teensy) {
+  for (unsigned long t = 0; t < kTicks * kTickMicros; t += 100000) {
+    teensy.AddHallSample({.micros = t, .x = 0.0006, .y = -0.0003, .z = 1});
+    teensy.AddHallSample(
+        {.micros = t + 50000, .x = -0.0002, .y = 0.0008, .z = 1});
+  }
+}
+
+// Run the controller with every pin changing state over time, pushing a
+// profile halfway through, and return the allocations made by Loop().
+// Reports are dropped after each tick so the simulator's own storage
+// doesn't grow.
+template <typename Controller, typename Reports>
+int RunTicks(Controller& controller, SimTeensy& teensy, Reports& reports) {
+  int total = 0;
+  for (int tick = 0; tick < kTicks; tick++) {
+    teensy.SetPins((tick / 8 * 0x9E37) & 0xFFFF);
+    if (tick == kTicks / 2) {
+      teensy.QueueSerial(kPushProfile);
+    }
+    total += CountAllocations([&] { controller.Loop(); });
+    teensy.Advance(kTickMicros);
+    reports.ClearReports();
+    teensy.ClearSerialOut();
+  }
+  return total;
+}
+
+// Let the simulator's capture buffers grow to size before counting.
+template <typename Controller, typename Reports>
+void WarmUp(Controller& controller, SimTeensy& teensy, Reports& reports) {
+  teensy.QueueSerial({2});  // SendLatencyStats
+  controller.Loop();
+  reports.ClearReports();
+  teensy.ClearSerialOut();
+}
+
+}  // namespace
+
+TEST(AllocTest, PCController_Loop) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim, kProfiles);
+  AddHallSamples(*sim);
+  PCController controller(std::move(teensy));
+  WarmUp(controller, *sim, *sim);
+
+  EXPECT_EQ(RunTicks(controller, *sim, *sim), 0);
+}
+
+TEST(AllocTest, NSController_Loop) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  auto nspad = std::make_unique<SimNSPad>(*sim);
+  SimNSPad* pad = nspad.get();
+  Flash(*sim, kProfiles);
+  AddHallSamples(*sim);
+  NSController controller(std::move(teensy), std::move(nspad));
+  WarmUp(controller, *sim, *pad);
+
+  EXPECT_EQ(RunTicks(controller, *sim, *pad), 0);
+}
+
+TEST(AllocTest, LoadProfile) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim, kProfiles);
+  AddHallSamples(*sim);
+  PCController controller(std::move(teensy));
+
+  EXPECT_EQ(CountAllocations([&] { controller.LoadProfile(); }), 0);
+}
+
+}  // namespace hs
@@ -0,0 +1,131 @@
+#include "axis_resolver.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "controller.h"
+#include "profile.pb.h"
+
+namespace hs {
+
+namespace {
+
+const int kNeutral = 512;
+const int kMax = 1023;
+
+// Two light shield presets and a button on the other side of neutral.
+const AnalogButtons kButtons = {{.value = 1022, .pin = 3},
+                                {.value = 598, .pin = 5},
+                                {.value = 100, .pin = 8}};
+
+}  // namespace
+
+TEST(AxisResolverTest, Default) {
+  AxisResolver resolver;
+
+  EXPECT_EQ(resolver.Resolve(0xFFFF), 0);
+}
+
+TEST(AxisResolverTest, NothingHeld) {
+  AxisResolver resolver(kButtons,
+                        hs_profile_Profile_Layout_AxisPolicy_SUM_CLAMPED,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(0), kNeutral);
+  EXPECT_EQ(resolver.Resolve(1 << 4), kNeutral);
+}
+
+TEST(AxisResolverTest, OpposingCancel) {
+  AxisResolver resolver(kButtons,
+                        hs_profile_Profile_Layout_AxisPolicy_OPPOSING_CANCEL,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(1 << 5), 598);
+  EXPECT_EQ(resolver.Resolve(1 << 3 | 1 << 5), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 8), kNeutral);
+  EXPECT_EQ(resolver.Resolve(1 << 8), 100);
+}
+
+TEST(AxisResolverTest, OpposingCancel_MatchesResolveSOCD) {
+  AxisResolver resolver(kButtons,
+                        hs_profile_Profile_Layout_AxisPolicy_OPPOSING_CANCEL,
+                        kNeutral, kMax);
+
+  for (int held = 0; held < 1 << 3; held++) {
+    const uint16_t pins = (held & 1 ? 1 << 3 : 0) | (held & 2 ? 1 << 5 : 0) |
+                          (held & 4 ? 1 << 8 : 0);
+    EXPECT_EQ(resolver.Resolve(pins), ResolveSOCD(pins, kButtons, kNeutral));
+  }
+}
+
+TEST(AxisResolverTest, Highest) {
+  AxisResolver resolver(kButtons, hs_profile_Profile_Layout_AxisPolicy_HIGHEST,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(1 << 3 | 1 << 5), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 8), 598);
+  EXPECT_EQ(resolver.Resolve(1 << 8), 100);
+}
+
+TEST(AxisResolverTest, Lowest) {
+  AxisResolver resolver(kButtons, hs_profile_Profile_Layout_AxisPolicy_LOWEST,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(1 << 3 | 1 << 5), 598);
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 8), 100);
+  EXPECT_EQ(resolver.Resolve(1 << 3), 1022);
+}
+
+TEST(AxisResolverTest, SumClamped) {
+  AxisResolver resolver(kButtons,
+                        hs_profile_Profile_Layout_AxisPolicy_SUM_CLAMPED,
+                        kNeutral, kMax);
+
+  // 512 + 510 + 86
+  EXPECT_EQ(resolver.Resolve(1 << 3 | 1 << 5), kMax);
+  // 512 + 86 - 412
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 8), 186);
+  EXPECT_EQ(resolver.Resolve(1 << 8), 100);
+}
+
+TEST(AxisResolverTest, SumClamped_Min) {
+  const AnalogButtons buttons = {{.value = 100, .pin = 0},
+                                 {.value = 0, .pin = 1}};
+  AxisResolver resolver(buttons,
+                        hs_profile_Profile_Layout_AxisPolicy_SUM_CLAMPED,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(0b11), 0);
+}
+
+TEST(AxisResolverTest, LastPressed) {
+  AxisResolver resolver(kButtons,
+                        hs_profile_Profile_Layout_AxisPolicy_LAST_PRESSED,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(1 << 5), 598);
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 3), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 3 | 1 << 8), 100);
+  // Releasing the latest button falls back to the one pressed before it.
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 3), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 5), 598);
+  // Pressing an older button again makes it the latest.
+  EXPECT_EQ(resolver.Resolve(1 << 5 | 1 << 3), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 3), 1022);
+  EXPECT_EQ(resolver.Resolve(1 << 3 | 1 << 5), 598);
+  EXPECT_EQ(resolver.Resolve(0), kNeutral);
+}
+
+TEST(AxisResolverTest, MoreButtonsThanTable) {
+  AnalogButtons buttons;
+  for (int pin = 0; pin < kMaxTableButtons + 2; pin++) {
+    buttons.push_back({.value = 600 + pin, .pin = pin});
+  }
+  AxisResolver resolver(buttons, hs_profile_Profile_Layout_AxisPolicy_LOWEST,
+                        kNeutral, kMax);
+
+  EXPECT_EQ(resolver.Resolve(0b1111000), 603);
+  EXPECT_EQ(resolver.Resolve(0b1000000), 606);
+}
+
+}  // namespace hs
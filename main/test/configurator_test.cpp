@@ -3,15 +3,28 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <vector>
+
+#include "decoder.h"
+#include "latency_tracer.h"
+#include "pins.h"
+#include "profile.pb.h"
+#include "test/mock_controller.h"
 #include "test/mock_teensy.h"
 
 namespace hs {
 
 using ::testing::_;
+using ::testing::AllOf;
 using ::testing::Args;
+using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::Field;
 using ::testing::InSequence;
 using ::testing::Return;
+using ::testing::ReturnRef;
+
+using Layout = ::hs_profile_Profile_Layout;
 
 TEST(ConfiguratorTest, FetchStoredBounds) {
   MockTeensy teensy;
@@ -166,6 +179,68 @@ TEST(ConfiguratorTest, SaveCalibration_SerialUnavailable) {
   configurator::internal::SaveCalibration(teensy);
 }
 
+TEST(ConfiguratorTest, PreviewCalibration) {
+  MockTeensy teensy;
+
+  // Calibration taken from the HallJoystick tests, with an analog joystick and
+  // a single sample.
+  const uint8_t request[17] = {0, 0, 0, 10, 0, 0, 0, 10, 0,
+                               0, 0, 100, 1, 244, 0, 0, 1};
+  EXPECT_CALL(teensy, SerialAvailable).WillRepeatedly(Return(true));
+  {
+    InSequence seq;
+    for (const uint8_t byte : request) {
+      EXPECT_CALL(teensy, SerialRead).WillOnce(Return(byte));
+    }
+  }
+  EXPECT_CALL(teensy, EEPROMRead).Times(0);
+  EXPECT_CALL(teensy, Micros).WillRepeatedly(Return(600));
+  EXPECT_CALL(teensy, UpdateHallData);
+  EXPECT_CALL(teensy, GetHallZ).WillOnce(Return(1));
+  EXPECT_CALL(teensy, GetHallX).WillOnce(Return(0.00005));
+  EXPECT_CALL(teensy, GetHallY).WillOnce(Return(0.00005));
+  EXPECT_CALL(teensy, Constrain)
+      .WillRepeatedly([](int amount, int, int) { return amount; });
+  uint8_t expected_x[2] = {3, 54};  // 822
+  uint8_t expected_y[2] = {1, 204};  // 460
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialWrite(_, 2))
+        .With(Args<0, 1>(ElementsAreArray(expected_x)));
+    EXPECT_CALL(teensy, SerialWrite(_, 2))
+        .With(Args<0, 1>(ElementsAreArray(expected_y)));
+  }
+
+  configurator::internal::PreviewCalibration(teensy);
+}
+
+TEST(ConfiguratorTest, PreviewCalibration_WaitsForNewSamples) {
+  MockTeensy teensy;
+
+  // As above, but with two samples.
+  const uint8_t request[17] = {0, 0, 0, 10, 0, 0, 0, 10, 0,
+                               0, 0, 100, 1, 244, 0, 0, 2};
+  EXPECT_CALL(teensy, SerialAvailable).WillRepeatedly(Return(true));
+  {
+    InSequence seq;
+    for (const uint8_t byte : request) {
+      EXPECT_CALL(teensy, SerialRead).WillOnce(Return(byte));
+    }
+  }
+  unsigned long now = 600;
+  EXPECT_CALL(teensy, Micros).WillRepeatedly([&] { return now += 10; });
+  // Read once per sample, though the second has to be waited for.
+  EXPECT_CALL(teensy, UpdateHallData).Times(2);
+  EXPECT_CALL(teensy, GetHallZ).Times(2).WillRepeatedly(Return(1));
+  EXPECT_CALL(teensy, GetHallX).Times(2).WillRepeatedly(Return(0.00005));
+  EXPECT_CALL(teensy, GetHallY).Times(2).WillRepeatedly(Return(0.00005));
+  EXPECT_CALL(teensy, Constrain)
+      .WillRepeatedly([](int amount, int, int) { return amount; });
+  EXPECT_CALL(teensy, SerialWrite(_, 2)).Times(4);
+
+  configurator::internal::PreviewCalibration(teensy);
+}
+
 TEST(ConfiguratorTest, StoreProfiles) {
   MockTeensy teensy;
 
@@ -190,4 +265,331 @@ TEST(ConfiguratorTest, StoreProfiles) {
   configurator::internal::StoreProfiles(teensy);
 }
 
+TEST(ConfiguratorTest, PushProfile) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialAvailable)
+      .WillOnce(Return(0))  // Expect it to wait for data.
+      .WillRepeatedly(Return(1));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(0));   // Don't persist.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(13));  // Body length.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(50));  // Threshold.
+    EXPECT_CALL(teensy, SerialRead).Times(12).WillRepeatedly(Return(0));
+  }
+  EXPECT_CALL(controller,
+              StageLayout(AllOf(
+                  Field("joystick_threshold", &Layout::joystick_threshold, 50),
+                  Field("has_mod", &Layout::has_mod, false))));
+  EXPECT_CALL(teensy, EEPROMUpdate).Times(0);
+  EXPECT_CALL(teensy, SerialWrite(0));
+
+  configurator::internal::PushProfile(teensy, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/1);
+}
+
+TEST(ConfiguratorTest, PushProfile_Timeout) {
+  MockTeensy teensy;
+  MockController controller;
+  unsigned long now = 0;
+
+  // Only the flags, body length and threshold ever arrive.
+  EXPECT_CALL(teensy, SerialAvailable)
+      .WillOnce(Return(1))
+      .WillOnce(Return(1))
+      .WillOnce(Return(1))
+      .WillRepeatedly(Return(0));
+  EXPECT_CALL(teensy, SerialRead)
+      .WillOnce(Return(0))
+      .WillOnce(Return(13))
+      .WillOnce(Return(50));
+  EXPECT_CALL(teensy, Millis).WillRepeatedly([&] { return now += 10; });
+  EXPECT_CALL(controller, StageLayout).Times(0);
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::internal::PushProfile(teensy, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/1);
+}
+
+TEST(ConfiguratorTest, PushProfile_SlowTransfer) {
+  MockTeensy teensy;
+  MockController controller;
+  unsigned long now = 0;
+  int polls = 0;
+
+  // A byte arrives every 5ms, which never leaves the line idle for long but
+  // runs the whole push past its deadline.
+  EXPECT_CALL(teensy, SerialAvailable).WillRepeatedly([&] {
+    return ++polls % 2 == 0;
+  });
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(0));   // Don't persist.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(13));  // Body length.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(50));  // Threshold.
+    EXPECT_CALL(teensy, SerialRead).WillRepeatedly(Return(0));
+  }
+  EXPECT_CALL(teensy, Millis).WillRepeatedly([&] { return now += 5; });
+  EXPECT_CALL(controller, StageLayout).Times(0);
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::internal::PushProfile(teensy, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/1);
+}
+
+TEST(ConfiguratorTest, PushProfile_Malformed) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialAvailable).WillRepeatedly(Return(2));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(0));    // Don't persist.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(2));    // Body length.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(178));  // Options follow.
+    // Options length, running past the body.
+    EXPECT_CALL(teensy, SerialRead).WillOnce(Return(255));
+  }
+  EXPECT_CALL(controller, StageLayout).Times(0);
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::internal::PushProfile(teensy, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_UnknownCommand) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(6));
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_LatencyStats) {
+  MockTeensy teensy;
+  MockController controller;
+  LatencyTracer tracer;
+  tracer.OnSnapshot(0b1, 0);
+  tracer.OnSend(258);
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(2));
+  EXPECT_CALL(controller, GetLatencyTracer).WillOnce(ReturnRef(tracer));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialWrite(0));
+    // Pin 0: count, min, mean, p99, max.
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 0, 0, 1)));
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 0, 1, 2)))
+        .Times(4);
+    // Remaining pins are empty.
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 0, 0, 0)))
+        .Times((pins::kNumPins - 1) * 5);
+  }
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_ReportCounters) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(4));
+  EXPECT_CALL(controller, GetSendCounters)
+      .WillOnce(Return(SendCounters{.sent = 258, .suppressed = 65536}));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialWrite(0));
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 0, 1, 2)));
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 1, 0, 0)));
+  }
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_NeutralOffset) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(5));
+  EXPECT_CALL(controller, GetNeutralOffset)
+      .WillOnce(Return(HallJoystick::Coordinates{.x = 258, .y = -2}));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, SerialWrite(0));
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(0, 0, 1, 2)));
+    EXPECT_CALL(teensy, SerialWrite(_, 4))
+        .With(Args<0, 1>(ElementsAre(255, 255, 255, 254)));
+  }
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_ProfilingDisabled) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(1));
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+TEST(ConfiguratorTest, ServeLive_RecordingDisabled) {
+  MockTeensy teensy;
+  MockController controller;
+
+  EXPECT_CALL(teensy, SerialRead).WillOnce(Return(3));
+  EXPECT_CALL(teensy, SerialWrite(1));
+
+  configurator::ServeLive(teensy, controller, hs_profile_Profile_Platform_PC,
+                          /*position=*/1);
+}
+
+class ConfiguratorEEPROMTest : public ::testing::Test {
+ protected:
+  ConfiguratorEEPROMTest() : eeprom_(1080, 0) {
+    // Encoded length = 29.
+    eeprom_[15] = 29;
+    eeprom_[16] = decoder::kFormatVersion;
+    // PC, position 1, base layer only.
+    eeprom_[17] = 128;
+    eeprom_[18] = 16;
+    eeprom_[19] = 11;
+    // Switch, position 1, base layer only.
+    eeprom_[31] = 64;
+    eeprom_[32] = 16;
+    eeprom_[33] = 11;
+    eeprom_[34] = 75;
+
+    ON_CALL(teensy_, EEPROMRead).WillByDefault([this](int addr) {
+      return eeprom_[addr];
+    });
+    ON_CALL(teensy_, EEPROMUpdate).WillByDefault([this](int addr, uint8_t val) {
+      eeprom_[addr] = val;
+    });
+  }
+
+  std::vector<uint8_t> eeprom_;
+  MockTeensy teensy_;
+};
+
+TEST_F(ConfiguratorEEPROMTest, StoreProfileBody_Grow) {
+  uint8_t body[22] = {21, 25};
+  body[21] = 1;
+
+  EXPECT_TRUE(configurator::internal::StoreProfileBody(teensy_, 19, body));
+
+  EXPECT_EQ(eeprom_[15], 39);
+  for (int i = 0; i < 22; i++) {
+    EXPECT_EQ(eeprom_[19 + i], body[i]);
+  }
+  EXPECT_EQ(decoder::internal::FindProfile(
+                teensy_, hs_profile_Profile_Platform_SWITCH, /*position=*/1),
+            43);
+  EXPECT_EQ(eeprom_[44], 75);
+}
+
+TEST_F(ConfiguratorEEPROMTest, StoreProfileBody_Shrink) {
+  uint8_t body[22] = {21, 25};
+  configurator::internal::StoreProfileBody(teensy_, 19, body);
+  uint8_t shorter[12] = {11, 50};
+
+  EXPECT_TRUE(configurator::internal::StoreProfileBody(teensy_, 19, shorter));
+
+  EXPECT_EQ(eeprom_[15], 29);
+  EXPECT_EQ(eeprom_[20], 50);
+  EXPECT_EQ(decoder::internal::FindProfile(
+                teensy_, hs_profile_Profile_Platform_SWITCH, /*position=*/1),
+            33);
+  EXPECT_EQ(eeprom_[34], 75);
+}
+
+TEST_F(ConfiguratorEEPROMTest, StoreProfileBody_TooLarge) {
+  eeprom_[14] = 4;  // Encoded length = 1053.
+  uint8_t body[256] = {255};
+
+  EXPECT_FALSE(configurator::internal::StoreProfileBody(teensy_, 19, body));
+  EXPECT_EQ(eeprom_[19], 11);
+}
+
+TEST_F(ConfiguratorEEPROMTest, PushProfile_Persist) {
+  MockController controller;
+
+  EXPECT_CALL(teensy_, SerialAvailable).WillRepeatedly(Return(2));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(1));   // Persist.
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(13));  // Body length.
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(90));  // Threshold.
+    EXPECT_CALL(teensy_, SerialRead).Times(12).WillRepeatedly(Return(0));
+  }
+  EXPECT_CALL(controller, StageLayout);
+  EXPECT_CALL(teensy_, SerialWrite(0));
+
+  configurator::internal::PushProfile(teensy_, controller,
+                                      hs_profile_Profile_Platform_SWITCH,
+                                      /*position=*/1);
+
+  EXPECT_EQ(eeprom_[34], 90);
+  EXPECT_EQ(eeprom_[15], 31);
+}
+
+TEST_F(ConfiguratorEEPROMTest, PushProfile_PersistNotFound) {
+  MockController controller;
+
+  EXPECT_CALL(teensy_, SerialAvailable).WillRepeatedly(Return(2));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(1));   // Persist.
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(13));  // Body length.
+    EXPECT_CALL(teensy_, SerialRead).Times(13).WillRepeatedly(Return(0));
+  }
+  EXPECT_CALL(controller, StageLayout).Times(0);
+  EXPECT_CALL(teensy_, EEPROMUpdate).Times(0);
+  EXPECT_CALL(teensy_, SerialWrite(1));
+
+  configurator::internal::PushProfile(teensy_, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/2);
+}
+
+TEST_F(ConfiguratorEEPROMTest, PushProfile_PersistOldFormat) {
+  MockController controller;
+  eeprom_[16] = 0;
+
+  EXPECT_CALL(teensy_, SerialAvailable).WillRepeatedly(Return(2));
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(1));   // Persist.
+    EXPECT_CALL(teensy_, SerialRead).WillOnce(Return(13));  // Body length.
+    EXPECT_CALL(teensy_, SerialRead).Times(13).WillRepeatedly(Return(0));
+  }
+  EXPECT_CALL(controller, StageLayout).Times(0);
+  EXPECT_CALL(teensy_, EEPROMUpdate).Times(0);
+  EXPECT_CALL(teensy_, SerialWrite(1));
+
+  configurator::internal::PushProfile(teensy_, controller,
+                                      hs_profile_Profile_Platform_PC,
+                                      /*position=*/1);
+}
+
 }  // namespace hs
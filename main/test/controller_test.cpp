@@ -5,13 +5,14 @@
 
 #include <memory>
 
+#include "decoder.h"
 #include "mock_teensy.h"
+#include "pins.h"
 #include "profile.pb.h"
 
 namespace hs {
 
 using ::testing::AtLeast;
-using ::testing::InSequence;
 using ::testing::Return;
 
 TEST(ControllerTest, FetchProfile) {
@@ -19,89 +20,91 @@ TEST(ControllerTest, FetchProfile) {
 
   EXPECT_CALL(*teensy, DigitalReadLow).Times(12);
   EXPECT_CALL(*teensy, EEPROMRead).Times(AtLeast(1));
+  EXPECT_CALL(*teensy, EEPROMRead(16))
+      .WillOnce(Return(decoder::kFormatVersion));
   EXPECT_CALL(*teensy, Exit);
 
   FetchProfile(*teensy, hs_profile_Profile_Platform_PC);
 }
 
+TEST(ControllerTest, ReadPins) {
+  const auto teensy = std::make_unique<MockTeensy>();
+
+  EXPECT_CALL(*teensy, DigitalReadLow).WillRepeatedly(Return(false));
+  EXPECT_CALL(*teensy, DigitalReadLow(pins::kThumbTop))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*teensy, DigitalReadLow(pins::kLeftInner))
+      .WillOnce(Return(true));
+
+  EXPECT_EQ(ReadPins(*teensy), 0b1000000000000001);
+}
+
+TEST(ControllerTest, CompileDebounce) {
+  hs_profile_Profile_Layout layout = {};
+  layout.debounce_count = 4;
+  layout.debounce[0] = {.pin = pins::kThumbTop,
+                        .mode = hs_profile_Profile_Layout_DebounceMode_EAGER,
+                        .time = 5000};
+  layout.debounce[1] = {
+      .pin = pins::kLeftInner,
+      .mode = hs_profile_Profile_Layout_DebounceMode_DEFERRED,
+      .time = 200};
+  // Skipped: no time, and a pin out of range.
+  layout.debounce[2] = {.pin = pins::kRingTop,
+                        .mode = hs_profile_Profile_Layout_DebounceMode_EAGER,
+                        .time = 0};
+  layout.debounce[3] = {.pin = pins::kNumPins,
+                        .mode = hs_profile_Profile_Layout_DebounceMode_EAGER,
+                        .time = 1000};
+
+  const DebounceConfig config = CompileDebounce(layout);
+
+  EXPECT_EQ(config.eager, 1 << pins::kThumbTop);
+  EXPECT_EQ(config.deferred, 1 << pins::kLeftInner);
+  EXPECT_EQ(config.micros[pins::kThumbTop], 5000);
+  EXPECT_EQ(config.micros[pins::kLeftInner], 200);
+}
+
 TEST(ControllerTest, ResolveSOCD_Min) {
-  auto mock_teensy = std::make_unique<MockTeensy>();
-  const std::vector<AnalogButton> buttons = {{.value = 100, .pin = 1},
+  const AnalogButtons buttons = {{.value = 100, .pin = 1},
                                              {.value = -75, .pin = 2}};
   const int joystick_neutral = 0;
 
-  {
-    InSequence seq;
-    EXPECT_CALL(*mock_teensy, DigitalReadLow(1)).WillOnce(Return(false));
-    EXPECT_CALL(*mock_teensy, DigitalReadLow(2)).WillOnce(Return(true));
-  }
-
-  std::unique_ptr<Teensy> teensy = std::move(mock_teensy);
-  EXPECT_EQ(ResolveSOCD(*teensy, buttons, joystick_neutral), -75);
+  EXPECT_EQ(ResolveSOCD(0b100, buttons, joystick_neutral), -75);
 }
 
 TEST(ControllerTest, ResolveSOCD_Max) {
-  auto teensy = std::make_unique<MockTeensy>();
-  const std::vector<AnalogButton> buttons = {{.value = 100, .pin = 1},
+  const AnalogButtons buttons = {{.value = 100, .pin = 1},
                                              {.value = -75, .pin = 2}};
   const int joystick_neutral = 0;
 
-  {
-    InSequence seq;
-    EXPECT_CALL(*teensy, DigitalReadLow(1)).WillOnce(Return(true));
-    EXPECT_CALL(*teensy, DigitalReadLow(2)).WillOnce(Return(false));
-  }
-
-  EXPECT_EQ(ResolveSOCD(*teensy, buttons, joystick_neutral), 100);
+  EXPECT_EQ(ResolveSOCD(0b010, buttons, joystick_neutral), 100);
 }
 
 TEST(ControllerTest, ResolveSOCD_Cancel) {
-  auto teensy = std::make_unique<MockTeensy>();
-  const std::vector<AnalogButton> buttons = {{.value = 100, .pin = 1},
+  const AnalogButtons buttons = {{.value = 100, .pin = 1},
                                              {.value = -75, .pin = 2}};
   const int joystick_neutral = 0;
 
-  {
-    InSequence seq;
-    EXPECT_CALL(*teensy, DigitalReadLow(1)).WillOnce(Return(true));
-    EXPECT_CALL(*teensy, DigitalReadLow(2)).WillOnce(Return(true));
-  }
-
-  EXPECT_EQ(ResolveSOCD(*teensy, buttons, joystick_neutral), 0);
+  EXPECT_EQ(ResolveSOCD(0b110, buttons, joystick_neutral), 0);
 }
 
 TEST(ControllerTest, ResolveSOCD_LargerMax) {
-  auto teensy = std::make_unique<MockTeensy>();
-  const std::vector<AnalogButton> buttons = {{.value = 100, .pin = 1},
+  const AnalogButtons buttons = {{.value = 100, .pin = 1},
                                              {.value = 125, .pin = 2},
                                              {.value = -75, .pin = 3}};
   const int joystick_neutral = 0;
 
-  {
-    InSequence seq;
-    EXPECT_CALL(*teensy, DigitalReadLow(1)).WillOnce(Return(true));
-    EXPECT_CALL(*teensy, DigitalReadLow(2)).WillOnce(Return(true));
-    EXPECT_CALL(*teensy, DigitalReadLow(3)).WillOnce(Return(false));
-  }
-
-  EXPECT_EQ(ResolveSOCD(*teensy, buttons, joystick_neutral), 125);
+  EXPECT_EQ(ResolveSOCD(0b0110, buttons, joystick_neutral), 125);
 }
 
 TEST(ControllerTest, ResolveSOCD_SmallerMin) {
-  auto teensy = std::make_unique<MockTeensy>();
-  const std::vector<AnalogButton> buttons = {{.value = 100, .pin = 1},
+  const AnalogButtons buttons = {{.value = 100, .pin = 1},
                                              {.value = -75, .pin = 2},
                                              {.value = -110, .pin = 3}};
   const int joystick_neutral = 0;
 
-  {
-    InSequence seq;
-    EXPECT_CALL(*teensy, DigitalReadLow(1)).WillOnce(Return(false));
-    EXPECT_CALL(*teensy, DigitalReadLow(2)).WillOnce(Return(true));
-    EXPECT_CALL(*teensy, DigitalReadLow(3)).WillOnce(Return(true));
-  }
-
-  EXPECT_EQ(ResolveSOCD(*teensy, buttons, joystick_neutral), -110);
+  EXPECT_EQ(ResolveSOCD(0b1100, buttons, joystick_neutral), -110);
 }
 
 }  // namespace hs
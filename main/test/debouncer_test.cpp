@@ -0,0 +1,123 @@
+#include "debouncer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "pins.h"
+
+namespace hs {
+
+namespace {
+
+const uint16_t kEagerPin = 1 << pins::kThumbTop;
+const uint16_t kDeferredPin = 1 << pins::kIndexTop;
+const uint16_t kOtherPin = 1 << pins::kRingTop;
+
+// Thumb top is eager for 5ms, and index top is deferred for 2ms.
+DebounceConfig GetConfig() {
+  DebounceConfig config = {};
+  config.eager = kEagerPin;
+  config.micros[pins::kThumbTop] = 5000;
+  config.deferred = kDeferredPin;
+  config.micros[pins::kIndexTop] = 2000;
+  return config;
+}
+
+}  // namespace
+
+TEST(DebouncerTest, Inactive) {
+  Debouncer debouncer;
+  EXPECT_FALSE(debouncer.IsActive());
+
+  debouncer.Configure(GetConfig());
+  EXPECT_TRUE(debouncer.IsActive());
+}
+
+TEST(DebouncerTest, PassesOtherPins) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+
+  EXPECT_EQ(debouncer.Update(0, 0), 0);
+  EXPECT_EQ(debouncer.Update(kOtherPin, 1), kOtherPin);
+  EXPECT_EQ(debouncer.Update(0, 2), 0);
+}
+
+TEST(DebouncerTest, Eager) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+  debouncer.Update(0, 0);
+
+  // The press is reported at once, and chatter is ignored until 5ms later.
+  EXPECT_EQ(debouncer.Update(kEagerPin, 1000), kEagerPin);
+  EXPECT_EQ(debouncer.Update(0, 1100), kEagerPin);
+  EXPECT_EQ(debouncer.Update(kEagerPin, 1200), kEagerPin);
+  EXPECT_EQ(debouncer.Update(0, 5999), kEagerPin);
+  // A release during the lockout is reported as soon as it ends.
+  EXPECT_EQ(debouncer.Update(0, 6000), 0);
+  EXPECT_EQ(debouncer.Update(kEagerPin, 6100), 0);
+  EXPECT_EQ(debouncer.Update(kEagerPin, 11000), kEagerPin);
+}
+
+TEST(DebouncerTest, Deferred) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+  debouncer.Update(0, 0);
+
+  // The press is only reported once it has held for 2ms.
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 1000), 0);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 2999), 0);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 3000), kDeferredPin);
+  // A glitch shorter than that is never reported.
+  EXPECT_EQ(debouncer.Update(0, 4000), kDeferredPin);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 5000), kDeferredPin);
+  EXPECT_EQ(debouncer.Update(0, 6000), kDeferredPin);
+  EXPECT_EQ(debouncer.Update(0, 8000), 0);
+}
+
+TEST(DebouncerTest, Deferred_RestartsOnBounce) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+  debouncer.Update(0, 0);
+
+  debouncer.Update(kDeferredPin, 1000);
+  debouncer.Update(0, 2000);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 2500), 0);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 3000), 0);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 4500), kDeferredPin);
+}
+
+TEST(DebouncerTest, PinsAreIndependent) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+  debouncer.Update(0, 0);
+
+  EXPECT_EQ(debouncer.Update(kEagerPin | kDeferredPin | kOtherPin, 1000),
+            kEagerPin | kOtherPin);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 2000), kEagerPin);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 3000), kEagerPin | kDeferredPin);
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 6000), kDeferredPin);
+}
+
+TEST(DebouncerTest, ConfigureSettlesOnNextSnapshot) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+
+  // Held when the layout is swapped in, so reported without waiting.
+  EXPECT_EQ(debouncer.Update(kDeferredPin, 0), kDeferredPin);
+  debouncer.Update(0, 1000);
+  debouncer.Configure(GetConfig());
+  EXPECT_EQ(debouncer.Update(0, 1500), 0);
+}
+
+TEST(DebouncerTest, ClockWraparound) {
+  Debouncer debouncer;
+  debouncer.Configure(GetConfig());
+  const uint32_t press = UINT32_MAX - 500;
+  debouncer.Update(0, press - 1000);
+
+  EXPECT_EQ(debouncer.Update(kEagerPin | kDeferredPin, press), kEagerPin);
+  EXPECT_EQ(debouncer.Update(kEagerPin | kDeferredPin, press + 2000),
+            kEagerPin | kDeferredPin);
+}
+
+}  // namespace hs
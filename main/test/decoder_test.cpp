@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 
 #include "mock_teensy.h"
+#include "pins.h"
 #include "profile.pb.h"
 #include "test_util.h"
 
@@ -236,24 +237,26 @@ TEST(DecoderTest, DecodeLayer) {
 
   {
     InSequence seq;
-    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(0));     // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(1)).WillOnce(Return(68));    // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(62));    // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(0));     // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(40));    // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(74));    // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(151));   // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(208));   // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(10));    // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(17));    // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(0));     // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(1)).WillOnce(Return(16));    // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(131));   // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(132));   // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(1));     // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(32));    // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(146));   // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(139));   // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(136));   // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(2));     // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(96));   // 011000|00
   }
 
   EXPECT_THAT(decoder::internal::DecodeLayer(teensy, addr), LayerEq(expected));
-  EXPECT_EQ(addr, 14);
+  EXPECT_EQ(addr, 16);
 }
 
 TEST(DecoderTest, DecodeBody_BaseOnly) {
@@ -299,29 +302,31 @@ TEST(DecoderTest, DecodeBody_BaseOnly) {
 
   {
     InSequence seq;
-    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(15));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(17));  // Body length
     EXPECT_CALL(teensy, EEPROMRead(1))
         .WillOnce(Return(50));  // Joystick threshold
     // Layer taken from DecodeLayer tests.
-    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(0));     // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(68));    // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(62));    // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(0));     // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(40));    // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(74));    // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(151));   // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(208));   // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(10));   // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(17));   // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(0));     // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(16));    // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(131));   // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(132));   // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(1));     // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(32));    // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(146));   // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(139));   // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(136));  // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(2));    // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(96));   // 011000|00
   }
 
   EXPECT_THAT(decoder::internal::DecodeBody(teensy, addr),
               BaseLayoutEq(expected));
-  EXPECT_EQ(addr, 16);
+  EXPECT_EQ(addr, 18);
 }
 
 TEST(DecoderTest, DecodeBody_BaseAndMod) {
@@ -367,45 +372,49 @@ TEST(DecoderTest, DecodeBody_BaseAndMod) {
 
   {
     InSequence seq;
-    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(29));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(0)).WillOnce(Return(33));  // Body length
     EXPECT_CALL(teensy, EEPROMRead(1))
         .WillOnce(Return(50));  // Joystick threshold
     // Base layer; taken from DecodeLayer tests.
-    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(0));     // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(68));    // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(62));    // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(0));     // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(40));    // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(74));    // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(151));   // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(208));   // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(10));   // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(17));   // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(2)).WillOnce(Return(0));     // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(3)).WillOnce(Return(16));    // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(4)).WillOnce(Return(131));   // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(5)).WillOnce(Return(132));   // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(6)).WillOnce(Return(1));     // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(7)).WillOnce(Return(32));    // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(8)).WillOnce(Return(146));   // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(9)).WillOnce(Return(139));   // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(10)).WillOnce(Return(136));  // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(11)).WillOnce(Return(2));    // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(12)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(13)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(96));   // 011000|00
     // Mod layer; taken from DecodeLayer tests.
-    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(0));    // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(68));   // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(62));   // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(0));    // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(20)).WillOnce(Return(40));   // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(74));   // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(151));  // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(208));  // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(10));   // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(17));   // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(0));    // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(16));   // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(20)).WillOnce(Return(131));  // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(132));  // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(1));    // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(32));   // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(146));  // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(139));  // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(136));  // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(2));    // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(30)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(31)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(32)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(33)).WillOnce(Return(96));   // 011000|00
   }
 
   EXPECT_THAT(decoder::internal::DecodeBody(teensy, addr),
               AllOf(BaseLayoutEq(expected),
                     Field("mod", &Layout::mod, LayerEq(expected.mod))));
-  EXPECT_EQ(addr, 30);
+  EXPECT_EQ(addr, 34);
 }
 
 TEST(DecoderTest, Decode_FirstProfile) {
@@ -451,32 +460,37 @@ TEST(DecoderTest, Decode_FirstProfile) {
   {
     InSequence seq;
 
-    // Encoded length = 18.
+    // Format version.
+    EXPECT_CALL(teensy, EEPROMRead(16))
+        .WillOnce(Return(decoder::kFormatVersion));
+    // Encoded length = 21.
     EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(0));
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(18));
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(21));
     // Header; taken from DecodeHeader tests.
-    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(128));  // 1000000; PC
-    EXPECT_CALL(teensy, EEPROMRead(17))
+    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(128));  // 1000000; PC
+    EXPECT_CALL(teensy, EEPROMRead(18))
         .WillOnce(Return(16));  // 0001 0000; Position = 1
     // Body; taken from DecodeBody tests.
-    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(15));  // Body length
-    EXPECT_CALL(teensy, EEPROMRead(19))
+    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(17));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(20))
         .WillOnce(Return(50));  // Joystick threshold
     // Layer; taken from DecodeLayer tests.
-    EXPECT_CALL(teensy, EEPROMRead(20)).WillOnce(Return(0));    // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(68));   // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(62));   // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(0));    // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(40));   // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(74));   // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(151));  // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(208));  // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(10));   // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(17));   // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(30)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(31)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(32)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(33)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(0));    // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(16));   // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(131));  // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(132));  // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(1));    // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(32));   // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(146));  // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(139));  // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(136));  // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(30)).WillOnce(Return(2));    // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(31)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(32)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(33)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(34)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(35)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(36)).WillOnce(Return(96));   // 011000|00
   }
 
   EXPECT_THAT(
@@ -527,40 +541,45 @@ TEST(DecoderTest, Decode_SecondProfile) {
   {
     InSequence seq;
 
-    // Encoded length = 36.
+    // Format version.
+    EXPECT_CALL(teensy, EEPROMRead(16))
+        .WillOnce(Return(decoder::kFormatVersion));
+    // Encoded length = 41.
     EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(0));
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(36));
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(41));
     // First profile header.
-    EXPECT_CALL(teensy, EEPROMRead(16))
-        .WillOnce(Return(64));  // 0100000; Switch
     EXPECT_CALL(teensy, EEPROMRead(17))
+        .WillOnce(Return(64));  // 0100000; Switch
+    EXPECT_CALL(teensy, EEPROMRead(18))
         .WillOnce(Return(64));  // 0100 0000; Position = 4
     // First profile body.
-    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(15));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(17));  // Body length
 
     // Second profile header; taken from DecodeHeader tests.
-    EXPECT_CALL(teensy, EEPROMRead(34)).WillOnce(Return(128));  // 1000000; PC
-    EXPECT_CALL(teensy, EEPROMRead(35))
+    EXPECT_CALL(teensy, EEPROMRead(37)).WillOnce(Return(128));  // 1000000; PC
+    EXPECT_CALL(teensy, EEPROMRead(38))
         .WillOnce(Return(16));  // 0001 0000; Position = 1
     // Second profile body; taken from DecodeBody tests.
-    EXPECT_CALL(teensy, EEPROMRead(36)).WillOnce(Return(15));  // Body length
-    EXPECT_CALL(teensy, EEPROMRead(37))
+    EXPECT_CALL(teensy, EEPROMRead(39)).WillOnce(Return(17));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(40))
         .WillOnce(Return(50));  // Joystick threshold
     // Second profile layer; taken from DecodeLayer tests.
-    EXPECT_CALL(teensy, EEPROMRead(38)).WillOnce(Return(0));    // 00000|000
-    EXPECT_CALL(teensy, EEPROMRead(39)).WillOnce(Return(68));   // 01|00010|0
-    EXPECT_CALL(teensy, EEPROMRead(40)).WillOnce(Return(62));   // 0011|1110
-    EXPECT_CALL(teensy, EEPROMRead(41)).WillOnce(Return(0));    // 0|0000000
-    EXPECT_CALL(teensy, EEPROMRead(42)).WillOnce(Return(40));   // 001|01000
-    EXPECT_CALL(teensy, EEPROMRead(43)).WillOnce(Return(74));   // 01001|010
-    EXPECT_CALL(teensy, EEPROMRead(44)).WillOnce(Return(151));  // 10|01011|1
-    EXPECT_CALL(teensy, EEPROMRead(45)).WillOnce(Return(208));  // 1101|0000
-    EXPECT_CALL(teensy, EEPROMRead(46)).WillOnce(Return(10));   // 000010|10
-    EXPECT_CALL(teensy, EEPROMRead(47)).WillOnce(Return(17));   // 000|10001
-    EXPECT_CALL(teensy, EEPROMRead(48)).WillOnce(Return(148));  // 10010|100
-    EXPECT_CALL(teensy, EEPROMRead(49)).WillOnce(Return(252));  // 11|11110|0
-    EXPECT_CALL(teensy, EEPROMRead(50)).WillOnce(Return(1));    // 00000001
-    EXPECT_CALL(teensy, EEPROMRead(51)).WillOnce(Return(224));  // 1|11000|00
+    EXPECT_CALL(teensy, EEPROMRead(41)).WillOnce(Return(0));    // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(42)).WillOnce(Return(16));   // 0001|0000
+    EXPECT_CALL(teensy, EEPROMRead(43)).WillOnce(Return(131));  // 10|000011
+    EXPECT_CALL(teensy, EEPROMRead(44)).WillOnce(Return(132));  // 100001|00
+    EXPECT_CALL(teensy, EEPROMRead(45)).WillOnce(Return(1));    // 00000001
+    EXPECT_CALL(teensy, EEPROMRead(46)).WillOnce(Return(32));   // 001000|00
+    EXPECT_CALL(teensy, EEPROMRead(47)).WillOnce(Return(146));  // 1001|0010
+    EXPECT_CALL(teensy, EEPROMRead(48)).WillOnce(Return(139));  // 10|001011
+    EXPECT_CALL(teensy, EEPROMRead(49)).WillOnce(Return(136));  // 100010|00
+    EXPECT_CALL(teensy, EEPROMRead(50)).WillOnce(Return(2));    // 00000010
+    EXPECT_CALL(teensy, EEPROMRead(51)).WillOnce(Return(65));   // 010000|01
+    EXPECT_CALL(teensy, EEPROMRead(52)).WillOnce(Return(20));   // 0001|0100
+    EXPECT_CALL(teensy, EEPROMRead(53)).WillOnce(Return(147));  // 10|010011
+    EXPECT_CALL(teensy, EEPROMRead(54)).WillOnce(Return(140));  // 100011|00
+    EXPECT_CALL(teensy, EEPROMRead(55)).WillOnce(Return(3));    // 00000011
+    EXPECT_CALL(teensy, EEPROMRead(56)).WillOnce(Return(96));   // 011000|00
   }
 
   EXPECT_THAT(
@@ -645,38 +664,45 @@ TEST(DecoderTest, Decode_BaseAndMod) {
   {
     InSequence seq;
 
-    // Encoded length = 24.
+    // Format version.
+    EXPECT_CALL(teensy, EEPROMRead(16))
+        .WillOnce(Return(decoder::kFormatVersion));
+    // Encoded length = 29.
     EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(0));
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(24));
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(29));
     // Header.
-    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(128));  // 1000000; PC
-    EXPECT_CALL(teensy, EEPROMRead(17))
+    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(128));  // 1000000; PC
+    EXPECT_CALL(teensy, EEPROMRead(18))
         .WillOnce(Return(0));  // 0000 0000; Position = 0
     // Body.
-    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(21));  // Body length
-    EXPECT_CALL(teensy, EEPROMRead(19))
+    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(25));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(20))
         .WillOnce(Return(0));  // Joystick threshold
     // Layer.
-    EXPECT_CALL(teensy, EEPROMRead(20)).WillOnce(Return(73));   // 01001|001
-    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(142));  // 10|00111|0
-    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(48));   // 0011|0000
-    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(144));  // 1|00100|00
-    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(74));   // 010|01010
-    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(169));  // 10101|001
-    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(105));  // 01|10100|1
-    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(100));  // 0110|0100
-    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(77));   // 0|10011|01
-    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(155));  // 100|11011
-    EXPECT_CALL(teensy, EEPROMRead(30)).WillOnce(Return(128));  // 10000|000
-    EXPECT_CALL(teensy, EEPROMRead(31)).WillOnce(Return(0));    // 00|00000|0
-    EXPECT_CALL(teensy, EEPROMRead(32)).WillOnce(Return(184));  // 1011|1000
-    EXPECT_CALL(teensy, EEPROMRead(33)).WillOnce(Return(129));  // 1|00000|01
-    EXPECT_CALL(teensy, EEPROMRead(34)).WillOnce(Return(224));  // 111|00000
-    EXPECT_CALL(teensy, EEPROMRead(35)).WillOnce(Return(4));    // 00000|100
-    EXPECT_CALL(teensy, EEPROMRead(36)).WillOnce(Return(128));  // 10|00000|0
-    EXPECT_CALL(teensy, EEPROMRead(37)).WillOnce(Return(0));    // 0000|0000
-    EXPECT_CALL(teensy, EEPROMRead(38)).WillOnce(Return(0));    // 0|00000|00
-    EXPECT_CALL(teensy, EEPROMRead(39)).WillOnce(Return(0));    // 000|00000
+    EXPECT_CALL(teensy, EEPROMRead(21)).WillOnce(Return(36));   // 001001|00
+    EXPECT_CALL(teensy, EEPROMRead(22)).WillOnce(Return(97));   // 0110|0001
+    EXPECT_CALL(teensy, EEPROMRead(23)).WillOnce(Return(195));  // 11|000011
+    EXPECT_CALL(teensy, EEPROMRead(24)).WillOnce(Return(4));    // 000001|00
+    EXPECT_CALL(teensy, EEPROMRead(25)).WillOnce(Return(64));   // 0100|0000
+    EXPECT_CALL(teensy, EEPROMRead(26)).WillOnce(Return(138));  // 10|001010
+    EXPECT_CALL(teensy, EEPROMRead(27)).WillOnce(Return(84));   // 010101|00
+    EXPECT_CALL(teensy, EEPROMRead(28)).WillOnce(Return(85));   // 0101|0101
+    EXPECT_CALL(teensy, EEPROMRead(29)).WillOnce(Return(22));   // 00|010110
+    EXPECT_CALL(teensy, EEPROMRead(30)).WillOnce(Return(33));   // 001000|01
+    EXPECT_CALL(teensy, EEPROMRead(31)).WillOnce(Return(51));   // 0011|0011
+    EXPECT_CALL(teensy, EEPROMRead(32)).WillOnce(Return(27));   // 00|011011
+    EXPECT_CALL(teensy, EEPROMRead(33)).WillOnce(Return(64));   // 010000|00
+    EXPECT_CALL(teensy, EEPROMRead(34)).WillOnce(Return(0));    // 0000|0000
+    EXPECT_CALL(teensy, EEPROMRead(35)).WillOnce(Return(11));   // 00|001011
+    EXPECT_CALL(teensy, EEPROMRead(36)).WillOnce(Return(68));   // 010001|00
+    EXPECT_CALL(teensy, EEPROMRead(37)).WillOnce(Return(3));    // 0000|0011
+    EXPECT_CALL(teensy, EEPROMRead(38)).WillOnce(Return(192));  // 11|000000
+    EXPECT_CALL(teensy, EEPROMRead(39)).WillOnce(Return(1));    // 000000|01
+    EXPECT_CALL(teensy, EEPROMRead(40)).WillOnce(Return(32));   // 0010|0000
+    EXPECT_CALL(teensy, EEPROMRead(41)).WillOnce(Return(0));    // 00|000000
+    EXPECT_CALL(teensy, EEPROMRead(42)).WillOnce(Return(0));    // 000000|00
+    EXPECT_CALL(teensy, EEPROMRead(43)).WillOnce(Return(0));    // 0000|0000
+    EXPECT_CALL(teensy, EEPROMRead(44)).WillOnce(Return(0));    // 00|000000
   }
 
   EXPECT_THAT(decoder::Decode(teensy, hs_profile_Profile_Platform_PC,
@@ -691,15 +717,18 @@ TEST(DecoderTest, Decode_ProfileNotFound) {
   {
     InSequence seq;
 
-    // Encoded length = 18.
+    // Format version.
+    EXPECT_CALL(teensy, EEPROMRead(16))
+        .WillOnce(Return(decoder::kFormatVersion));
+    // Encoded length = 21.
     EXPECT_CALL(teensy, EEPROMRead(14)).WillOnce(Return(0));
-    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(18));
+    EXPECT_CALL(teensy, EEPROMRead(15)).WillOnce(Return(21));
     // Header; taken from DecodeHeader tests.
-    EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(128));  // 1000000; PC
-    EXPECT_CALL(teensy, EEPROMRead(17))
+    EXPECT_CALL(teensy, EEPROMRead(17)).WillOnce(Return(128));  // 1000000; PC
+    EXPECT_CALL(teensy, EEPROMRead(18))
         .WillOnce(Return(16));  // 0001 0000; Position = 1
     // Body; taken from DecodeBody tests.
-    EXPECT_CALL(teensy, EEPROMRead(18)).WillOnce(Return(15));  // Body length
+    EXPECT_CALL(teensy, EEPROMRead(19)).WillOnce(Return(17));  // Body length
 
     EXPECT_CALL(teensy, Exit(1));
 
@@ -711,4 +740,304 @@ TEST(DecoderTest, Decode_ProfileNotFound) {
   decoder::Decode(teensy, hs_profile_Profile_Platform_SWITCH, /*position=*/1);
 }
 
+TEST(DecoderTest, Decode_OldFormat) {
+  MockTeensy teensy;
+
+  // An image from before the format version, with a profile header in its
+  // place.
+  EXPECT_CALL(teensy, EEPROMRead(16)).WillOnce(Return(128));  // 1000000; PC
+  EXPECT_CALL(teensy, Exit).Times(0);
+
+  const Layout layout =
+      decoder::Decode(teensy, hs_profile_Profile_Platform_PC, /*position=*/1);
+
+  EXPECT_EQ(layout.joystick_threshold, 0);
+  EXPECT_FALSE(layout.base.has_thumb_top);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_Buffer) {
+  const uint8_t body[] = {
+      15,   // Body length
+      50,   // Joystick threshold
+      139,  // 100010|11
+      255,  // 11111111
+      76,   // 010011|00
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const auto thumb_top = AnalogLayerAction(
+      hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X, 1023);
+  const auto thumb_middle =
+      DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_R_STICK_UP);
+  const auto left_inner =
+      DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_NO_OP);
+
+  EXPECT_THAT(
+      *decoder::Decode(body, sizeof(body)),
+      AllOf(Field("joystick_threshold", &Layout::joystick_threshold, 50),
+            Field("has_mod", &Layout::has_mod, false),
+            Field("base", &Layout::base,
+                  AllOf(Field("thumb_top", &Layer::thumb_top,
+                              ActionEq(thumb_top)),
+                        Field("thumb_middle", &Layer::thumb_middle,
+                              ActionEq(thumb_middle)),
+                        Field("left_inner", &Layer::left_inner,
+                              ActionEq(left_inner))))));
+}
+
+TEST(DecoderTest, Decode_AxisPolicies) {
+  const uint8_t body[] = {
+      19,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      5,    // Options length
+      1,    // Axis policies
+      3,    // Option length
+      0,    // 0000|0000; Left X, left Y
+      4,    // 0000|0100; Right X, right Y = SUM_CLAMPED
+      48,   // 0011|0000; Slider left = LAST_PRESSED, slider right
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  EXPECT_TRUE(layout.has_axis_policies);
+  EXPECT_EQ(layout.axis_policies.left_x,
+            hs_profile_Profile_Layout_AxisPolicy_OPPOSING_CANCEL);
+  EXPECT_EQ(layout.axis_policies.right_y,
+            hs_profile_Profile_Layout_AxisPolicy_SUM_CLAMPED);
+  EXPECT_EQ(layout.axis_policies.slider_left,
+            hs_profile_Profile_Layout_AxisPolicy_LAST_PRESSED);
+  EXPECT_EQ(layout.axis_policies.slider_right,
+            hs_profile_Profile_Layout_AxisPolicy_OPPOSING_CANCEL);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_TurboAndMacros) {
+  const uint8_t body[] = {
+      29,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      12,   // Options length
+      3,    // Macros
+      10,   // Option length
+      2,    // Macro 0 step count
+      1,    // Action count
+      16,   // D_PAD_DOWN
+      0,    // 00000000; Duration = 17
+      17,   // 00010001
+      2,    // Action count
+      18,   // D_PAD_RIGHT
+      1,    // X
+      0,    // 00000000; Duration = 17
+      17,   // 00010001
+      252,  // 111111|00; Thumb top = Turbo
+      17,   // 0001|0001; Action = X, Rate = 20
+      79,   // 0100|1111; Thumb middle = Macro
+      128,  // 10|0000|00; Index = 0
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  ASSERT_EQ(layout.base.thumb_top.which_action_type,
+            hs_profile_Profile_Layer_Action_turbo_tag);
+  EXPECT_EQ(layout.base.thumb_top.action_type.turbo.action,
+            hs_profile_Profile_Layer_DigitalAction_X);
+  EXPECT_EQ(layout.base.thumb_top.action_type.turbo.rate, 20);
+  ASSERT_EQ(layout.base.thumb_middle.which_action_type,
+            hs_profile_Profile_Layer_Action_macro_tag);
+  EXPECT_EQ(layout.base.thumb_middle.action_type.macro, 0);
+  EXPECT_EQ(layout.base.thumb_bottom.action_type.digital,
+            hs_profile_Profile_Layer_DigitalAction_NO_OP);
+  EXPECT_FALSE(layout.has_mod);
+
+  ASSERT_EQ(layout.macros_count, 1);
+  const auto& macro = layout.macros[0];
+  ASSERT_EQ(macro.steps_count, 2);
+  ASSERT_EQ(macro.steps[0].actions_count, 1);
+  EXPECT_EQ(macro.steps[0].actions[0],
+            hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN);
+  EXPECT_EQ(macro.steps[0].duration, 17);
+  ASSERT_EQ(macro.steps[1].actions_count, 2);
+  EXPECT_EQ(macro.steps[1].actions[0],
+            hs_profile_Profile_Layer_DigitalAction_D_PAD_RIGHT);
+  EXPECT_EQ(macro.steps[1].actions[1],
+            hs_profile_Profile_Layer_DigitalAction_X);
+  EXPECT_EQ(macro.steps[1].duration, 17);
+}
+
+TEST(DecoderTest, Decode_TapHold) {
+  const uint8_t body[] = {
+      23,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      7,    // Options length
+      2,    // Tap-hold term
+      2,    // Option length
+      1,    // 00000001; Tap-hold term = 300
+      44,   // 00101100
+      9,    // Unknown option, skipped
+      1,    // Option length
+      170,  // 10101010
+      128,  // 100000|00; Thumb top = Tap-hold
+      118,  // 0111|0110; Tap = L3, Hold = MOD
+      192,  // 11|000000; Thumb middle = NO_OP
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  EXPECT_EQ(layout.tap_hold_term, 300);
+  EXPECT_FALSE(layout.has_axis_policies);
+  ASSERT_EQ(layout.base.thumb_top.which_action_type,
+            hs_profile_Profile_Layer_Action_tap_hold_tag);
+  EXPECT_EQ(layout.base.thumb_top.action_type.tap_hold.tap,
+            hs_profile_Profile_Layer_DigitalAction_L3);
+  EXPECT_EQ(layout.base.thumb_top.action_type.tap_hold.hold,
+            hs_profile_Profile_Layer_DigitalAction_MOD);
+  EXPECT_EQ(layout.base.thumb_middle.which_action_type,
+            hs_profile_Profile_Layer_Action_digital_tag);
+  EXPECT_EQ(layout.base.thumb_middle.action_type.digital,
+            hs_profile_Profile_Layer_DigitalAction_NO_OP);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_Debounce) {
+  const uint8_t body[] = {
+      22,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      8,    // Options length
+      4,    // Debounce
+      6,    // Option length
+      1,    // 0000|0001; Thumb top = EAGER
+      19,   // 00010011; Time = 5000
+      136,  // 10001000
+      242,  // 1111|0010; Left inner = DEFERRED
+      0,    // 00000000; Time = 200
+      200,  // 11001000
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  ASSERT_EQ(layout.debounce_count, 2);
+  EXPECT_EQ(layout.debounce[0].pin, pins::kThumbTop);
+  EXPECT_EQ(layout.debounce[0].mode,
+            hs_profile_Profile_Layout_DebounceMode_EAGER);
+  EXPECT_EQ(layout.debounce[0].time, 5000);
+  EXPECT_EQ(layout.debounce[1].pin, pins::kLeftInner);
+  EXPECT_EQ(layout.debounce[1].mode,
+            hs_profile_Profile_Layout_DebounceMode_DEFERRED);
+  EXPECT_EQ(layout.debounce[1].time, 200);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_Snapback) {
+  const uint8_t body[] = {
+      19,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      5,    // Options length
+      5,    // Snapback
+      3,    // Option length
+      10,   // Velocity = 10
+      40,   // Max overshoot = 40
+      8,    // Window = 8
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  ASSERT_TRUE(layout.has_snapback);
+  EXPECT_EQ(layout.snapback.velocity, 10);
+  EXPECT_EQ(layout.snapback.max_overshoot, 40);
+  EXPECT_EQ(layout.snapback.window, 8);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_Sectors) {
+  const uint8_t body[] = {
+      19,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      5,    // Options length
+      6,    // Sectors
+      3,    // Option length
+      30,   // Diagonal width = 30
+      5,    // Angle hysteresis = 5
+      10,   // Radius hysteresis = 10
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 50);
+  ASSERT_TRUE(layout.has_sectors);
+  EXPECT_EQ(layout.sectors.diagonal_width, 30);
+  EXPECT_EQ(layout.sectors.angle_hysteresis, 5);
+  EXPECT_EQ(layout.sectors.radius_hysteresis, 10);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_ResponseCurve) {
+  const uint8_t body[] = {
+      20,   // Body length
+      128,  // 1|0000000; Options follow, joystick threshold = 0
+      6,    // Options length
+      7,    // Response curve
+      4,    // Option length
+      30,   // Input = 30
+      15,   // Output = 15
+      60,   // Input = 60
+      40,   // Output = 40
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const Layout layout = *decoder::Decode(body, sizeof(body));
+
+  EXPECT_EQ(layout.joystick_threshold, 0);
+  ASSERT_EQ(layout.response_curve_count, 2);
+  EXPECT_EQ(layout.response_curve[0].input, 30);
+  EXPECT_EQ(layout.response_curve[0].output, 15);
+  EXPECT_EQ(layout.response_curve[1].input, 60);
+  EXPECT_EQ(layout.response_curve[1].output, 40);
+  EXPECT_FALSE(layout.has_mod);
+}
+
+TEST(DecoderTest, Decode_Truncated) {
+  const uint8_t body[] = {
+      13,  // Body length
+      50,  // 0|0110010; Joystick threshold = 50
+      0,   0, 0, 0, 0, 0};
+
+  EXPECT_FALSE(decoder::Decode(body, sizeof(body)).has_value());
+}
+
+TEST(DecoderTest, Decode_OptionsStopAtBodyEnd) {
+  const uint8_t body[] = {
+      3,    // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      255,  // Options length
+      3,    // Macros
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  // The options run past the end of the body.
+  EXPECT_FALSE(decoder::Decode(body, sizeof(body)).has_value());
+}
+
+TEST(DecoderTest, Decode_MacroStopsAtOptionEnd) {
+  const uint8_t body[] = {
+      19,   // Body length
+      178,  // 1|0110010; Options follow, joystick threshold = 50
+      5,    // Options length
+      3,    // Macros
+      3,    // Option length
+      255,  // Step count
+      255,  // Action count
+      1,    // X
+      0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  const std::optional<Layout> layout = decoder::Decode(body, sizeof(body));
+
+  ASSERT_TRUE(layout.has_value());
+  ASSERT_EQ(layout->macros_count, 1);
+  ASSERT_EQ(layout->macros[0].steps_count, 1);
+  EXPECT_EQ(layout->macros[0].steps[0].actions_count, 1);
+  EXPECT_FALSE(layout->has_mod);
+}
+
 }  // namespace hs
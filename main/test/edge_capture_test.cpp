@@ -0,0 +1,138 @@
+#include "edge_capture.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "controller.h"
+#include "latency_tracer.h"
+#include "pc_controller.h"
+#include "pins.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+namespace edge_capture {
+
+namespace {
+
+const uint32_t kX = 1 << 2;
+
+// Run the controller until `end`, ticking every 10us.
+void RunUntil(PCController& controller, SimTeensy& sim, unsigned long end) {
+  while (sim.now() < end) {
+    controller.Loop();
+    sim.Advance(10);
+  }
+}
+
+Edge MakeEdge(int i) {
+  return {.micros = static_cast<uint32_t>(i),
+          .cycles = static_cast<uint32_t>(i * 600),
+          .pin = static_cast<uint8_t>(i % pins::kNumPins),
+          .pressed = i % 2 == 0};
+}
+
+}  // namespace
+
+TEST(EdgeCaptureTest, Empty) {
+  EdgeRing ring;
+  Edge edge;
+
+  EXPECT_FALSE(ring.Pop(edge));
+}
+
+TEST(EdgeCaptureTest, PopsInOrder) {
+  EdgeRing ring;
+
+  // Several laps of the ring, so the indices wrap.
+  for (int i = 0; i < 3 * static_cast<int>(kCapacity); i += 3) {
+    ring.Push(MakeEdge(i));
+    ring.Push(MakeEdge(i + 1));
+    ring.Push(MakeEdge(i + 2));
+    for (int j = i; j < i + 3; j++) {
+      Edge edge;
+      ASSERT_TRUE(ring.Pop(edge));
+      EXPECT_EQ(edge.micros, j);
+      EXPECT_EQ(edge.cycles, j * 600);
+      EXPECT_EQ(edge.pin, j % pins::kNumPins);
+      EXPECT_EQ(edge.pressed, j % 2 == 0);
+    }
+  }
+  Edge edge;
+  EXPECT_FALSE(ring.Pop(edge));
+}
+
+TEST(EdgeCaptureTest, Overflow) {
+  EdgeRing ring;
+
+  for (int i = 0; i < static_cast<int>(kCapacity) + 5; i++) {
+    ring.Push(MakeEdge(i));
+  }
+
+  // The newest edges are dropped, and flagged once the rest are drained.
+  Edge edge;
+  for (int i = 0; i < static_cast<int>(kCapacity); i++) {
+    ASSERT_TRUE(ring.Pop(edge));
+    EXPECT_EQ(edge.micros, i);
+  }
+  ASSERT_TRUE(ring.Pop(edge));
+  EXPECT_EQ(edge.pin, kOverflowPin);
+  EXPECT_FALSE(ring.Pop(edge));
+}
+
+TEST(EdgeCaptureTest, PCController_ShortTap) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  sim->SetFramePeriod(1000);
+  // Pressed and released between two reports.
+  sim->Tap(pins::kThumbMiddle, 20200, 100);
+  PCController controller(std::move(teensy));
+
+  RunUntil(controller, *sim, 30000);
+
+  // The tap is held for one report, then released on the next.
+  std::vector<SimTeensy::JoystickReport> taps;
+  for (const auto& report : sim->reports()) {
+    if (report.micros >= 20000) {
+      taps.push_back(report);
+    }
+  }
+  ASSERT_EQ(taps.size(), 2);
+  EXPECT_EQ(taps[0].buttons, kX);
+  EXPECT_LT(taps[0].micros, 21000);
+  EXPECT_EQ(taps[1].buttons, 0);
+  EXPECT_LT(taps[1].micros, 22000);
+
+  // The press is measured from the edge itself, not the snapshot.
+  const LatencyTracer::Stats stats =
+      controller.GetLatencyTracer().GetStats(pins::kThumbMiddle);
+  EXPECT_EQ(stats.count, 2);
+  EXPECT_EQ(stats.max,
+            (taps[0].micros - 20200) * SimTeensy::kCyclesPerMicro);
+}
+
+TEST(EdgeCaptureTest, PCController_ResyncsAfterOverflow) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  sim->SetFramePeriod(1000);
+  // Bounce on an unmapped pin fills the ring, so the press of thumb middle
+  // is dropped.
+  for (unsigned long t = 20100; t < 20100 + kCapacity; t++) {
+    sim->Tap(pins::kThumbTop, t, 0);
+  }
+  sim->Press(pins::kThumbMiddle, 20500);
+  PCController controller(std::move(teensy));
+
+  RunUntil(controller, *sim, 30000);
+
+  ASSERT_FALSE(sim->reports().empty());
+  EXPECT_EQ(sim->reports().back().buttons, kX);
+  EXPECT_LT(sim->reports().back().micros, 21000);
+}
+
+}  // namespace edge_capture
+}  // namespace hs
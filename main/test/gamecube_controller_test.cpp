@@ -0,0 +1,164 @@
+#include "gamecube_controller.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "controller.h"
+#include "joybus.h"
+#include "pins.h"
+#include "profile.pb.h"
+#include "test/mock_teensy.h"
+#include "test/test_util.h"
+
+namespace hs {
+
+using ::testing::_;
+using ::testing::AtLeast;
+using ::testing::DoAll;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SetArrayArgument;
+
+class GameCubeControllerTest : public ::testing::Test {
+ protected:
+  GameCubeControllerTest() {
+    teensy_ = std::make_unique<MockTeensy>();
+    mock_teensy_ = teensy_.get();
+
+    EXPECT_CALL(*teensy_, DigitalReadLow).Times(AtLeast(1));
+    EXPECT_CALL(*teensy_, EEPROMRead).Times(AtLeast(1));
+  }
+
+  // Serve a single console command and return the response sent.
+  std::vector<uint8_t> ServeCommand(GameCubeController& controller,
+                                    const std::vector<uint8_t>& command) {
+    std::vector<uint8_t> response;
+    EXPECT_CALL(*mock_teensy_, JoybusReceive(_, joybus::kMaxCommandSize))
+        .WillOnce(DoAll(SetArrayArgument<0>(command.begin(), command.end()),
+                        Return(command.size())));
+    EXPECT_CALL(*mock_teensy_, JoybusSend)
+        .WillOnce(Invoke([&response](const uint8_t* bytes, int size) {
+          response.assign(bytes, bytes + size);
+        }));
+    controller.ServeConsole();
+    return response;
+  }
+
+  std::unique_ptr<MockTeensy> teensy_;
+  MockTeensy* mock_teensy_;
+};
+
+TEST_F(GameCubeControllerTest, GetButtonPinMapping) {
+  hs_profile_Profile_Layer layer = {
+      .thumb_top = DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_X),
+      .thumb_middle =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_CIRCLE),
+      .thumb_bottom =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_TRIANGLE),
+      .index_top =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_SQUARE),
+      .index_middle =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_L2),
+      .middle_top =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_R2),
+      .middle_middle =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_R1),
+      .middle_bottom =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_OPTIONS),
+      .ring_top = DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_L1),
+      .ring_middle = DigitalLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_R_STICK_UP)};
+
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.buttons[pins::kThumbTop] = 1 << 8;
+  expected_mapping.buttons[pins::kThumbMiddle] = 1 << 9;
+  expected_mapping.buttons[pins::kThumbBottom] = 1 << 11;
+  expected_mapping.buttons[pins::kIndexTop] = 1 << 10;
+  expected_mapping.buttons[pins::kIndexMiddle] = 1 << 6;
+  expected_mapping.buttons[pins::kMiddleTop] = 1 << 5;
+  expected_mapping.buttons[pins::kMiddleMiddle] = 1 << 4;
+  expected_mapping.buttons[pins::kMiddleBottom] = 1 << 12;
+  expected_mapping.z_y = {{1023, pins::kRingMiddle}};
+
+  GameCubeController controller(std::move(teensy_));
+  EXPECT_THAT(controller.GetButtonPinMapping(layer),
+              MappingEq(expected_mapping));
+}
+
+TEST_F(GameCubeControllerTest, GetDPadBits) {
+  GameCubeController controller(std::move(teensy_));
+
+  // Input bit order: Up, Down, Left, Right
+  // Output bit order: Up, Down, Right, Left
+  EXPECT_EQ(controller.GetDPadBits(0b0000), 0b0000);
+  EXPECT_EQ(controller.GetDPadBits(0b0001), 0b0010);
+  EXPECT_EQ(controller.GetDPadBits(0b0010), 0b0001);
+  EXPECT_EQ(controller.GetDPadBits(0b0011), 0b0000);
+  EXPECT_EQ(controller.GetDPadBits(0b0100), 0b0100);
+  EXPECT_EQ(controller.GetDPadBits(0b0101), 0b0110);
+  EXPECT_EQ(controller.GetDPadBits(0b0110), 0b0101);
+  EXPECT_EQ(controller.GetDPadBits(0b0111), 0b0100);
+  EXPECT_EQ(controller.GetDPadBits(0b1000), 0b1000);
+  EXPECT_EQ(controller.GetDPadBits(0b1001), 0b1010);
+  EXPECT_EQ(controller.GetDPadBits(0b1010), 0b1001);
+  EXPECT_EQ(controller.GetDPadBits(0b1011), 0b1000);
+  EXPECT_EQ(controller.GetDPadBits(0b1100), 0b0000);
+  EXPECT_EQ(controller.GetDPadBits(0b1101), 0b0010);
+  EXPECT_EQ(controller.GetDPadBits(0b1110), 0b0001);
+  EXPECT_EQ(controller.GetDPadBits(0b1111), 0b0000);
+}
+
+TEST_F(GameCubeControllerTest, ServeConsole_Probe) {
+  GameCubeController controller(std::move(teensy_));
+
+  EXPECT_THAT(ServeCommand(controller, {joybus::kProbe}),
+              ElementsAre(0x09, 0x00, 0x03));
+}
+
+TEST_F(GameCubeControllerTest, ServeConsole_Origin) {
+  GameCubeController controller(std::move(teensy_));
+
+  EXPECT_THAT(ServeCommand(controller, {joybus::kOrigin}),
+              ElementsAre(0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00,
+                          0x00));
+}
+
+TEST_F(GameCubeControllerTest, ServeConsole_NeutralPoll) {
+  GameCubeController controller(std::move(teensy_));
+
+  EXPECT_THAT(ServeCommand(controller, {joybus::kPoll, 0x03, 0x00}),
+              ElementsAre(0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00));
+}
+
+TEST_F(GameCubeControllerTest, ServeConsole_Poll) {
+  GameCubeController controller(std::move(teensy_));
+  controller.SendReport({.buttons = 1 << 8 | 1 << 12 | 1 << 6,
+                         .dpad = 0b1010,
+                         .left_x = 1023,
+                         .left_y = 0,
+                         .right_x = 512,
+                         .right_y = 1023,
+                         .slider_left = 1022,
+                         .slider_right = 598});
+
+  EXPECT_THAT(ServeCommand(controller, {joybus::kPoll, 0x03, 0x00}),
+              ElementsAre(0b00010001,  // Start, A
+                          0b11001001,  // L, Up, Left
+                          255, 0, 128, 255,
+                          42,     // L
+                          254));  // R
+}
+
+TEST_F(GameCubeControllerTest, ServeConsole_Idle) {
+  EXPECT_CALL(*teensy_, JoybusReceive).WillOnce(Return(0));
+  EXPECT_CALL(*teensy_, JoybusSend).Times(0);
+
+  GameCubeController controller(std::move(teensy_));
+  controller.ServeConsole();
+}
+
+}  // namespace hs
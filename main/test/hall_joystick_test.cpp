@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "test/mock_teensy.h"
+#include "test/sim_teensy.h"
 
 namespace hs {
 
@@ -106,4 +107,146 @@ TEST_F(HallJoystickTest, GetCoordinates) {
   EXPECT_THAT(joystick_->GetCoordinates(teensy_), CoordinatesEq(expected));
 }
 
+TEST(HallJoystickCalibrationTest, GetCoordinates) {
+  MockTeensy teensy;
+  const HallJoystick::Calibration calibration = {
+      .neutral_x = 10, .neutral_y = 10, .range = 100, .angle_ticks = 500};
+
+  {
+    InSequence seq;
+    EXPECT_CALL(teensy, EEPROMRead).Times(0);
+    EXPECT_CALL(teensy, Micros).WillOnce(Return(600));
+    EXPECT_CALL(teensy, UpdateHallData);
+    EXPECT_CALL(teensy, Micros);
+    EXPECT_CALL(teensy, GetHallZ).WillOnce(Return(1));
+    EXPECT_CALL(teensy, GetHallX).WillOnce(Return(0.00005));
+    EXPECT_CALL(teensy, GetHallY).WillOnce(Return(0.00005));
+    EXPECT_CALL(teensy, Constrain(1004, 200, 1200)).WillOnce(Return(1004));
+    EXPECT_CALL(teensy, Constrain(650, 200, 1200)).WillOnce(Return(650));
+  }
+
+  HallJoystick joystick(calibration, /*min=*/200, /*max=*/1200,
+                        /*threshold=*/50);
+  HallJoystick::Coordinates expected = {1200, 700};
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq(expected));
+}
+
+class HallJoystickDriftTest : public ::testing::Test {
+ protected:
+  // Analog, with a range of 1000 sensor units either side of neutral. The
+  // offset moves at most 3/4096 of a unit per sample, up to 125 units.
+  HallJoystickDriftTest()
+      : joystick_({.neutral_x = 0, .neutral_y = 0, .range = 1000,
+                   .angle_ticks = 0},
+                  /*min=*/0, /*max=*/1023, /*threshold=*/0) {}
+
+  // Read `count` samples with the stick resting at (x, y) sensor units.
+  HallJoystick::Coordinates Rest(int x, int y, int count) {
+    teensy_.AddHallSample({teensy_.now(), static_cast<float>(x),
+                           static_cast<float>(y), 1000000});
+    HallJoystick::Coordinates coords = {};
+    for (int i = 0; i < count; i++) {
+      teensy_.Advance(330);
+      coords = joystick_.GetCoordinates(teensy_);
+    }
+    return coords;
+  }
+
+  SimTeensy teensy_;
+  HallJoystick joystick_;
+};
+
+TEST_F(HallJoystickDriftTest, TracksRestingNeutral) {
+  // The first sample moves from neutral, so it doesn't count as resting.
+  Rest(40, -20, kDriftSettleSamples + 1);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({0, 0}));
+
+  // Bounded rate.
+  Rest(40, -20, 4096);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({3, -3}));
+
+  EXPECT_THAT(Rest(40, -20, 60000), CoordinatesEq({512, 512}));
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({40, -20}));
+}
+
+TEST_F(HallJoystickDriftTest, IgnoresMotion) {
+  for (int i = 0; i < 2 * kDriftSettleSamples; i++) {
+    Rest(i % 2 == 0 ? 40 : -40, 0, 1);
+  }
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({0, 0}));
+}
+
+TEST_F(HallJoystickDriftTest, IgnoresTilt) {
+  Rest(200, 0, 2 * kDriftSettleSamples);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({0, 0}));
+}
+
+TEST_F(HallJoystickDriftTest, OffsetIsBounded) {
+  Rest(60, 0, 100000);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({60, 0}));
+  Rest(120, 0, 100000);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({120, 0}));
+  Rest(180, 0, 100000);
+  EXPECT_THAT(joystick_.GetNeutralOffset(), CoordinatesEq({125, 0}));
+}
+
+TEST_F(HallJoystickDriftTest, InheritDrift) {
+  Rest(40, -20, 100000);
+  HallJoystick replacement(
+      {.neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0},
+      /*min=*/0, /*max=*/1023, /*threshold=*/50);
+
+  replacement.InheritDrift(joystick_);
+
+  EXPECT_THAT(replacement.GetNeutralOffset(), CoordinatesEq({40, -20}));
+}
+
+TEST(HallJoystickSectorsTest, GetCoordinates) {
+  SimTeensy teensy;
+  HallJoystick joystick(
+      {.neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0},
+      /*min=*/0, /*max=*/1023, /*threshold=*/50);
+  // 40% tilted on each axis, 57% in all.
+  teensy.AddHallSample({0, 400, -400, 1000000});
+  teensy.Advance(330);
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq({512, 512}));
+
+  joystick.ConfigureSectors(
+      {.diagonal_width = 30, .angle_hysteresis = 5, .radius_hysteresis = 10});
+  teensy.Advance(330);
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq({1023, 0}));
+}
+
+TEST(HallJoystickSectorsTest, IgnoredWhileAnalog) {
+  SimTeensy teensy;
+  HallJoystick joystick(
+      {.neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0},
+      /*min=*/0, /*max=*/1023, /*threshold=*/0);
+  joystick.ConfigureSectors(
+      {.diagonal_width = 30, .angle_hysteresis = 5, .radius_hysteresis = 10});
+  teensy.AddHallSample({0, 400, -400, 1000000});
+  teensy.Advance(330);
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq({716, 307}));
+}
+
+TEST(HallJoystickCurveTest, GetCoordinates) {
+  SimTeensy teensy;
+  HallJoystick joystick(
+      {.neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0},
+      /*min=*/0, /*max=*/1023, /*threshold=*/0);
+  const CurvePoint points[] = {{.input = 50, .output = 25},
+                               {.input = 90, .output = 100}};
+  joystick.ConfigureResponseCurve(points, 2);
+
+  // Half tilted right, fully tilted down.
+  teensy.AddHallSample({0, 500, -1000, 1000000});
+  teensy.Advance(330);
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq({640, 0}));
+
+  // Mapped a step past the end of the axis, so clamped to it.
+  teensy.AddHallSample({teensy.now(), 1000, 0, 1000000});
+  teensy.Advance(330);
+  EXPECT_THAT(joystick.GetCoordinates(teensy), CoordinatesEq({1023, 512}));
+}
+
 }  // namespace hs
@@ -0,0 +1,170 @@
+#include "joybus.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace hs {
+namespace joybus {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::vector<uint16_t> LowWidths(const std::vector<uint8_t>& bytes,
+                                int stop_low_ns) {
+  std::vector<uint16_t> low_ns;
+  for (const uint8_t byte : bytes) {
+    for (int bit = 7; bit >= 0; bit--) {
+      low_ns.push_back(byte & (1 << bit) ? 1000 : 3000);
+    }
+  }
+  low_ns.push_back(stop_low_ns);
+  return low_ns;
+}
+
+TEST(JoybusTest, EncodeWaveform_Timings) {
+  const uint8_t bytes[] = {0b10000001};
+  Pulse pulses[kMaxPulses];
+
+  ASSERT_EQ(EncodeWaveform(bytes, 1, pulses), 18);
+
+  // 1: short low.
+  EXPECT_FALSE(pulses[0].high);
+  EXPECT_EQ(pulses[0].duration_ns, 1000);
+  EXPECT_TRUE(pulses[1].high);
+  EXPECT_EQ(pulses[1].duration_ns, 3000);
+  // 0: long low.
+  for (int i = 2; i < 14; i += 2) {
+    EXPECT_FALSE(pulses[i].high);
+    EXPECT_EQ(pulses[i].duration_ns, 3000);
+    EXPECT_TRUE(pulses[i + 1].high);
+    EXPECT_EQ(pulses[i + 1].duration_ns, 1000);
+  }
+  EXPECT_EQ(pulses[14].duration_ns, 1000);
+  EXPECT_EQ(pulses[15].duration_ns, 3000);
+  // Controller stop bit, then release.
+  EXPECT_FALSE(pulses[16].high);
+  EXPECT_EQ(pulses[16].duration_ns, 2000);
+  EXPECT_TRUE(pulses[17].high);
+  EXPECT_EQ(pulses[17].duration_ns, 0);
+}
+
+TEST(JoybusTest, EncodeWaveform_BitPeriod) {
+  const uint8_t bytes[] = {0x09, 0x00, 0x03};
+  Pulse pulses[kMaxPulses];
+
+  const int count = EncodeWaveform(bytes, 3, pulses);
+  ASSERT_EQ(count, 3 * 16 + 2);
+  for (int i = 0; i < count - 2; i += 2) {
+    EXPECT_EQ(pulses[i].duration_ns + pulses[i + 1].duration_ns, 4000);
+  }
+}
+
+TEST(JoybusTest, DecodeBits_Probe) {
+  const std::vector<uint16_t> low_ns = LowWidths({kProbe}, 1000);
+  uint8_t bytes[kMaxCommandSize];
+
+  ASSERT_EQ(DecodeBits(low_ns.data(), low_ns.size(), bytes, kMaxCommandSize),
+            1);
+  EXPECT_EQ(bytes[0], kProbe);
+}
+
+TEST(JoybusTest, DecodeBits_Poll) {
+  const std::vector<uint16_t> low_ns = LowWidths({kPoll, 0x03, 0x01}, 1000);
+  uint8_t bytes[kMaxCommandSize];
+
+  ASSERT_EQ(DecodeBits(low_ns.data(), low_ns.size(), bytes, kMaxCommandSize),
+            3);
+  EXPECT_THAT(bytes, ElementsAre(kPoll, 0x03, 0x01));
+}
+
+TEST(JoybusTest, DecodeBits_Truncated) {
+  std::vector<uint16_t> low_ns = LowWidths({kOrigin, 0xFF}, 1000);
+  low_ns.erase(low_ns.end() - 4, low_ns.end());
+  uint8_t bytes[kMaxCommandSize];
+
+  ASSERT_EQ(DecodeBits(low_ns.data(), low_ns.size(), bytes, kMaxCommandSize),
+            1);
+  EXPECT_EQ(bytes[0], kOrigin);
+}
+
+TEST(JoybusTest, DecodeBits_RoundTrip) {
+  const uint8_t sent[] = {0xA5, 0x3C};
+  Pulse pulses[kMaxPulses];
+  const int count = EncodeWaveform(sent, 2, pulses);
+
+  std::vector<uint16_t> low_ns;
+  for (int i = 0; i < count; i++) {
+    if (!pulses[i].high) {
+      low_ns.push_back(pulses[i].duration_ns);
+    }
+  }
+  uint8_t received[kMaxCommandSize];
+
+  ASSERT_EQ(
+      DecodeBits(low_ns.data(), low_ns.size(), received, kMaxCommandSize), 2);
+  EXPECT_EQ(received[0], 0xA5);
+  EXPECT_EQ(received[1], 0x3C);
+}
+
+TEST(JoybusTest, CommandPulses_Known) {
+  EXPECT_EQ(CommandPulses(LowWidths({kProbe}, 1000).data()), 9);
+  EXPECT_EQ(CommandPulses(LowWidths({kOrigin}, 1000).data()), 9);
+  EXPECT_EQ(CommandPulses(LowWidths({kReset}, 1000).data()), 9);
+  EXPECT_EQ(CommandPulses(LowWidths({kPoll, 0x03, 0x00}, 1000).data()), 25);
+}
+
+TEST(JoybusTest, CommandPulses_Unknown) {
+  EXPECT_EQ(CommandPulses(LowWidths({0x42}, 1000).data()), 0);
+}
+
+TEST(JoybusTest, Respond_Probe) {
+  const uint8_t report[kReportSize] = {};
+  uint8_t response[kMaxResponseSize];
+
+  const uint8_t probe[] = {kProbe};
+  ASSERT_EQ(Respond(probe, 1, report, response), 3);
+  EXPECT_THAT(std::vector<uint8_t>(response, response + 3),
+              ElementsAre(0x09, 0x00, 0x03));
+
+  const uint8_t reset[] = {kReset};
+  ASSERT_EQ(Respond(reset, 1, report, response), 3);
+  EXPECT_THAT(std::vector<uint8_t>(response, response + 3),
+              ElementsAre(0x09, 0x00, 0x03));
+}
+
+TEST(JoybusTest, Respond_Origin) {
+  const uint8_t report[kReportSize] = {};
+  const uint8_t command[] = {kOrigin};
+  uint8_t response[kMaxResponseSize];
+
+  ASSERT_EQ(Respond(command, 1, report, response), 10);
+  EXPECT_THAT(response, ElementsAre(0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00,
+                                    0x00, 0x00, 0x00));
+}
+
+TEST(JoybusTest, Respond_Poll) {
+  const uint8_t report[kReportSize] = {1, 2, 3, 4, 5, 6, 7, 8};
+  const uint8_t command[] = {kPoll, 0x03, 0x00};
+  uint8_t response[kMaxResponseSize];
+
+  ASSERT_EQ(Respond(command, 3, report, response), kReportSize);
+  EXPECT_THAT(std::vector<uint8_t>(response, response + kReportSize),
+              ElementsAreArray(report));
+
+  // Incomplete polls are ignored.
+  EXPECT_EQ(Respond(command, 1, report, response), 0);
+}
+
+TEST(JoybusTest, Respond_Unknown) {
+  const uint8_t report[kReportSize] = {};
+  const uint8_t command[] = {0x54};
+  uint8_t response[kMaxResponseSize];
+
+  EXPECT_EQ(Respond(command, 1, report, response), 0);
+  EXPECT_EQ(Respond(command, 0, report, response), 0);
+}
+
+}  // namespace joybus
+}  // namespace hs
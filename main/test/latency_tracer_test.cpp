@@ -0,0 +1,118 @@
+#include "latency_tracer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "pins.h"
+
+namespace hs {
+
+TEST(LatencyTracerTest, NoSamples) {
+  LatencyTracer tracer;
+
+  const LatencyTracer::Stats stats = tracer.GetStats(pins::kThumbTop);
+  EXPECT_EQ(stats.count, 0);
+  EXPECT_EQ(stats.max, 0);
+}
+
+TEST(LatencyTracerTest, HasEdges) {
+  LatencyTracer tracer;
+
+  EXPECT_FALSE(tracer.HasEdges(0));
+  EXPECT_TRUE(tracer.HasEdges(0b1));
+  tracer.OnSnapshot(0b1, 0);
+  EXPECT_FALSE(tracer.HasEdges(0b1));
+  EXPECT_TRUE(tracer.HasPending());
+  tracer.OnSend(0);
+  EXPECT_FALSE(tracer.HasPending());
+}
+
+TEST(LatencyTracerTest, PressAndRelease) {
+  LatencyTracer tracer;
+
+  // Press on pin 0, carried 100 cycles later.
+  tracer.OnSnapshot(0b01, 1000);
+  tracer.OnSend(1100);
+  // Release on pin 0 with a press on pin 1, carried 300 cycles later.
+  tracer.OnSnapshot(0b10, 2000);
+  tracer.OnSend(2300);
+
+  LatencyTracer::Stats stats = tracer.GetStats(0);
+  EXPECT_EQ(stats.count, 2);
+  EXPECT_EQ(stats.min, 100);
+  EXPECT_EQ(stats.mean, 200);
+  EXPECT_EQ(stats.p99, 300);
+  EXPECT_EQ(stats.max, 300);
+
+  stats = tracer.GetStats(1);
+  EXPECT_EQ(stats.count, 1);
+  EXPECT_EQ(stats.min, 300);
+  EXPECT_EQ(stats.max, 300);
+}
+
+TEST(LatencyTracerTest, KeepsEarliestEdge) {
+  LatencyTracer tracer;
+
+  // Pressed and released before any report carries it.
+  tracer.OnSnapshot(0b1, 1000);
+  tracer.OnSnapshot(0b0, 1500);
+  tracer.OnSend(1600);
+
+  EXPECT_EQ(tracer.GetStats(0).max, 600);
+}
+
+TEST(LatencyTracerTest, CapturedEdge) {
+  LatencyTracer tracer;
+
+  // The snapshot after the captured edge keeps the edge's stamp.
+  tracer.OnEdge(0, 1000);
+  EXPECT_TRUE(tracer.HasPending());
+  tracer.OnSnapshot(0b1, 1200);
+  tracer.OnSend(1300);
+
+  EXPECT_EQ(tracer.GetStats(0).max, 300);
+}
+
+TEST(LatencyTracerTest, CycleCounterWraps) {
+  LatencyTracer tracer;
+
+  tracer.OnSnapshot(0b1, UINT32_MAX - 49);
+  tracer.OnSend(50);
+
+  EXPECT_EQ(tracer.GetStats(0).max, 100);
+}
+
+TEST(LatencyTracerTest, Percentile) {
+  LatencyTracer tracer;
+
+  // Latencies 1-100, in a scrambled order.
+  for (int i = 0; i < 100; i++) {
+    const uint32_t latency = (i * 37) % 100 + 1;
+    tracer.OnSnapshot(i % 2 == 0 ? 0b1 : 0b0, 0);
+    tracer.OnSend(latency);
+  }
+
+  const LatencyTracer::Stats stats = tracer.GetStats(0);
+  EXPECT_EQ(stats.count, 100);
+  EXPECT_EQ(stats.min, 1);
+  EXPECT_EQ(stats.mean, 50);
+  EXPECT_EQ(stats.p99, 99);
+  EXPECT_EQ(stats.max, 100);
+}
+
+TEST(LatencyTracerTest, RingOverwritesOldest) {
+  LatencyTracer tracer;
+
+  tracer.OnSnapshot(0b1, 0);
+  tracer.OnSend(10000);
+  for (int i = 1; i <= kLatencySamples; i++) {
+    tracer.OnSnapshot(i % 2 == 0 ? 0b1 : 0b0, 0);
+    tracer.OnSend(10);
+  }
+
+  const LatencyTracer::Stats stats = tracer.GetStats(0);
+  EXPECT_EQ(stats.count, kLatencySamples);
+  EXPECT_EQ(stats.max, 10);
+}
+
+}  // namespace hs
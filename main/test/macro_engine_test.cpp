@@ -0,0 +1,194 @@
+#include "macro_engine.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "pins.h"
+
+namespace hs {
+
+namespace {
+
+const int kTurboPin = pins::kThumbTop;
+const int kMacroPin = pins::kIndexTop;
+
+// Turbo at 20Hz on thumb top, and the macro at index 0 on index top.
+TimedActions GetActions() {
+  TimedActions actions = {};
+  actions.turbo = 1u << kTurboPin;
+  actions.turbo_half_period_micros[kTurboPin] = 25000;
+  actions.macro = 1u << kMacroPin;
+  actions.macro_index[kMacroPin] = 0;
+  return actions;
+}
+
+// Down, down-right, then right + button 1, a frame each at 60Hz.
+const Macros kMacros = {{{.output = {.buttons = 0, .dpad = 0b0100},
+                          .duration_micros = 16667},
+                         {.output = {.buttons = 0, .dpad = 0b0101},
+                          .duration_micros = 16667},
+                         {.output = {.buttons = 1 << 1, .dpad = 0b0001},
+                          .duration_micros = 16667}}};
+
+}  // namespace
+
+TEST(MacroEngineTest, NoActions) {
+  MacroEngine engine;
+  MacroOutput output = {};
+
+  EXPECT_EQ(engine.Update(0xFF, {}, {}, 1000, output), 0xFF);
+  EXPECT_EQ(output.buttons, 0);
+  EXPECT_EQ(output.dpad, 0);
+}
+
+TEST(MacroEngineTest, Turbo) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  const uint32_t press = 1000;
+
+  // Every tick of a 1kHz poll while held, the input alternates between held
+  // and released every 25ms, starting held on the press.
+  for (uint32_t t = 0; t < 200000; t += 1000) {
+    MacroOutput output = {};
+    const uint32_t inputs =
+        engine.Update(1u << kTurboPin, actions, {}, press + t, output);
+    EXPECT_EQ(inputs, (t / 25000) % 2 == 0 ? 1u << kTurboPin : 0)
+        << "at " << t;
+  }
+}
+
+TEST(MacroEngineTest, Turbo_RestartsOnPress) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  MacroOutput output = {};
+
+  engine.Update(1u << kTurboPin, actions, {}, 0, output);
+  EXPECT_EQ(engine.Update(1u << kTurboPin, actions, {}, 30000, output), 0);
+  engine.Update(0, actions, {}, 31000, output);
+  EXPECT_EQ(engine.Update(1u << kTurboPin, actions, {}, 32000, output),
+            1u << kTurboPin);
+}
+
+TEST(MacroEngineTest, Turbo_LeavesOtherInputs) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  MacroOutput output = {};
+  const uint32_t other = 1u << pins::kRingTop;
+
+  engine.Update(1u << kTurboPin | other, actions, {}, 0, output);
+  EXPECT_EQ(engine.Update(1u << kTurboPin | other, actions, {}, 30000, output),
+            other);
+}
+
+TEST(MacroEngineTest, Macro_StepTiming) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  const uint32_t press = 5000;
+
+  MacroOutput output = {};
+  // The macro input itself maps to nothing, and is returned untouched.
+  EXPECT_EQ(engine.Update(1u << kMacroPin, actions, kMacros, press, output),
+            1u << kMacroPin);
+  EXPECT_EQ(output.dpad, 0b0100);
+
+  // Step boundaries land on the exact microsecond.
+  const struct {
+    uint32_t at;
+    uint32_t buttons;
+    uint8_t dpad;
+  } kExpected[] = {{16666, 0, 0b0100},      {16667, 0, 0b0101},
+                   {33333, 0, 0b0101},      {33334, 1 << 1, 0b0001},
+                   {50000, 1 << 1, 0b0001}, {50001, 0, 0}};
+  for (const auto& expected : kExpected) {
+    output = {};
+    engine.Update(0, actions, kMacros, press + expected.at, output);
+    EXPECT_EQ(output.buttons, expected.buttons) << "at " << expected.at;
+    EXPECT_EQ(output.dpad, expected.dpad) << "at " << expected.at;
+  }
+}
+
+TEST(MacroEngineTest, Macro_PlaysOncePerPress) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  MacroOutput output = {};
+
+  engine.Update(1u << kMacroPin, actions, kMacros, 0, output);
+  // Holding the input past the end of the macro doesn't replay it.
+  output = {};
+  engine.Update(1u << kMacroPin, actions, kMacros, 60000, output);
+  EXPECT_EQ(output.dpad, 0);
+
+  engine.Update(0, actions, kMacros, 61000, output);
+  output = {};
+  engine.Update(1u << kMacroPin, actions, kMacros, 62000, output);
+  EXPECT_EQ(output.dpad, 0b0100);
+}
+
+TEST(MacroEngineTest, Macro_SkipsEmptySteps) {
+  const Macros macros = {{{.output = {.buttons = 1, .dpad = 0},
+                           .duration_micros = 1000},
+                          {.output = {}, .duration_micros = 5000},
+                          {.output = {.buttons = 2, .dpad = 0},
+                           .duration_micros = 1000}}};
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+
+  MacroOutput output = {};
+  engine.Update(1u << kMacroPin, actions, macros, 0, output);
+  EXPECT_EQ(output.buttons, 1);
+  output = {};
+  engine.Update(0, actions, macros, 3000, output);
+  EXPECT_EQ(output.buttons, 0);
+  output = {};
+  engine.Update(0, actions, macros, 6000, output);
+  EXPECT_EQ(output.buttons, 2);
+}
+
+TEST(MacroEngineTest, Macro_QueueFull) {
+  Macro macro;
+  for (int i = 0; i < kMaxMacroSteps; i++) {
+    macro.push_back({.output = {.buttons = 1u << i, .dpad = 0},
+                     .duration_micros = 1000});
+  }
+  const Macros macros = {macro};
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  MacroOutput output = {};
+
+  // Two plays fill the queue, so the third is dropped rather than pressing
+  // button 0 until 1004.
+  for (uint32_t t = 0; t < 6; t += 2) {
+    engine.Update(1u << kMacroPin, actions, macros, t, output);
+    engine.Update(0, actions, macros, t + 1, output);
+  }
+  output = {};
+  engine.Update(0, actions, macros, 1003, output);
+  EXPECT_EQ(output.buttons, 1u << 1);
+}
+
+TEST(MacroEngineTest, Macro_ClockWraparound) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  const uint32_t press = UINT32_MAX - 20000;
+
+  MacroOutput output = {};
+  engine.Update(1u << kMacroPin, actions, kMacros, press, output);
+  output = {};
+  engine.Update(0, actions, kMacros, press + 40000, output);
+  EXPECT_EQ(output.buttons, 1 << 1);
+  EXPECT_EQ(output.dpad, 0b0001);
+}
+
+TEST(MacroEngineTest, Reset) {
+  MacroEngine engine;
+  const TimedActions actions = GetActions();
+  MacroOutput output = {};
+
+  engine.Update(1u << kMacroPin, actions, kMacros, 0, output);
+  engine.Reset();
+  output = {};
+  engine.Update(0, actions, kMacros, 100, output);
+  EXPECT_EQ(output.dpad, 0);
+}
+
+}  // namespace hs
@@ -0,0 +1,27 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef MOCK_CONTROLLER_H_
+#define MOCK_CONTROLLER_H_
+
+#include "controller.h"
+#include "gmock/gmock.h"
+#include "latency_tracer.h"
+#include "profile.pb.h"
+
+namespace hs {
+
+class MockController : public Controller {
+ public:
+  MOCK_METHOD(void, LoadProfile, (), (override));
+  MOCK_METHOD(void, StageLayout, (const hs_profile_Profile_Layout& layout),
+              (override));
+  MOCK_METHOD(void, Loop, (), (override));
+  MOCK_METHOD(const LatencyTracer&, GetLatencyTracer, (), (const override));
+  MOCK_METHOD(SendCounters, GetSendCounters, (), (const override));
+  MOCK_METHOD(HallJoystick::Coordinates, GetNeutralOffset, (),
+              (const override));
+};
+
+}  // namespace hs
+
+#endif  // MOCK_CONTROLLER_H_
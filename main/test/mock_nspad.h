@@ -19,14 +19,7 @@ class MockNSPad : public NSPad {
   MOCK_METHOD(int, DPadUpRight, (), (const override));
   MOCK_METHOD(int, DPadDownLeft, (), (const override));
   MOCK_METHOD(int, DPadDownRight, (), (const override));
-  MOCK_METHOD(void, SetLeftXAxis, (uint8_t val), (const override));
-  MOCK_METHOD(void, SetLeftYAxis, (uint8_t val), (const override));
-  MOCK_METHOD(void, SetRightXAxis, (uint8_t val), (const override));
-  MOCK_METHOD(void, SetRightYAxis, (uint8_t val), (const override));
-  MOCK_METHOD(void, SetDPad, (int8_t direction), (const override));
-  MOCK_METHOD(void, Press, (uint8_t button_id), (const override));
-  MOCK_METHOD(void, ReleaseAll, (), (const override));
-  MOCK_METHOD(void, Loop, (), (const override));
+  MOCK_METHOD(void, SendReport, (const NSReport& report), (const override));
 };
 
 }  // namespace hs
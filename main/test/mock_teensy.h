@@ -12,6 +12,8 @@ class MockTeensy : public Teensy {
  public:
   MOCK_METHOD(uint8_t, GetUSBConfiguration, (), (const override));
   MOCK_METHOD(bool, DigitalReadLow, (uint8_t pin), (const override));
+  MOCK_METHOD(bool, PopPinEdge, (edge_capture::Edge & edge),
+              (const override));
   MOCK_METHOD(void, Exit, (int status), (const override));
   MOCK_METHOD(int, Constrain, (int amount, int low, int high),
               (const override));
@@ -21,6 +23,8 @@ class MockTeensy : public Teensy {
   MOCK_METHOD(int, SerialAvailable, (), (const override));
   MOCK_METHOD(unsigned long, Millis, (), (const override));
   MOCK_METHOD(unsigned long, Micros, (), (const override));
+  MOCK_METHOD(uint32_t, CycleCount, (), (const override));
+  MOCK_METHOD(uint32_t, UsbFrameIndex, (), (const override));
   MOCK_METHOD(void, JoystickUseManualSend, (), (const override));
   MOCK_METHOD(void, SetJoystickX, (int val), (const override));
   MOCK_METHOD(void, SetJoystickY, (int val), (const override));
@@ -32,12 +36,18 @@ class MockTeensy : public Teensy {
               (const override));
   MOCK_METHOD(void, SetJoystickHat, (int angle), (const override));
   MOCK_METHOD(void, JoystickSendNow, (), (const override));
+  MOCK_METHOD(void, JoystickSendReport, (const uint8_t* report, int size),
+              (const override));
   MOCK_METHOD(uint8_t, EEPROMRead, (int addr), (const override));
   MOCK_METHOD(void, EEPROMUpdate, (int addr, uint8_t val), (const override));
   MOCK_METHOD(void, UpdateHallData, (), (override));
   MOCK_METHOD(float, GetHallX, (), (override));
   MOCK_METHOD(float, GetHallY, (), (override));
   MOCK_METHOD(float, GetHallZ, (), (override));
+  MOCK_METHOD(int, JoybusReceive, (uint8_t * bytes, int max_size),
+              (const override));
+  MOCK_METHOD(void, JoybusSend, (const uint8_t* bytes, int size),
+              (const override));
 };
 
 }  // namespace hs
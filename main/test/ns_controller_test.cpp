@@ -19,25 +19,8 @@ using ::testing::AllOf;
 using ::testing::AtLeast;
 using ::testing::ElementsAreArray;
 using ::testing::Field;
-using ::testing::InSequence;
 using ::testing::Return;
 
-auto MappingEq(const NSButtonPinMapping& expected) {
-  return AllOf(
-      Field("button_id_to_pins", &NSButtonPinMapping::button_id_to_pins,
-            expected.button_id_to_pins),
-      Field("mod", &NSButtonPinMapping::mod, expected.mod),
-      Field("z_y", &NSButtonPinMapping::z_y,
-            ElementsAreArray(AnalogEq(expected.z_y))),
-      Field("z_x", &NSButtonPinMapping::z_x,
-            ElementsAreArray(AnalogEq(expected.z_x))),
-      Field("dpad_up", &NSButtonPinMapping::dpad_up, expected.dpad_up),
-      Field("dpad_down", &NSButtonPinMapping::dpad_down, expected.dpad_down),
-      Field("dpad_left", &NSButtonPinMapping::dpad_left, expected.dpad_left),
-      Field("dpad_right", &NSButtonPinMapping::dpad_right,
-            expected.dpad_right));
-}
-
 class NSControllerTest : public ::testing::Test {
  protected:
   NSControllerTest() {
@@ -56,7 +39,6 @@ class NSControllerTest : public ::testing::Test {
 
     EXPECT_CALL(*teensy_, DigitalReadLow).Times(AtLeast(1));
     EXPECT_CALL(*teensy_, EEPROMRead).Times(AtLeast(1));
-    EXPECT_CALL(*teensy_, Exit);
   }
   std::unique_ptr<MockTeensy> teensy_;
   std::unique_ptr<MockNSPad> nspad_;
@@ -91,21 +73,21 @@ TEST_F(NSControllerTest, GetButtonPinMapping_StandardDigital) {
       .pinky_bottom =
           DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_CAPTURE)};
 
-  NSButtonPinMapping expected_mapping;
-  expected_mapping.button_id_to_pins[1] = {pins::kThumbTop};
-  expected_mapping.button_id_to_pins[2] = {pins::kThumbMiddle};
-  expected_mapping.button_id_to_pins[3] = {pins::kThumbBottom};
-  expected_mapping.button_id_to_pins[0] = {pins::kIndexTop};
-  expected_mapping.button_id_to_pins[4] = {pins::kIndexMiddle};
-  expected_mapping.button_id_to_pins[6] = {pins::kMiddleTop};
-  expected_mapping.button_id_to_pins[10] = {pins::kMiddleMiddle};
-  expected_mapping.button_id_to_pins[5] = {pins::kMiddleBottom};
-  expected_mapping.button_id_to_pins[7] = {pins::kRingTop};
-  expected_mapping.button_id_to_pins[11] = {pins::kRingMiddle};
-  expected_mapping.button_id_to_pins[9] = {pins::kRingBottom};
-  expected_mapping.button_id_to_pins[8] = {pins::kPinkyTop};
-  expected_mapping.button_id_to_pins[12] = {pins::kPinkyMiddle};
-  expected_mapping.button_id_to_pins[13] = {pins::kPinkyBottom};
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.buttons[pins::kThumbTop] = 1 << 1;
+  expected_mapping.buttons[pins::kThumbMiddle] = 1 << 2;
+  expected_mapping.buttons[pins::kThumbBottom] = 1 << 3;
+  expected_mapping.buttons[pins::kIndexTop] = 1 << 0;
+  expected_mapping.buttons[pins::kIndexMiddle] = 1 << 4;
+  expected_mapping.buttons[pins::kMiddleTop] = 1 << 6;
+  expected_mapping.buttons[pins::kMiddleMiddle] = 1 << 10;
+  expected_mapping.buttons[pins::kMiddleBottom] = 1 << 5;
+  expected_mapping.buttons[pins::kRingTop] = 1 << 7;
+  expected_mapping.buttons[pins::kRingMiddle] = 1 << 11;
+  expected_mapping.buttons[pins::kRingBottom] = 1 << 9;
+  expected_mapping.buttons[pins::kPinkyTop] = 1 << 8;
+  expected_mapping.buttons[pins::kPinkyMiddle] = 1 << 12;
+  expected_mapping.buttons[pins::kPinkyBottom] = 1 << 13;
 
   NSController controller(std::move(teensy_), std::move(nspad_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
@@ -136,16 +118,16 @@ TEST_F(NSControllerTest, GetButtonPinMapping_SpecialDigital) {
   const int joystick_min = 0;
   const int joystick_max = 255;
 
-  NSButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{joystick_max, pins::kThumbTop},
                           {joystick_min, pins::kThumbMiddle}};
   expected_mapping.z_x = {{joystick_min, pins::kThumbBottom},
                           {joystick_max, pins::kMiddleTop}};
-  expected_mapping.dpad_up = {pins::kIndexMiddle};
-  expected_mapping.dpad_down = {pins::kIndexTop};
-  expected_mapping.dpad_left = {pins::kMiddleMiddle};
-  expected_mapping.dpad_right = {pins::kLeftOuter};
-  expected_mapping.mod = {pins::kLeftInner};
+  expected_mapping.dpad_up = 1 << pins::kIndexMiddle;
+  expected_mapping.dpad_down = 1 << pins::kIndexTop;
+  expected_mapping.dpad_left = 1 << pins::kMiddleMiddle;
+  expected_mapping.dpad_right = 1 << pins::kLeftOuter;
+  expected_mapping.mod = 1 << pins::kLeftInner;
 
   NSController controller(std::move(teensy_), std::move(nspad_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
@@ -159,7 +141,7 @@ TEST_F(NSControllerTest, GetButtonPinMapping_Analog) {
       .thumb_middle = AnalogLayerAction(
           hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X, 101)};
 
-  NSButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{100, pins::kThumbTop}};
   expected_mapping.z_x = {{101, pins::kThumbMiddle}};
 
@@ -182,107 +164,61 @@ TEST_F(NSControllerTest, GetButtonPinMapping_MultiplePinsOneButton) {
       .middle_top =
           DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_X)};
 
-  NSButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{100, pins::kThumbTop},
                           {101, pins::kThumbMiddle},
                           {102, pins::kThumbBottom}};
-  expected_mapping.button_id_to_pins[1] = {pins::kIndexTop, pins::kIndexMiddle,
-                                           pins::kMiddleTop};
+  expected_mapping.buttons[pins::kIndexTop] = 1 << 1;
+  expected_mapping.buttons[pins::kIndexMiddle] = 1 << 1;
+  expected_mapping.buttons[pins::kMiddleTop] = 1 << 1;
 
   NSController controller(std::move(teensy_), std::move(nspad_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
               MappingEq(expected_mapping));
-}  // namespace hs
-
-TEST_F(NSControllerTest, GetDPadDirection) {
-  const uint8_t pin = 1;
+}
 
-  EXPECT_CALL(*teensy_, DigitalReadLow(pin)).WillRepeatedly(Return(true));
 
+TEST_F(NSControllerTest, GetDPadDirection) {
   NSController controller(std::move(teensy_), std::move(nspad_));
 
-  NSButtonPinMapping mapping;
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 0);
-
-  mapping = {.dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 1);
-
-  mapping = {.dpad_left = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 2);
-
-  mapping = {.dpad_left = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 0);
-
-  mapping = {.dpad_down = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 3);
-
-  mapping = {.dpad_down = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 4);
-
-  mapping = {.dpad_down = {pin}, .dpad_left = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 5);
-
-  mapping = {.dpad_down = {pin}, .dpad_left = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 3);
-
-  mapping = {.dpad_up = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 6);
-
-  mapping = {.dpad_up = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 7);
-
-  mapping = {.dpad_up = {pin}, .dpad_left = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 8);
-
-  mapping = {.dpad_up = {pin}, .dpad_left = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 6);
-
-  mapping = {.dpad_up = {pin}, .dpad_down = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 0);
-
-  mapping = {.dpad_up = {pin}, .dpad_down = {pin}, .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 1);
-
-  mapping = {.dpad_up = {pin}, .dpad_down = {pin}, .dpad_left = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 2);
-
-  mapping = {.dpad_up = {pin},
-             .dpad_down = {pin},
-             .dpad_left = {pin},
-             .dpad_right = {pin}};
-  EXPECT_EQ(controller.GetDPadDirection(mapping), 0);
+  // Bit order: Up, Down, Left, Right
+  EXPECT_EQ(controller.GetDPadDirection(0b0000), 0);
+  EXPECT_EQ(controller.GetDPadDirection(0b0001), 1);
+  EXPECT_EQ(controller.GetDPadDirection(0b0010), 2);
+  EXPECT_EQ(controller.GetDPadDirection(0b0011), 0);
+  EXPECT_EQ(controller.GetDPadDirection(0b0100), 3);
+  EXPECT_EQ(controller.GetDPadDirection(0b0101), 4);
+  EXPECT_EQ(controller.GetDPadDirection(0b0110), 5);
+  EXPECT_EQ(controller.GetDPadDirection(0b0111), 3);
+  EXPECT_EQ(controller.GetDPadDirection(0b1000), 6);
+  EXPECT_EQ(controller.GetDPadDirection(0b1001), 7);
+  EXPECT_EQ(controller.GetDPadDirection(0b1010), 8);
+  EXPECT_EQ(controller.GetDPadDirection(0b1011), 6);
+  EXPECT_EQ(controller.GetDPadDirection(0b1100), 0);
+  EXPECT_EQ(controller.GetDPadDirection(0b1101), 1);
+  EXPECT_EQ(controller.GetDPadDirection(0b1110), 2);
+  EXPECT_EQ(controller.GetDPadDirection(0b1111), 0);
 }
 
-TEST_F(NSControllerTest, UpdateButtons) {
-  const uint8_t pin = 1;
-  const std::vector<int> digital = {pin};
-  const std::vector<AnalogButton> analog = {{.value = 0, .pin = pin}};
-  NSButtonPinMapping mapping = {.z_y = analog,
-                                .z_x = analog,
-                                .dpad_up = digital,
-                                .dpad_down = digital,
-                                .dpad_left = digital,
-                                .dpad_right = digital};
-  mapping.mod = digital;
-  mapping.button_id_to_pins = {
-      {0, digital},  {1, digital},  {2, digital},  {3, digital}, {4, digital},
-      {5, digital},  {6, digital},  {7, digital},  {8, digital}, {9, digital},
-      {10, digital}, {11, digital}, {12, digital}, {13, digital}};
-
-  EXPECT_CALL(*teensy_, DigitalReadLow(1))
-      .Times(20)
-      .WillRepeatedly(Return(true));
-
-  {
-    InSequence seq;
-    EXPECT_CALL(*nspad_, SetRightYAxis);
-    EXPECT_CALL(*nspad_, SetRightXAxis);
-    EXPECT_CALL(*nspad_, Press(_)).Times(14);
-    EXPECT_CALL(*nspad_, SetDPad);
-  }
+TEST_F(NSControllerTest, SendReport) {
+  OutputReport report = {.buttons = 1 << 0 | 1 << 13,
+                         .dpad = 0b0110,
+                         .left_x = 1,
+                         .left_y = 2,
+                         .right_x = 3,
+                         .right_y = 4};
+
+  EXPECT_CALL(*nspad_, SendReport(AllOf(
+                           Field(&NSReport::buttons, 1 << 0 | 1 << 13),
+                           Field(&NSReport::dpad, 5),
+                           Field(&NSReport::left_x, 1),
+                           Field(&NSReport::left_y, 253),
+                           Field(&NSReport::right_x, 3),
+                           Field(&NSReport::right_y, 251),
+                           Field(&NSReport::filler, 0))));
 
   NSController controller(std::move(teensy_), std::move(nspad_));
-  controller.UpdateButtons(mapping);
+  controller.SendReport(report);
 }
 
 }  // namespace hs
@@ -15,31 +15,14 @@ namespace hs {
 
 using ::testing::_;
 using ::testing::AllOf;
+using ::testing::Args;
 using ::testing::AtLeast;
 using ::testing::ElementsAreArray;
 using ::testing::Field;
 using ::testing::InSequence;
+using ::testing::Invoke;
 using ::testing::Return;
 
-auto MappingEq(const PCButtonPinMapping& expected) {
-  return AllOf(
-      Field("button_id_to_pins", &PCButtonPinMapping::button_id_to_pins,
-            expected.button_id_to_pins),
-      Field("mod", &PCButtonPinMapping::mod, expected.mod),
-      Field("z_y", &PCButtonPinMapping::z_y,
-            ElementsAreArray(AnalogEq(expected.z_y))),
-      Field("z_x", &PCButtonPinMapping::z_x,
-            ElementsAreArray(AnalogEq(expected.z_x))),
-      Field("slider_left", &PCButtonPinMapping::slider_left,
-            ElementsAreArray(AnalogEq(expected.slider_left))),
-      Field("slider_right", &PCButtonPinMapping::slider_right,
-            ElementsAreArray(AnalogEq(expected.slider_right))),
-      Field("hat_up", &PCButtonPinMapping::hat_up, expected.hat_up),
-      Field("hat_down", &PCButtonPinMapping::hat_down, expected.hat_down),
-      Field("hat_left", &PCButtonPinMapping::hat_left, expected.hat_left),
-      Field("hat_right", &PCButtonPinMapping::hat_right, expected.hat_right));
-}
-
 class PCControllerTest : public ::testing::Test {
  protected:
   PCControllerTest() {
@@ -47,7 +30,6 @@ class PCControllerTest : public ::testing::Test {
 
     EXPECT_CALL(*teensy_, DigitalReadLow).Times(AtLeast(1));
     EXPECT_CALL(*teensy_, EEPROMRead).Times(AtLeast(1));
-    EXPECT_CALL(*teensy_, Exit);
     EXPECT_CALL(*teensy_, JoystickUseManualSend);
   }
   std::unique_ptr<MockTeensy> teensy_;
@@ -78,19 +60,19 @@ TEST_F(PCControllerTest, GetButtonPinMapping_StandardDigital) {
       .pinky_top =
           DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_SHARE)};
 
-  PCButtonPinMapping expected_mapping;
-  expected_mapping.button_id_to_pins[2] = {pins::kThumbTop};
-  expected_mapping.button_id_to_pins[3] = {pins::kThumbMiddle};
-  expected_mapping.button_id_to_pins[4] = {pins::kThumbBottom};
-  expected_mapping.button_id_to_pins[1] = {pins::kIndexTop};
-  expected_mapping.button_id_to_pins[5] = {pins::kIndexMiddle};
-  expected_mapping.button_id_to_pins[7] = {pins::kMiddleTop};
-  expected_mapping.button_id_to_pins[11] = {pins::kMiddleMiddle};
-  expected_mapping.button_id_to_pins[6] = {pins::kMiddleBottom};
-  expected_mapping.button_id_to_pins[8] = {pins::kRingTop};
-  expected_mapping.button_id_to_pins[12] = {pins::kRingMiddle};
-  expected_mapping.button_id_to_pins[10] = {pins::kRingBottom};
-  expected_mapping.button_id_to_pins[9] = {pins::kPinkyTop};
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.buttons[pins::kThumbTop] = 1 << 2;
+  expected_mapping.buttons[pins::kThumbMiddle] = 1 << 3;
+  expected_mapping.buttons[pins::kThumbBottom] = 1 << 4;
+  expected_mapping.buttons[pins::kIndexTop] = 1 << 1;
+  expected_mapping.buttons[pins::kIndexMiddle] = 1 << 5;
+  expected_mapping.buttons[pins::kMiddleTop] = 1 << 7;
+  expected_mapping.buttons[pins::kMiddleMiddle] = 1 << 11;
+  expected_mapping.buttons[pins::kMiddleBottom] = 1 << 6;
+  expected_mapping.buttons[pins::kRingTop] = 1 << 8;
+  expected_mapping.buttons[pins::kRingMiddle] = 1 << 12;
+  expected_mapping.buttons[pins::kRingBottom] = 1 << 10;
+  expected_mapping.buttons[pins::kPinkyTop] = 1 << 9;
 
   PCController controller(std::move(teensy_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
@@ -129,7 +111,7 @@ TEST_F(PCControllerTest, GetButtonPinMapping_SpecialDigital) {
   const int joystick_min = 0;
   const int joystick_max = 1023;
 
-  PCButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{joystick_max, pins::kThumbTop},
                           {joystick_min, pins::kThumbMiddle}};
   expected_mapping.z_x = {{joystick_min, pins::kThumbBottom},
@@ -138,17 +120,109 @@ TEST_F(PCControllerTest, GetButtonPinMapping_SpecialDigital) {
                                   {joystick_max, pins::kMiddleTop}};
   expected_mapping.slider_right = {{joystick_min, pins::kMiddleMiddle},
                                    {joystick_max, pins::kRingMiddle}};
-  expected_mapping.hat_up = {pins::kRingTop};
-  expected_mapping.hat_down = {pins::kMiddleBottom};
-  expected_mapping.hat_left = {pins::kRingBottom};
-  expected_mapping.hat_right = {pins::kLeftOuter};
-  expected_mapping.mod = {pins::kLeftInner};
+  expected_mapping.dpad_up = 1 << pins::kRingTop;
+  expected_mapping.dpad_down = 1 << pins::kMiddleBottom;
+  expected_mapping.dpad_left = 1 << pins::kRingBottom;
+  expected_mapping.dpad_right = 1 << pins::kLeftOuter;
+  expected_mapping.mod = 1 << pins::kLeftInner;
 
   PCController controller(std::move(teensy_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
               MappingEq(expected_mapping));
 }
 
+TEST_F(PCControllerTest, GetButtonPinMapping_LeftStick) {
+  hs_profile_Profile_Layer layer = {
+      .thumb_top =
+          DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_L_STICK_UP),
+      .thumb_middle = DigitalLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_L_STICK_DOWN),
+      .thumb_bottom = DigitalLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_L_STICK_LEFT),
+      .index_top = DigitalLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_L_STICK_RIGHT)};
+
+  const int joystick_min = 0;
+  const int joystick_max = 1023;
+
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.left_y = {{joystick_max, pins::kThumbTop},
+                             {joystick_min, pins::kThumbMiddle}};
+  expected_mapping.left_x = {{joystick_min, pins::kThumbBottom},
+                             {joystick_max, pins::kIndexTop}};
+
+  PCController controller(std::move(teensy_));
+  const ButtonPinMapping mapping = controller.GetButtonPinMapping(layer);
+  EXPECT_THAT(mapping, MappingEq(expected_mapping));
+  EXPECT_TRUE(IsHitbox(mapping));
+}
+
+TEST_F(PCControllerTest, GetButtonPinMapping_TapHold) {
+  hs_profile_Profile_Layer layer = {
+      .thumb_top = TapHoldLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_D_PAD_UP,
+          hs_profile_Profile_Layer_DigitalAction_MOD),
+      .index_top = TapHoldLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_L_STICK_LEFT,
+          hs_profile_Profile_Layer_DigitalAction_NO_OP)};
+
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.dpad_up = 1u << TapInput(pins::kThumbTop);
+  expected_mapping.mod = 1 << pins::kThumbTop;
+  expected_mapping.left_x = {{0, TapInput(pins::kIndexTop)}};
+  expected_mapping.tap_hold = 1 << pins::kThumbTop | 1 << pins::kIndexTop;
+
+  PCController controller(std::move(teensy_));
+  EXPECT_THAT(controller.GetButtonPinMapping(layer),
+              MappingEq(expected_mapping));
+}
+
+TEST_F(PCControllerTest, GetButtonPinMapping_TurboAndMacro) {
+  hs_profile_Profile_Layer layer = {
+      .thumb_top =
+          TurboLayerAction(hs_profile_Profile_Layer_DigitalAction_X, 20),
+      .index_top = MacroLayerAction(1)};
+
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.buttons[pins::kThumbTop] = 1 << 2;
+  expected_mapping.timed.turbo = 1 << pins::kThumbTop;
+  expected_mapping.timed.turbo_half_period_micros[pins::kThumbTop] = 25000;
+  expected_mapping.timed.macro = 1 << pins::kIndexTop;
+  expected_mapping.timed.macro_index[pins::kIndexTop] = 1;
+
+  PCController controller(std::move(teensy_));
+  EXPECT_THAT(controller.GetButtonPinMapping(layer),
+              MappingEq(expected_mapping));
+}
+
+TEST_F(PCControllerTest, CompileMacros) {
+  hs_profile_Profile_Layout layout = {};
+  layout.macros_count = 1;
+  layout.macros[0].steps_count = 2;
+  layout.macros[0].steps[0] = {
+      .actions_count = 2,
+      .actions = {hs_profile_Profile_Layer_DigitalAction_CIRCLE,
+                  hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN},
+      .duration = 17};
+  layout.macros[0].steps[1] = {
+      .actions_count = 1,
+      .actions = {hs_profile_Profile_Layer_DigitalAction_MOD},
+      .duration = 5};
+
+  PCController controller(std::move(teensy_));
+  const Macros macros = controller.CompileMacros(layout);
+
+  ASSERT_EQ(macros.size(), 1);
+  ASSERT_EQ(macros[0].size(), 2);
+  EXPECT_EQ(macros[0][0].output.buttons, 1 << 3);
+  EXPECT_EQ(macros[0][0].output.dpad, 0b0100);
+  EXPECT_EQ(macros[0][0].duration_micros, 17000);
+  // Actions other than buttons and the D-pad output nothing.
+  EXPECT_EQ(macros[0][1].output.buttons, 0);
+  EXPECT_EQ(macros[0][1].output.dpad, 0);
+  EXPECT_EQ(macros[0][1].duration_micros, 5000);
+}
+
 TEST_F(PCControllerTest, GetButtonPinMapping_Analog) {
   hs_profile_Profile_Layer layer = {
       .thumb_top = AnalogLayerAction(
@@ -160,7 +234,7 @@ TEST_F(PCControllerTest, GetButtonPinMapping_Analog) {
       .pinky_bottom = AnalogLayerAction(
           hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_RIGHT, 103)};
 
-  PCButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{100, pins::kThumbTop}};
   expected_mapping.z_x = {{101, pins::kThumbMiddle}};
   expected_mapping.slider_left = {{102, pins::kPinkyMiddle}};
@@ -171,6 +245,33 @@ TEST_F(PCControllerTest, GetButtonPinMapping_Analog) {
               MappingEq(expected_mapping));
 }
 
+TEST_F(PCControllerTest, GetButtonPinMapping_HighResolution) {
+  hs_profile_Profile_Layer layer = {
+      .thumb_top = AnalogLayerAction(
+          hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_Y, 0),
+      .thumb_middle = AnalogLayerAction(
+          hs_profile_Profile_Layer_AnalogAction_ID_R_STICK_X, 512),
+      .thumb_bottom = DigitalLayerAction(
+          hs_profile_Profile_Layer_DigitalAction_R_STICK_RIGHT),
+      .pinky_middle = AnalogLayerAction(
+          hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_LEFT, 598),
+      .pinky_bottom = AnalogLayerAction(
+          hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_RIGHT, 1023)};
+
+  // Profile values keep their place relative to neutral and the ends of the
+  // wider range.
+  ButtonPinMapping expected_mapping = {};
+  expected_mapping.z_y = {{0, pins::kThumbTop}};
+  expected_mapping.z_x = {{32768, pins::kThumbMiddle},
+                          {65535, pins::kThumbBottom}};
+  expected_mapping.slider_left = {{38282, pins::kPinkyMiddle}};
+  expected_mapping.slider_right = {{65535, pins::kPinkyBottom}};
+
+  PCController controller(std::move(teensy_), /*high_resolution=*/true);
+  EXPECT_THAT(controller.GetButtonPinMapping(layer),
+              MappingEq(expected_mapping));
+}
+
 TEST_F(PCControllerTest, GetButtonPinMapping_MultiplePinsOneButton) {
   hs_profile_Profile_Layer layer = {
       .thumb_top = AnalogLayerAction(
@@ -185,113 +286,410 @@ TEST_F(PCControllerTest, GetButtonPinMapping_MultiplePinsOneButton) {
       .middle_top =
           DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_X)};
 
-  PCButtonPinMapping expected_mapping;
+  ButtonPinMapping expected_mapping = {};
   expected_mapping.z_y = {{100, pins::kThumbTop},
                           {101, pins::kThumbMiddle},
                           {102, pins::kThumbBottom}};
-  expected_mapping.button_id_to_pins[2] = {pins::kIndexTop, pins::kIndexMiddle,
-                                           pins::kMiddleTop};
+  expected_mapping.buttons[pins::kIndexTop] = 1 << 2;
+  expected_mapping.buttons[pins::kIndexMiddle] = 1 << 2;
+  expected_mapping.buttons[pins::kMiddleTop] = 1 << 2;
 
   PCController controller(std::move(teensy_));
   EXPECT_THAT(controller.GetButtonPinMapping(layer),
               MappingEq(expected_mapping));
 }
 
-TEST_F(PCControllerTest, GetDPadAngle) {
-  const uint8_t pin = 1;
-
-  EXPECT_CALL(*teensy_, DigitalReadLow(pin)).WillRepeatedly(Return(true));
 
+TEST_F(PCControllerTest, GetDPadAngle) {
   PCController controller(std::move(teensy_));
 
-  PCButtonPinMapping mapping;
-  EXPECT_EQ(controller.GetDPadAngle(mapping), -1);
+  // Bit order: Up, Down, Left, Right
+  EXPECT_EQ(controller.GetDPadAngle(0b0000), -1);
+  EXPECT_EQ(controller.GetDPadAngle(0b0001), 90);
+  EXPECT_EQ(controller.GetDPadAngle(0b0010), 270);
+  EXPECT_EQ(controller.GetDPadAngle(0b0011), -1);
+  EXPECT_EQ(controller.GetDPadAngle(0b0100), 180);
+  EXPECT_EQ(controller.GetDPadAngle(0b0101), 135);
+  EXPECT_EQ(controller.GetDPadAngle(0b0110), 225);
+  EXPECT_EQ(controller.GetDPadAngle(0b0111), 180);
+  EXPECT_EQ(controller.GetDPadAngle(0b1000), 0);
+  EXPECT_EQ(controller.GetDPadAngle(0b1001), 45);
+  EXPECT_EQ(controller.GetDPadAngle(0b1010), 315);
+  EXPECT_EQ(controller.GetDPadAngle(0b1011), 0);
+  EXPECT_EQ(controller.GetDPadAngle(0b1100), -1);
+  EXPECT_EQ(controller.GetDPadAngle(0b1101), 90);
+  EXPECT_EQ(controller.GetDPadAngle(0b1110), 270);
+  EXPECT_EQ(controller.GetDPadAngle(0b1111), -1);
+}
 
-  mapping = {.hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 90);
+TEST_F(PCControllerTest, BuildReport) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top =
+                   DigitalLayerAction(hs_profile_Profile_Layer_DigitalAction_X),
+               .thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_R_STICK_UP),
+               .ring_top = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_D_PAD_UP),
+               .left_inner = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_MOD)},
+      .has_mod = true,
+      .mod = {.thumb_top = DigitalLayerAction(
+                  hs_profile_Profile_Layer_DigitalAction_CIRCLE)}};
 
-  mapping = {.hat_left = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 270);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+
+  // Staged layouts are only swapped in at the start of a tick.
+  uint16_t pins = 1 << pins::kThumbTop | 1 << pins::kThumbMiddle |
+                  1 << pins::kRingTop;
+  OutputReport report = controller.BuildReport(pins, {.x = 1, .y = 2});
+  EXPECT_EQ(report.buttons, 0);
+
+  controller.Loop();
+
+  report = controller.BuildReport(pins, {.x = 1, .y = 2});
+  EXPECT_EQ(report.buttons, 1 << 2);
+  EXPECT_EQ(report.dpad, 0b1000);
+  EXPECT_EQ(report.left_x, 1);
+  EXPECT_EQ(report.left_y, 2);
+  EXPECT_EQ(report.right_x, 512);
+  EXPECT_EQ(report.right_y, 1023);
+  EXPECT_EQ(report.slider_left, 512);
+  EXPECT_EQ(report.slider_right, 512);
+
+  report = controller.BuildReport(pins | 1 << pins::kLeftInner, {});
+  EXPECT_EQ(report.buttons, 1 << 3);
+  EXPECT_EQ(report.dpad, 0);
+  EXPECT_EQ(report.right_y, 512);
+}
 
-  mapping = {.hat_left = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), -1);
+TEST_F(PCControllerTest, BuildReport_Hitbox) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_L_STICK_UP),
+               .thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_L_STICK_DOWN),
+               .thumb_bottom = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_L_STICK_LEFT),
+               .index_top = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_L_STICK_RIGHT)}};
+
+  // The hall sensor is never sampled once the layout is swapped in, even
+  // though a read is due.
+  EXPECT_CALL(*teensy_, Micros).WillRepeatedly(Return(1000));
+  EXPECT_CALL(*teensy_, UpdateHallData).Times(0);
+
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+
+  OutputReport report = controller.BuildReport(
+      1 << pins::kThumbTop | 1 << pins::kThumbBottom, {.x = 1, .y = 2});
+  EXPECT_EQ(report.left_x, 0);
+  EXPECT_EQ(report.left_y, 1023);
+
+  report = controller.BuildReport(1 << pins::kThumbTop |
+                                      1 << pins::kThumbMiddle |
+                                      1 << pins::kIndexTop,
+                                  {.x = 1, .y = 2});
+  EXPECT_EQ(report.left_x, 1023);
+  EXPECT_EQ(report.left_y, 512);
+
+  report = controller.BuildReport(0, {.x = 1, .y = 2});
+  EXPECT_EQ(report.left_x, 512);
+  EXPECT_EQ(report.left_y, 512);
+}
 
-  mapping = {.hat_down = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 180);
+TEST_F(PCControllerTest, BuildReport_AxisPolicies) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top = AnalogLayerAction(
+                   hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_LEFT, 1022),
+               .thumb_middle = AnalogLayerAction(
+                   hs_profile_Profile_Layer_AnalogAction_ID_SLIDER_LEFT, 598),
+               .thumb_bottom = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_R_STICK_UP),
+               .index_top = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_R_STICK_DOWN)},
+      .has_axis_policies = true,
+      .axis_policies = {
+          .right_y = hs_profile_Profile_Layout_AxisPolicy_LOWEST,
+          .slider_left = hs_profile_Profile_Layout_AxisPolicy_LAST_PRESSED}};
 
-  mapping = {.hat_down = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 135);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+
+  const uint16_t heavy = 1 << pins::kThumbTop;
+  const uint16_t light = 1 << pins::kThumbMiddle;
+  EXPECT_EQ(controller.BuildReport(light, {}).slider_left, 598);
+  EXPECT_EQ(controller.BuildReport(light | heavy, {}).slider_left, 1022);
+  EXPECT_EQ(controller.BuildReport(heavy, {}).slider_left, 1022);
+  EXPECT_EQ(controller.BuildReport(heavy | light, {}).slider_left, 598);
+
+  const uint16_t up_down = 1 << pins::kThumbBottom | 1 << pins::kIndexTop;
+  EXPECT_EQ(controller.BuildReport(up_down, {}).right_y, 0);
+}
 
-  mapping = {.hat_down = {pin}, .hat_left = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 225);
+TEST_F(PCControllerTest, Loop_TapHold) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top = TapHoldLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_D_PAD_UP,
+                   hs_profile_Profile_Layer_DigitalAction_MOD),
+               .thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN)},
+      .has_mod = true,
+      .mod = {.thumb_middle = DigitalLayerAction(
+                  hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT)},
+      .tap_hold_term = 100};
+
+  uint32_t now = 1000;
+  uint16_t held = 0;
+  EXPECT_CALL(*teensy_, Micros).WillRepeatedly(Invoke([&] { return now; }));
+  ON_CALL(*teensy_, DigitalReadLow).WillByDefault(Invoke([&](uint8_t pin) {
+    return (held & 1 << pin) != 0;
+  }));
 
-  mapping = {.hat_down = {pin}, .hat_left = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 180);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+
+  // Held past the term, the pin acts as MOD.
+  held = 1 << pins::kThumbTop;
+  controller.Loop();
+  EXPECT_EQ(controller.BuildReport(held, {}).dpad, 0);
+  now += 100000;
+  held |= 1 << pins::kThumbMiddle;
+  controller.Loop();
+  EXPECT_EQ(controller.BuildReport(held, {}).dpad, 0b0010);
+
+  // Tapped, the pin presses D-pad up until the tap expires.
+  held = 0;
+  now += 1000;
+  controller.Loop();
+  held = 1 << pins::kThumbTop;
+  controller.Loop();
+  held = 0;
+  now += 1000;
+  controller.Loop();
+  EXPECT_EQ(controller.BuildReport(held, {}).dpad, 0b1000);
+  now += kTapMicros;
+  controller.Loop();
+  EXPECT_EQ(controller.BuildReport(held, {}).dpad, 0);
+}
 
-  mapping = {.hat_up = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 0);
+TEST_F(PCControllerTest, Loop_TapHoldModPermissiveHold) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top = TapHoldLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_L3,
+                   hs_profile_Profile_Layer_DigitalAction_MOD),
+               .thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_D_PAD_DOWN)},
+      .has_mod = true,
+      .mod = {.thumb_middle = DigitalLayerAction(
+                  hs_profile_Profile_Layer_DigitalAction_D_PAD_LEFT)}};
+
+  uint32_t now = 1000;
+  uint16_t held = 0;
+  int hat = -1;
+  EXPECT_CALL(*teensy_, Micros).WillRepeatedly(Invoke([&] { return now; }));
+  ON_CALL(*teensy_, DigitalReadLow).WillByDefault(Invoke([&](uint8_t pin) {
+    return (held & 1 << pin) != 0;
+  }));
+  ON_CALL(*teensy_, SetJoystickHat).WillByDefault(Invoke([&](int angle) {
+    hat = angle;
+  }));
 
-  mapping = {.hat_up = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 45);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+
+  // Thumb middle is held back while the MOD pin is pending, rather than
+  // sent on the base layer.
+  held = 1 << pins::kThumbTop;
+  now += 1000;
+  controller.Loop();
+  held |= 1 << pins::kThumbMiddle;
+  now += 1000;
+  controller.Loop();
+  EXPECT_EQ(hat, -1);
+
+  // Its release within the term resolves MOD as a hold, and it is sent on
+  // the MOD layer for as long as a tap.
+  held = 1 << pins::kThumbTop;
+  now += 1000;
+  controller.Loop();
+  EXPECT_EQ(hat, 270);
+  now += kTapMicros;
+  controller.Loop();
+  EXPECT_EQ(hat, -1);
+
+  // Held past the term instead, it is sent on the MOD layer once MOD is
+  // held.
+  held = 0;
+  now += 1000;
+  controller.Loop();
+  held = 1 << pins::kThumbTop | 1 << pins::kThumbMiddle;
+  now += 1000;
+  controller.Loop();
+  EXPECT_EQ(hat, -1);
+  now += kDefaultTapHoldTermMicros;
+  controller.Loop();
+  EXPECT_EQ(hat, 270);
+}
 
-  mapping = {.hat_up = {pin}, .hat_left = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 315);
+TEST_F(PCControllerTest, Loop_SuppressesUnchangedReports) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_X)}};
+
+  uint32_t now = 1000;
+  uint16_t held = 0;
+  EXPECT_CALL(*teensy_, Micros).WillRepeatedly(Invoke([&] { return now; }));
+  ON_CALL(*teensy_, DigitalReadLow).WillByDefault(Invoke([&](uint8_t pin) {
+    return (held & 1 << pin) != 0;
+  }));
+  // The first report, the press, the release, then the keep-alive.
+  EXPECT_CALL(*teensy_, JoystickSendNow).Times(4);
 
-  mapping = {.hat_up = {pin}, .hat_left = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 0);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+  controller.Loop();
+  held = 1 << pins::kThumbMiddle;
+  controller.Loop();
+  controller.Loop();
+  held = 0;
+  controller.Loop();
+  now += kKeepAliveMicros - 1;
+  controller.Loop();
+  now += 1;
+  controller.Loop();
+  controller.Loop();
+
+  const SendCounters counters = controller.GetSendCounters();
+  EXPECT_EQ(counters.sent, 4);
+  EXPECT_EQ(counters.suppressed, 4);
+}
 
-  mapping = {.hat_up = {pin}, .hat_down = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), -1);
+TEST_F(PCControllerTest, Loop_DiscardsEdgesOfSuppressedReports) {
+  hs_profile_Profile_Layout layout = {
+      .has_base = true,
+      .base = {.thumb_top = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_MOD),
+               .thumb_middle = DigitalLayerAction(
+                   hs_profile_Profile_Layer_DigitalAction_X)},
+      .has_mod = true,
+      .mod = {.thumb_middle = DigitalLayerAction(
+                  hs_profile_Profile_Layer_DigitalAction_X)}};
+
+  uint32_t now = 1000;
+  uint16_t held = 0;
+  EXPECT_CALL(*teensy_, Micros).WillRepeatedly(Invoke([&] { return now; }));
+  EXPECT_CALL(*teensy_, CycleCount).WillRepeatedly(Invoke([&] {
+    return now * 600;
+  }));
+  ON_CALL(*teensy_, DigitalReadLow).WillByDefault(Invoke([&](uint8_t pin) {
+    return (held & 1 << pin) != 0;
+  }));
 
-  mapping = {.hat_up = {pin}, .hat_down = {pin}, .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 90);
+  PCController controller(std::move(teensy_));
+  controller.StageLayout(layout);
+  controller.Loop();
+
+  // MOD alone doesn't change the report, so is never sent, even by the
+  // keep-alive.
+  held = 1 << pins::kThumbTop;
+  controller.Loop();
+  now += kKeepAliveMicros;
+  controller.Loop();
+  EXPECT_EQ(controller.GetLatencyTracer().GetStats(pins::kThumbTop).count, 0);
+
+  held |= 1 << pins::kThumbMiddle;
+  now += 10;
+  controller.Loop();
+  EXPECT_EQ(controller.GetLatencyTracer().GetStats(pins::kThumbMiddle).count,
+            1);
+}
 
-  mapping = {.hat_up = {pin}, .hat_down = {pin}, .hat_left = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), 270);
+TEST_F(PCControllerTest, GetHiResReport) {
+  const OutputReport report = {.buttons = 1 << 1 | 1 << 12,
+                               .dpad = 0b0110,
+                               .left_x = 1,
+                               .left_y = 2,
+                               .right_x = 3,
+                               .right_y = 4,
+                               .slider_left = 5,
+                               .slider_right = 65535};
+
+  PCController controller(std::move(teensy_), /*high_resolution=*/true);
+  const HiResReport hires = controller.GetHiResReport(report);
+  EXPECT_EQ(hires.buttons, 1 << 0 | 1 << 11);
+  EXPECT_EQ(hires.x, 1);
+  EXPECT_EQ(hires.y, 65533);
+  EXPECT_EQ(hires.z, 4);
+  EXPECT_EQ(hires.z_rotate, 3);
+  EXPECT_EQ(hires.slider_left, 5);
+  EXPECT_EQ(hires.slider_right, 65535);
+  EXPECT_EQ(hires.hat, 5);  // 225 degrees
+
+  EXPECT_EQ(controller.GetHiResReport({}).hat, kHiResHatCentered);
+}
 
-  mapping = {.hat_up = {pin},
-             .hat_down = {pin},
-             .hat_left = {pin},
-             .hat_right = {pin}};
-  EXPECT_EQ(controller.GetDPadAngle(mapping), -1);
+TEST_F(PCControllerTest, SendReport_HighResolution) {
+  const OutputReport report = {.buttons = 1 << 2,
+                               .dpad = 0,
+                               .left_x = 0x1234,
+                               .left_y = 0xFFFF,
+                               .right_x = 0,
+                               .right_y = 0,
+                               .slider_left = 0,
+                               .slider_right = 0xABCD};
+
+  // One little-endian report, and none of the stock joystick calls.
+  EXPECT_CALL(*teensy_, SetJoystickX).Times(0);
+  EXPECT_CALL(*teensy_, JoystickSendNow).Times(0);
+  EXPECT_CALL(*teensy_, JoystickSendReport(_, sizeof(HiResReport)))
+      .With(Args<0, 1>(ElementsAreArray({0x02, 0x00, 0x34, 0x12, 0x00, 0x00,
+                                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                         0xCD, 0xAB, 0x0F})));
+
+  PCController controller(std::move(teensy_), /*high_resolution=*/true);
+  controller.SendReport(report);
 }
 
-TEST_F(PCControllerTest, UpdateButtons) {
-  const uint8_t pin = 1;
-  const std::vector<int> digital = {pin};
-  const std::vector<AnalogButton> analog = {{.value = 0, .pin = pin}};
-  PCButtonPinMapping mapping = {
-      .z_y = analog,
-      .z_x = analog,
-      .slider_left = analog,
-      .slider_right = analog,
-      .hat_up = digital,
-      .hat_down = digital,
-      .hat_left = digital,
-      .hat_right = digital,
-  };
-  mapping.mod = digital;
-  mapping.button_id_to_pins = {{1, digital},  {2, digital},  {3, digital},
-                               {4, digital},  {5, digital},  {6, digital},
-                               {7, digital},  {8, digital},  {9, digital},
-                               {10, digital}, {11, digital}, {12, digital}};
-
-  EXPECT_CALL(*teensy_, DigitalReadLow(1))
-      .Times(20)
-      .WillRepeatedly(Return(true));
+TEST_F(PCControllerTest, SendReport) {
+  OutputReport report = {.buttons = 1 << 1 | 1 << 12,
+                         .dpad = 0b1001,
+                         .left_x = 1,
+                         .left_y = 2,
+                         .right_x = 3,
+                         .right_y = 4,
+                         .slider_left = 5,
+                         .slider_right = 6};
 
   {
     InSequence seq;
-    EXPECT_CALL(*teensy_, SetJoystickZ);
-    EXPECT_CALL(*teensy_, SetJoystickZRotate);
-    EXPECT_CALL(*teensy_, SetJoystickSliderLeft);
-    EXPECT_CALL(*teensy_, SetJoystickSliderRight);
-    EXPECT_CALL(*teensy_, SetJoystickButton(_, true)).Times(12);
-    EXPECT_CALL(*teensy_, SetJoystickHat);
+    EXPECT_CALL(*teensy_, SetJoystickX(1));
+    EXPECT_CALL(*teensy_, SetJoystickY(1021));
+    EXPECT_CALL(*teensy_, SetJoystickZ(4));
+    EXPECT_CALL(*teensy_, SetJoystickZRotate(3));
+    EXPECT_CALL(*teensy_, SetJoystickSliderLeft(5));
+    EXPECT_CALL(*teensy_, SetJoystickSliderRight(6));
+    EXPECT_CALL(*teensy_, SetJoystickButton(1, true));
+    EXPECT_CALL(*teensy_, SetJoystickButton(_, false)).Times(10);
+    EXPECT_CALL(*teensy_, SetJoystickButton(12, true));
+    EXPECT_CALL(*teensy_, SetJoystickHat(45));
+    EXPECT_CALL(*teensy_, JoystickSendNow);
   }
 
   PCController controller(std::move(teensy_));
-  controller.UpdateButtons(mapping);
+  controller.SendReport(report);
 }
 
 }  // namespace hs
@@ -0,0 +1,74 @@
+#include "profiler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include "configurator.h"
+#include "test/mock_teensy.h"
+
+namespace hs {
+namespace profiler {
+
+using ::testing::_;
+using ::testing::Each;
+using ::testing::Return;
+
+class ProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { Reset(); }
+};
+
+TEST_F(ProfilerTest, Record) {
+  Record(kTick, 0);
+  Record(kTick, 1);
+  Record(kTick, 1000);
+  Record(kTick, 1023);
+  Record(kTick, 1024);
+  Record(kTick, UINT32_MAX);
+
+  const Histogram& histogram = Get(kTick);
+  EXPECT_EQ(histogram.buckets[0], 1);
+  EXPECT_EQ(histogram.buckets[1], 1);
+  EXPECT_EQ(histogram.buckets[10], 2);
+  EXPECT_EQ(histogram.buckets[11], 1);
+  EXPECT_EQ(histogram.buckets[kNumBuckets - 1], 1);
+  EXPECT_EQ(histogram.max, UINT32_MAX);
+
+  EXPECT_THAT(Get(kSensor).buckets, Each(0));
+}
+
+TEST_F(ProfilerTest, Reset) {
+  Record(kSensor, 600);
+  Reset();
+
+  EXPECT_THAT(Get(kSensor).buckets, Each(0));
+  EXPECT_EQ(Get(kSensor).max, 0);
+}
+
+TEST_F(ProfilerTest, Timer) {
+  MockTeensy teensy;
+
+  EXPECT_CALL(teensy, CycleCount)
+      .WillOnce(Return(UINT32_MAX - 99))  // Wraps around.
+      .WillOnce(Return(900));
+
+  { Timer timer(teensy, kSend); }
+
+  EXPECT_EQ(Get(kSend).buckets[10], 1);
+  EXPECT_EQ(Get(kSend).max, 1000);
+}
+
+TEST_F(ProfilerTest, SendCycleHistograms) {
+  MockTeensy teensy;
+  Record(kButtons, 5);
+
+  EXPECT_CALL(teensy, SerialWrite(_, 4)).Times(kNumStages * (kNumBuckets + 1));
+
+  configurator::internal::SendCycleHistograms(teensy);
+  EXPECT_EQ(Get(kButtons).max, 0);
+}
+
+}  // namespace profiler
+}  // namespace hs
@@ -0,0 +1,154 @@
+#include "recorder.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "bench/replay.h"
+#include "controller.h"
+#include "pc_controller.h"
+#include "pins.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+namespace recorder {
+
+namespace {
+
+const unsigned long kTickMicros = 125;
+
+// Thumb top is X at 20Hz turbo, and thumb middle plays D-pad down for 17ms
+// then D-pad right + CIRCLE for 17ms. Taken from the sim tests.
+const std::vector<uint8_t> kProfiles = {
+    128,  // 10000000; PC
+    16,   // 0001 0000; Position = 1
+    29,   // Body length
+    178,  // Options follow, joystick threshold = 50
+    12,   3,   10, 2, 1, 16, 0, 17, 2, 18, 2, 0, 17,  // Macros
+    252,  17,  79, 128, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+OutputReport Report(uint32_t buttons) {
+  OutputReport report = {};
+  report.buttons = buttons;
+  return report;
+}
+
+}  // namespace
+
+class RecorderTest : public ::testing::Test {
+ protected:
+  void SetUp() override { Reset(); }
+};
+
+TEST_F(RecorderTest, Record_SkipsUnchanged) {
+  Record(0, 1, {512, 512}, Report(1));
+  Record(125, 1, {512, 512}, Report(1));
+  Record(250, 1, {512, 513}, Report(1));
+  Record(375, 1, {512, 513}, Report(2));
+  Record(500, 0, {512, 513}, Report(2));
+
+  ASSERT_EQ(Size(), 4);
+  EXPECT_EQ(Get(0).micros, 0);
+  EXPECT_EQ(Get(1).micros, 250);
+  EXPECT_EQ(Get(2).micros, 375);
+  EXPECT_EQ(Get(3).micros, 500);
+}
+
+TEST_F(RecorderTest, Record_Wraps) {
+  for (int i = 0; i < kCapacity + 10; i++) {
+    Record(i, i, {0, 0}, Report(0));
+  }
+
+  ASSERT_EQ(Size(), kCapacity);
+  EXPECT_EQ(Get(0).micros, 10);
+  EXPECT_EQ(Get(kCapacity - 1).micros, kCapacity + 9);
+}
+
+TEST_F(RecorderTest, Serialize) {
+  const Entry entry = {.micros = 0x01020304,
+                       .pins = 0x0506,
+                       .x = 1023,
+                       .y = 7,
+                       .report = {.buttons = 0x80000001,
+                                  .dpad = 0b1010,
+                                  .left_x = 1,
+                                  .left_y = 2,
+                                  .right_x = 3,
+                                  .right_y = 4,
+                                  .slider_left = 5,
+                                  .slider_right = 0xFFFF}};
+  uint8_t bytes[kEntrySize];
+  Serialize(entry, bytes);
+
+  EXPECT_THAT(bytes, ::testing::ElementsAre(1, 2, 3, 4, 5, 6, 3, 255, 0, 7,
+                                            128, 0, 0, 1, 10, 0, 1, 0, 2, 0,
+                                            3, 0, 4, 0, 5, 255, 255));
+  const Entry round_trip = Deserialize(bytes);
+  EXPECT_EQ(round_trip.micros, entry.micros);
+  EXPECT_EQ(round_trip.pins, entry.pins);
+  EXPECT_EQ(round_trip.x, entry.x);
+  EXPECT_EQ(round_trip.y, entry.y);
+  EXPECT_EQ(memcmp(&round_trip.report, &entry.report, sizeof(OutputReport)),
+            0);
+}
+
+TEST_F(RecorderTest, DumpAndReplay) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim, kProfiles);
+  sim->Tap(pins::kThumbTop, 10000, 100000);
+  sim->Tap(pins::kThumbMiddle, 200000, 1000);
+  sim->Tap(pins::kRingTop, 250000, 300);
+  PCController controller(std::move(teensy));
+  while (sim->now() < 300000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+
+  // Dump the recording over serial, as the configurator would.
+  sim->ClearSerialOut();
+  sim->QueueSerial({3});
+  controller.Loop();
+  const std::vector<uint8_t>& out = sim->serial_out();
+  ASSERT_FALSE(out.empty());
+  EXPECT_EQ(out[0], 0);  // OK.
+  std::vector<Entry> entries;
+  ASSERT_TRUE(bench::ParseRecording(
+      std::vector<uint8_t>(out.begin() + 1, out.end()), entries));
+  EXPECT_EQ(entries.size(), Size());
+  // Boot and the release of index top, the turbo press, 3 turbo edges and
+  // release, the macro press and release and its 2 step edges, and the ring
+  // top press and release.
+  EXPECT_EQ(entries.size(), 13);
+
+  // A second controller booted from the same EEPROM reproduces every report.
+  auto replay_teensy = std::make_unique<SimTeensy>();
+  Flash(*replay_teensy, kProfiles);
+  PCController replay_controller(std::move(replay_teensy));
+  EXPECT_THAT(bench::Replay(replay_controller, entries), ::testing::IsEmpty());
+
+  // Corrupting a recorded report shows up as a mismatch.
+  entries[3].report.buttons ^= 1;
+  PCController mismatch_controller([] {
+    auto teensy = std::make_unique<SimTeensy>();
+    Flash(*teensy, kProfiles);
+    return teensy;
+  }());
+  const std::vector<bench::Mismatch> mismatches =
+      bench::Replay(mismatch_controller, entries);
+  ASSERT_EQ(mismatches.size(), 1);
+  EXPECT_EQ(mismatches[0].index, 3);
+}
+
+TEST_F(RecorderTest, ParseRecording_Truncated) {
+  std::vector<Entry> entries;
+  EXPECT_FALSE(bench::ParseRecording({0, 0}, entries));
+  EXPECT_FALSE(bench::ParseRecording({0, 0, 0, 1, 0}, entries));
+  EXPECT_TRUE(bench::ParseRecording({0, 0, 0, 0}, entries));
+  EXPECT_TRUE(entries.empty());
+}
+
+}  // namespace recorder
+}  // namespace hs
@@ -0,0 +1,68 @@
+#include "response_curve.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace hs {
+
+TEST(ResponseCurveTest, Inactive) {
+  ResponseCurve curve;
+  EXPECT_FALSE(curve.IsActive());
+
+  curve.Configure(nullptr, 0, 100);
+  EXPECT_TRUE(curve.IsActive());
+}
+
+TEST(ResponseCurveTest, LinearWithoutPoints) {
+  ResponseCurve curve;
+  curve.Configure(nullptr, 0, 512);
+
+  EXPECT_EQ(curve.Apply(0), 0);
+  EXPECT_EQ(curve.Apply(100), 100);
+  EXPECT_EQ(curve.Apply(-100), -100);
+  EXPECT_EQ(curve.Apply(512), 512);
+}
+
+TEST(ResponseCurveTest, Interpolates) {
+  const CurvePoint points[] = {{.input = 50, .output = 20},
+                               {.input = 80, .output = 80}};
+  ResponseCurve curve;
+  curve.Configure(points, 2, 100);
+
+  EXPECT_EQ(curve.Apply(0), 0);
+  EXPECT_EQ(curve.Apply(25), 10);
+  EXPECT_EQ(curve.Apply(50), 20);
+  EXPECT_EQ(curve.Apply(65), 50);
+  EXPECT_EQ(curve.Apply(80), 80);
+  EXPECT_EQ(curve.Apply(90), 90);
+  EXPECT_EQ(curve.Apply(100), 100);
+  // Mirrored below neutral.
+  EXPECT_EQ(curve.Apply(-25), -10);
+  EXPECT_EQ(curve.Apply(-65), -50);
+}
+
+TEST(ResponseCurveTest, SkipsInvalidPoints) {
+  const CurvePoint points[] = {{.input = 50, .output = 20},
+                               {.input = 40, .output = 90},
+                               {.input = 60, .output = 101},
+                               {.input = 100, .output = 0}};
+  ResponseCurve curve;
+  curve.Configure(points, 4, 100);
+
+  EXPECT_EQ(curve.Apply(50), 20);
+  EXPECT_EQ(curve.Apply(75), 60);
+  EXPECT_EQ(curve.Apply(100), 100);
+}
+
+TEST(ResponseCurveTest, CoarserStepOver16BitAxes) {
+  const CurvePoint points[] = {{.input = 50, .output = 25}};
+  ResponseCurve curve;
+  curve.Configure(points, 1, 32768);
+
+  EXPECT_EQ(curve.Apply(16384), 8192);
+  EXPECT_EQ(curve.Apply(-32768), -32768);
+  // Within the same step as 16384.
+  EXPECT_EQ(curve.Apply(16400), 8192);
+}
+
+}  // namespace hs
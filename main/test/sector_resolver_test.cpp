@@ -0,0 +1,105 @@
+#include "sector_resolver.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace hs {
+
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Field;
+
+// Diagonal sectors 30 degrees wide, so cardinal sectors reach 30 degrees
+// either side of their axis. Full tilt is 100 units and directions press at
+// a radius of 50, and release below 40.
+const SectorConfig kConfig = {
+    .diagonal_width = 30, .angle_hysteresis = 5, .radius_hysteresis = 10};
+
+SectorResolver GetResolver(const SectorConfig& config = kConfig) {
+  SectorResolver resolver;
+  resolver.Configure(config, /*full_tilt=*/100, /*threshold=*/50);
+  return resolver;
+}
+
+auto DirectionEq(int x, int y) {
+  return AllOf(Field("x", &SectorResolver::Direction::x, x),
+               Field("y", &SectorResolver::Direction::y, y));
+}
+
+}  // namespace
+
+TEST(SectorResolverTest, Inactive) {
+  SectorResolver resolver;
+  EXPECT_FALSE(resolver.IsActive());
+
+  resolver.Configure({}, 100, 50);
+  EXPECT_TRUE(resolver.IsActive());
+}
+
+TEST(SectorResolverTest, Cardinals) {
+  SectorResolver resolver = GetResolver();
+
+  EXPECT_THAT(resolver.Update(60, 0), DirectionEq(1, 0));
+  EXPECT_THAT(resolver.Update(0, -60), DirectionEq(0, -1));
+  EXPECT_THAT(resolver.Update(-60, 0), DirectionEq(-1, 0));
+  EXPECT_THAT(resolver.Update(0, 60), DirectionEq(0, 1));
+}
+
+TEST(SectorResolverTest, Diagonals) {
+  SectorResolver resolver = GetResolver();
+
+  // Pressed by radius, with neither axis past the threshold on its own.
+  EXPECT_THAT(resolver.Update(36, 36), DirectionEq(1, 1));
+  EXPECT_THAT(resolver.Update(-36, 36), DirectionEq(-1, 1));
+  EXPECT_THAT(resolver.Update(-36, -36), DirectionEq(-1, -1));
+  EXPECT_THAT(resolver.Update(36, -36), DirectionEq(1, -1));
+}
+
+TEST(SectorResolverTest, DiagonalWidth) {
+  SectorResolver resolver = GetResolver();
+  // About 27 and 34 degrees.
+  EXPECT_THAT(resolver.Update(60, 30), DirectionEq(1, 0));
+  resolver = GetResolver();
+  EXPECT_THAT(resolver.Update(60, 40), DirectionEq(1, 1));
+
+  // No diagonals at all.
+  resolver = GetResolver({.diagonal_width = 0});
+  EXPECT_THAT(resolver.Update(40, 39), DirectionEq(1, 0));
+  EXPECT_THAT(resolver.Update(39, 40), DirectionEq(0, 1));
+}
+
+TEST(SectorResolverTest, AngleHysteresis) {
+  SectorResolver resolver = GetResolver();
+
+  EXPECT_THAT(resolver.Update(60, 30), DirectionEq(1, 0));
+  // About 32 degrees, within the widened cardinal.
+  EXPECT_THAT(resolver.Update(60, 37), DirectionEq(1, 0));
+  // About 37 degrees.
+  EXPECT_THAT(resolver.Update(60, 45), DirectionEq(1, 1));
+  // Back to about 32, then 27 degrees, within the widened diagonal.
+  EXPECT_THAT(resolver.Update(60, 37), DirectionEq(1, 1));
+  EXPECT_THAT(resolver.Update(60, 30), DirectionEq(1, 1));
+  // About 23 degrees.
+  EXPECT_THAT(resolver.Update(60, 25), DirectionEq(1, 0));
+}
+
+TEST(SectorResolverTest, RadiusHysteresis) {
+  SectorResolver resolver = GetResolver();
+
+  EXPECT_THAT(resolver.Update(49, 0), DirectionEq(0, 0));
+  EXPECT_THAT(resolver.Update(50, 0), DirectionEq(1, 0));
+  EXPECT_THAT(resolver.Update(40, 0), DirectionEq(1, 0));
+  EXPECT_THAT(resolver.Update(39, 0), DirectionEq(0, 0));
+  EXPECT_THAT(resolver.Update(45, 0), DirectionEq(0, 0));
+}
+
+TEST(SectorResolverTest, FullTiltOf16BitAxes) {
+  SectorResolver resolver;
+  resolver.Configure(kConfig, /*full_tilt=*/32768, /*threshold=*/50);
+
+  EXPECT_THAT(resolver.Update(32767, -32768), DirectionEq(1, -1));
+  EXPECT_THAT(resolver.Update(-32768, 0), DirectionEq(-1, 0));
+}
+
+}  // namespace hs
@@ -0,0 +1,63 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef SIM_NSPAD_H_
+#define SIM_NSPAD_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "nspad.h"
+#include "sim_teensy.h"
+
+namespace hs {
+
+// Host implementation of the Switch gamepad which captures every report it
+// is asked to send, stamped with the simulator's virtual clock.
+class SimNSPad : public NSPad {
+ public:
+  // Gamepad state at the time of a SendReport() call.
+  struct Report {
+    unsigned long micros;
+    uint8_t left_x;
+    uint8_t left_y;
+    uint8_t right_x;
+    uint8_t right_y;
+    int8_t dpad;
+    // Bitfield indexed by button ID.
+    uint16_t buttons;
+  };
+
+  explicit SimNSPad(const SimTeensy& teensy) : teensy_(teensy) {}
+
+  const std::vector<Report>& reports() const { return reports_; }
+  void ClearReports() { reports_.clear(); }
+
+  // Same values as the NSGamepad library.
+  int DPadCentered() const override { return 15; }
+  int DPadUp() const override { return 0; }
+  int DPadDown() const override { return 4; }
+  int DPadLeft() const override { return 6; }
+  int DPadRight() const override { return 2; }
+  int DPadUpLeft() const override { return 7; }
+  int DPadUpRight() const override { return 1; }
+  int DPadDownLeft() const override { return 5; }
+  int DPadDownRight() const override { return 3; }
+
+  void SendReport(const NSReport& report) const override {
+    reports_.push_back({.micros = teensy_.now(),
+                        .left_x = report.left_x,
+                        .left_y = report.left_y,
+                        .right_x = report.right_x,
+                        .right_y = report.right_y,
+                        .dpad = static_cast<int8_t>(report.dpad),
+                        .buttons = report.buttons});
+  }
+
+ private:
+  const SimTeensy& teensy_;
+  mutable std::vector<Report> reports_;
+};
+
+}  // namespace hs
+
+#endif  // SIM_NSPAD_H_
@@ -0,0 +1,413 @@
+// Copyright 2024 Hiram Silvey
+
+#ifndef SIM_TEENSY_H_
+#define SIM_TEENSY_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "edge_capture.h"
+#include "hall_joystick.h"
+#include "pc_hid.h"
+#include "pins.h"
+#include "teensy.h"
+
+namespace hs {
+
+// Deterministic host implementation of the Teensy HAL. Time only moves when
+// Advance() is called, button pins follow a scripted timeline, the hall
+// sensor replays a recorded trace and every joystick report is captured, so
+// whole sessions can be run against real profiles without hardware.
+class SimTeensy : public Teensy {
+ public:
+  // Teensy 4.0 emulated EEPROM size.
+  static constexpr int kEEPROMSize = 1080;
+  // Core clock, used to derive the cycle counter from the virtual clock.
+  static constexpr uint32_t kCyclesPerMicro = 600;
+
+  // Joystick state at the time of a JoystickSendNow() call.
+  struct JoystickReport {
+    unsigned long micros;
+    int x;
+    int y;
+    int z;
+    int z_rotate;
+    int slider_left;
+    int slider_right;
+    // Bitfield indexed by joystick button number.
+    uint32_t buttons;
+    int hat;
+  };
+
+  struct HallSample {
+    unsigned long micros;
+    float x;
+    float y;
+    float z;
+  };
+
+  // Starts with a blank EEPROM image. If a path is provided, the image is
+  // loaded from that file when it exists and every update is written back
+  // to it.
+  explicit SimTeensy(const std::string& eeprom_path = "")
+      : eeprom_(kEEPROMSize, 0xFF), eeprom_path_(eeprom_path) {
+    if (eeprom_path_.empty()) {
+      return;
+    }
+    std::ifstream in(eeprom_path_, std::ios::binary);
+    if (in) {
+      in.read(reinterpret_cast<char*>(eeprom_.data()), kEEPROMSize);
+    }
+    SaveEEPROM(eeprom_path_);
+  }
+
+  // Virtual clock.
+  unsigned long now() const { return now_; }
+
+  // Move the virtual clock forward, applying every scripted pin event and
+  // hall sample that falls due on the way.
+  void Advance(unsigned long micros) {
+    now_ += micros;
+    while (next_event_ < events_.size() &&
+           events_[next_event_].micros <= now_) {
+      const PinEvent& event = events_[next_event_++];
+      pin_edges_.Push(
+          {.micros = static_cast<uint32_t>(event.micros),
+           .cycles = static_cast<uint32_t>(event.micros * kCyclesPerMicro),
+           .pin = static_cast<uint8_t>(event.pin),
+           .pressed = event.pressed});
+      if (event.pressed) {
+        pins_ |= 1 << event.pin;
+      } else {
+        pins_ &= ~(1 << event.pin);
+      }
+    }
+    while (next_sample_ < hall_trace_.size() &&
+           hall_trace_[next_sample_].micros <= now_) {
+      sensor_ = hall_trace_[next_sample_++];
+    }
+  }
+
+  // Script a button press or release at an absolute time. Events due at or
+  // before the current time take effect on the next Advance().
+  void Press(int pin, unsigned long micros) { AddEvent({micros, pin, true}); }
+  void Release(int pin, unsigned long micros) {
+    AddEvent({micros, pin, false});
+  }
+
+  // Hold a button from `micros` for `duration` microseconds.
+  void Tap(int pin, unsigned long micros, unsigned long duration) {
+    Press(pin, micros);
+    Release(pin, micros + duration);
+  }
+
+  // Start a USB frame every `micros` microseconds, from time zero. Frames
+  // are off until set, so the controller runs free.
+  void SetFramePeriod(unsigned long micros) { frame_period_ = micros; }
+
+  // Make every hall sensor read take `micros` of virtual time, as the I2C
+  // transfer does on the device. Reads are instant until set.
+  void SetSensorReadMicros(unsigned long micros) {
+    sensor_read_micros_ = micros;
+  }
+
+  // Immediately set the state of every pin. Bit N is set while pin N is
+  // pressed.
+  void SetPins(uint32_t pins) { pins_ = pins; }
+
+  // Append a hall sensor sample. Samples must be added in time order; the
+  // latest one due is held until the next replaces it.
+  void AddHallSample(const HallSample& sample) {
+    hall_trace_.push_back(sample);
+    if (sample.micros <= now_ && next_sample_ == hall_trace_.size() - 1) {
+      sensor_ = hall_trace_[next_sample_++];
+    }
+  }
+
+  // Load a recorded hall sensor trace with one "micros x y z" sample per
+  // line. Blank lines and lines starting with '#' are skipped.
+  bool LoadHallTrace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+      return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      std::istringstream fields(line);
+      HallSample sample;
+      if (!(fields >> sample.micros >> sample.x >> sample.y >> sample.z)) {
+        return false;
+      }
+      AddHallSample(sample);
+    }
+    return true;
+  }
+
+  // Write the joystick calibration the same way the configurator does.
+  void WriteCalibration(const HallJoystick::Calibration& calibration) {
+    WriteInt(0, calibration.neutral_x);
+    WriteInt(4, calibration.neutral_y);
+    WriteInt(8, calibration.range);
+    EEPROMUpdate(12, calibration.angle_ticks >> 8);
+    EEPROMUpdate(13, calibration.angle_ticks);
+  }
+
+  // Write encoded profiles after the calibration, prefixed by their length and
+  // the format version as the configurator stores them.
+  void WriteProfiles(const std::vector<uint8_t>& encoded) {
+    const size_t size = encoded.size() + 1;
+    EEPROMUpdate(14, size >> 8);
+    EEPROMUpdate(15, size);
+    EEPROMUpdate(16, decoder::kFormatVersion);
+    for (size_t i = 0; i < encoded.size(); i++) {
+      EEPROMUpdate(17 + i, encoded[i]);
+    }
+  }
+
+  bool SaveEEPROM(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(eeprom_.data()), kEEPROMSize);
+    return static_cast<bool>(out);
+  }
+
+  // Queue bytes to be read from the serial port.
+  void QueueSerial(const std::vector<uint8_t>& bytes) {
+    serial_in_.insert(serial_in_.end(), bytes.begin(), bytes.end());
+  }
+
+  // Queue a command to be received from the GameCube console.
+  void QueueJoybus(const std::vector<uint8_t>& command) {
+    joybus_in_.push_back(command);
+  }
+
+  const std::vector<JoystickReport>& reports() const { return reports_; }
+  void ClearReports() { reports_.clear(); }
+  const std::vector<uint8_t>& serial_out() const { return serial_out_; }
+  void ClearSerialOut() { serial_out_.clear(); }
+  const std::vector<std::vector<uint8_t>>& joybus_out() const {
+    return joybus_out_;
+  }
+  int exit_status() const { return exit_status_; }
+  bool manual_send() const { return manual_send_; }
+
+  // Arduino
+  bool DigitalReadLow(uint8_t pin) const override {
+    return pins_ & (1 << pin);
+  }
+  // Edges are captured at the time they were scripted, as if by interrupt.
+  bool PopPinEdge(edge_capture::Edge& edge) const override {
+    return pin_edges_.Pop(edge);
+  }
+  void Exit(int status) const override { exit_status_ = status; }
+
+  // Arduino: Math
+  int Constrain(int amount, int low, int high) const override {
+    return std::clamp(amount, low, high);
+  }
+
+  // Arduino: Serial
+  void SerialWrite(uint8_t val) const override { serial_out_.push_back(val); }
+  void SerialWrite(uint8_t* vals, int size) const override {
+    serial_out_.insert(serial_out_.end(), vals, vals + size);
+  }
+  int SerialRead() const override {
+    if (serial_in_.empty()) {
+      return -1;
+    }
+    const uint8_t val = serial_in_.front();
+    serial_in_.pop_front();
+    return val;
+  }
+  int SerialAvailable() const override { return serial_in_.size(); }
+
+  // Arduino: Time
+  unsigned long Millis() const override { return now_ / 1000; }
+  unsigned long Micros() const override { return now_; }
+
+  // Cortex-M7
+  uint32_t CycleCount() const override { return now_ * kCyclesPerMicro; }
+
+  // USB
+  uint32_t UsbFrameIndex() const override {
+    return frame_period_ == 0 ? 0 : now_ / frame_period_;
+  }
+
+  // Arduino: Joystick
+  void JoystickUseManualSend() const override { manual_send_ = true; }
+  void SetJoystickX(int val) const override { joystick_.x = val; }
+  void SetJoystickY(int val) const override { joystick_.y = val; }
+  void SetJoystickZ(int val) const override { joystick_.z = val; }
+  void SetJoystickZRotate(int val) const override {
+    joystick_.z_rotate = val;
+  }
+  void SetJoystickSliderLeft(int val) const override {
+    joystick_.slider_left = val;
+  }
+  void SetJoystickSliderRight(int val) const override {
+    joystick_.slider_right = val;
+  }
+  void SetJoystickButton(uint8_t pin, bool active) const override {
+    if (active) {
+      joystick_.buttons |= 1 << pin;
+    } else {
+      joystick_.buttons &= ~(1 << pin);
+    }
+  }
+  void SetJoystickHat(int angle) const override { joystick_.hat = angle; }
+  void JoystickSendNow() const override {
+    joystick_.micros = now_;
+    reports_.push_back(joystick_);
+  }
+  // Only the high-resolution report is sent whole. It is captured with the
+  // same button numbering and hat angles as the stock joystick.
+  void JoystickSendReport(const uint8_t* report, int size) const override {
+    HiResReport hires = {};
+    memcpy(&hires, report, std::min<int>(size, sizeof(HiResReport)));
+    const int hat = hires.hat & 0xF;
+    reports_.push_back({.micros = now_,
+                        .x = hires.x,
+                        .y = hires.y,
+                        .z = hires.z,
+                        .z_rotate = hires.z_rotate,
+                        .slider_left = hires.slider_left,
+                        .slider_right = hires.slider_right,
+                        .buttons = static_cast<uint32_t>(hires.buttons) << 1,
+                        .hat = hat == kHiResHatCentered ? -1 : hat * 45});
+  }
+
+  // EEPROM
+  uint8_t EEPROMRead(int addr) const override {
+    if (addr < 0 || addr >= kEEPROMSize) {
+      return 0xFF;
+    }
+    return eeprom_[addr];
+  }
+  void EEPROMUpdate(int addr, uint8_t val) const override {
+    if (addr < 0 || addr >= kEEPROMSize || eeprom_[addr] == val) {
+      return;
+    }
+    eeprom_[addr] = val;
+    if (!eeprom_path_.empty()) {
+      std::fstream file(eeprom_path_,
+                        std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(addr);
+      file.put(val);
+    }
+  }
+
+  // Tlv493d
+  void UpdateHallData() override {
+    Advance(sensor_read_micros_);
+    latched_ = sensor_;
+  }
+  float GetHallX() override { return latched_.x; }
+  float GetHallY() override { return latched_.y; }
+  float GetHallZ() override { return latched_.z; }
+
+  // Joybus
+  int JoybusReceive(uint8_t* bytes, int max_size) const override {
+    if (joybus_in_.empty()) {
+      return 0;
+    }
+    const std::vector<uint8_t>& command = joybus_in_.front();
+    const int size = std::min<int>(command.size(), max_size);
+    std::copy(command.begin(), command.begin() + size, bytes);
+    joybus_in_.pop_front();
+    return size;
+  }
+  void JoybusSend(const uint8_t* bytes, int size) const override {
+    joybus_out_.emplace_back(bytes, bytes + size);
+  }
+
+ private:
+  struct PinEvent {
+    unsigned long micros;
+    int pin;
+    bool pressed;
+  };
+
+  void AddEvent(const PinEvent& event) {
+    // Keep pending events ordered by time, preserving insertion order for
+    // events scripted at the same time.
+    auto pos = std::upper_bound(
+        events_.begin() + next_event_, events_.end(), event,
+        [](const PinEvent& a, const PinEvent& b) {
+          return a.micros < b.micros;
+        });
+    events_.insert(pos, event);
+  }
+
+  void WriteInt(int addr, int val) {
+    EEPROMUpdate(addr, val >> 24);
+    EEPROMUpdate(addr + 1, val >> 16);
+    EEPROMUpdate(addr + 2, val >> 8);
+    EEPROMUpdate(addr + 3, val);
+  }
+
+  unsigned long now_ = 0;
+  unsigned long frame_period_ = 0;
+  unsigned long sensor_read_micros_ = 0;
+
+  uint32_t pins_ = 0;
+  std::vector<PinEvent> events_;
+  size_t next_event_ = 0;
+  mutable edge_capture::EdgeRing pin_edges_;
+
+  // A sensor at rest with a non-zero field, so coordinates are well defined
+  // before the first sample.
+  HallSample sensor_ = {0, 0, 0, 1};
+  HallSample latched_ = {0, 0, 0, 1};
+  std::vector<HallSample> hall_trace_;
+  size_t next_sample_ = 0;
+
+  mutable std::vector<uint8_t> eeprom_;
+  const std::string eeprom_path_;
+
+  mutable std::deque<uint8_t> serial_in_;
+  mutable std::vector<uint8_t> serial_out_;
+  mutable std::deque<std::vector<uint8_t>> joybus_in_;
+  mutable std::vector<std::vector<uint8_t>> joybus_out_;
+
+  mutable JoystickReport joystick_ = {};
+  mutable std::vector<JoystickReport> reports_;
+  mutable bool manual_send_ = false;
+  mutable int exit_status_ = 0;
+};
+
+// Calibration with the sensor at rest reading the middle of the range.
+inline const HallJoystick::Calibration kSimCalibration = {
+    .neutral_x = 0, .neutral_y = 0, .range = 1000, .angle_ticks = 0};
+
+// One profile at position 1 for both PC and Switch; body taken from the
+// decoder tests. Thumb middle is X, thumb bottom is CIRCLE, index top is
+// TRIANGLE and pinky bottom is R_STICK_UP.
+inline const std::vector<uint8_t> kSimProfiles = {
+    192,  // 11000000; PC + Switch
+    17,   // 0001 0001; Position = 1, Position = 1
+    17,   // Body length
+    50,   // Joystick threshold
+    0,    16, 131, 132, 1, 32, 146, 139, 136, 2, 65, 20, 147, 140, 3, 96};
+
+// Write the calibration and `profiles`, and hold index top at boot to select
+// position 1.
+inline void Flash(SimTeensy& teensy,
+                  const std::vector<uint8_t>& profiles = kSimProfiles) {
+  teensy.WriteCalibration(kSimCalibration);
+  teensy.WriteProfiles(profiles);
+  teensy.Tap(pins::kIndexTop, 0, 1000);
+  teensy.Advance(0);
+}
+
+}  // namespace hs
+
+#endif  // SIM_TEENSY_H_
@@ -0,0 +1,312 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "latency_tracer.h"
+#include "ns_controller.h"
+#include "pc_controller.h"
+#include "pins.h"
+#include "test/sim_nspad.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+
+namespace {
+
+const unsigned long kTickMicros = 125;
+
+}  // namespace
+
+TEST(SimTest, PCController_FollowsTimeline) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  sim->Tap(pins::kThumbMiddle, 10000, 10000);
+  sim->Tap(pins::kPinkyBottom, 15000, 10000);
+  PCController controller(std::move(teensy));
+
+  while (sim->now() < 30000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+
+  EXPECT_EQ(sim->exit_status(), 0);
+  EXPECT_TRUE(sim->manual_send());
+  // Only reports which changed are sent: boot, the release of index top, and
+  // the press and release of thumb middle and pinky bottom.
+  ASSERT_EQ(sim->reports().size(), 6);
+  for (const auto& report : sim->reports()) {
+    const bool x = report.micros >= 10000 && report.micros < 20000;
+    const bool r_stick_up = report.micros >= 15000 && report.micros < 25000;
+    const bool triangle = report.micros < 1000;
+    EXPECT_EQ(report.buttons, (x ? 1 << 2 : 0) | (triangle ? 1 << 4 : 0))
+        << "at " << report.micros;
+    EXPECT_EQ(report.z, r_stick_up ? 1023 : 512) << "at " << report.micros;
+    EXPECT_EQ(report.x, 512);
+    EXPECT_EQ(report.hat, -1);
+  }
+}
+
+TEST(SimTest, PCController_HighResolution) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  sim->Tap(pins::kThumbMiddle, 10000, 10000);
+  sim->Tap(pins::kPinkyBottom, 15000, 10000);
+  PCController controller(std::move(teensy), /*high_resolution=*/true);
+
+  while (sim->now() < 30000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+
+  ASSERT_EQ(sim->reports().size(), 6);
+  for (const auto& report : sim->reports()) {
+    const bool x = report.micros >= 10000 && report.micros < 20000;
+    const bool r_stick_up = report.micros >= 15000 && report.micros < 25000;
+    const bool triangle = report.micros < 1000;
+    EXPECT_EQ(report.buttons, (x ? 1 << 2 : 0) | (triangle ? 1 << 4 : 0))
+        << "at " << report.micros;
+    EXPECT_EQ(report.z, r_stick_up ? 65535 : 32768) << "at " << report.micros;
+    EXPECT_EQ(report.x, 32768);
+    EXPECT_EQ(report.y, 32767);
+    EXPECT_EQ(report.hat, -1);
+  }
+}
+
+TEST(SimTest, PCController_MillionTicks) {
+  const int kTicks = 1000000;
+  const unsigned long kPeriod = 10000;
+  const unsigned long kHold = 3000;
+
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  for (unsigned long t = kPeriod; t < kTicks * kTickMicros; t += kPeriod) {
+    sim->Tap(pins::kThumbBottom, t, kHold);
+  }
+  PCController controller(std::move(teensy));
+
+  int sent = 0;
+  bool circle = false;
+  for (int tick = 0; tick < kTicks; tick++) {
+    controller.Loop();
+    // The last report sent is what the host sees.
+    if (!sim->reports().empty()) {
+      circle = sim->reports().back().buttons & (1 << 3);
+      sent += sim->reports().size();
+      sim->ClearReports();
+    }
+    ASSERT_EQ(circle, sim->now() >= kPeriod && sim->now() % kPeriod < kHold)
+        << "at " << sim->now();
+    sim->Advance(kTickMicros);
+  }
+  // Every press and release, plus the keep-alive between them.
+  EXPECT_LT(sent, kTicks / 10);
+  EXPECT_EQ(controller.GetSendCounters().sent, sent);
+  EXPECT_EQ(controller.GetSendCounters().suppressed, kTicks - sent);
+
+  // Edges are read and sent within the same tick of virtual time.
+  const LatencyTracer::Stats stats =
+      controller.GetLatencyTracer().GetStats(pins::kThumbBottom);
+  EXPECT_GT(stats.count, 0);
+  EXPECT_EQ(stats.max, 0);
+}
+
+TEST(SimTest, PCController_ReplaysHallTrace) {
+  const std::string path = ::testing::TempDir() + "sim_test_hall_trace.txt";
+  {
+    std::ofstream trace(path);
+    trace << "# micros x y z\n"
+          << "0 0 0 1\n"
+          << "5000 0.0008 -0.0008 1\n"
+          << "10000 0 0 1\n";
+  }
+
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  ASSERT_TRUE(sim->LoadHallTrace(path));
+  Flash(*sim);
+  PCController controller(std::move(teensy));
+
+  while (sim->now() < 15000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+  std::remove(path.c_str());
+
+  // The sensor is read at most every 330us, which is every third tick, so
+  // allow stale reads for that long after each sample change.
+  for (const auto& report : sim->reports()) {
+    if (report.micros < 5000 || report.micros >= 10375) {
+      EXPECT_EQ(report.x, 512) << "at " << report.micros;
+      EXPECT_EQ(report.y, 511) << "at " << report.micros;
+    } else if (report.micros >= 5375 && report.micros < 10000) {
+      // Tilted right and down past the digital threshold.
+      EXPECT_EQ(report.x, 1023) << "at " << report.micros;
+      EXPECT_EQ(report.y, 1023) << "at " << report.micros;
+    }
+  }
+}
+
+TEST(SimTest, PCController_TurboAndMacro) {
+  // Thumb top is X at 20Hz turbo, and thumb middle plays D-pad down for 17ms
+  // then D-pad right + CIRCLE for 17ms.
+  const std::vector<uint8_t> profiles = {
+      128,  // 10000000; PC
+      16,   // 0001 0000; Position = 1
+      29,   // Body length
+      178,  // Options follow, joystick threshold = 50
+      12,   3,   10, 2, 1, 16, 0, 17, 2, 18, 2, 0, 17,  // Macros
+      252,  17,  79, 128, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  sim->WriteCalibration(kSimCalibration);
+  sim->WriteProfiles(profiles);
+  sim->Tap(pins::kIndexTop, 0, 1000);
+  sim->Advance(0);
+  sim->Tap(pins::kThumbTop, 10000, 100000);
+  sim->Tap(pins::kThumbMiddle, 200000, 1000);
+  PCController controller(std::move(teensy));
+
+  while (sim->now() < 300000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+
+  // Boot, 5 turbo edges, 3 macro edges, and a keep-alive in each of the two
+  // idle stretches.
+  ASSERT_EQ(sim->reports().size(), 11);
+  for (const auto& report : sim->reports()) {
+    const unsigned long t = report.micros;
+    const bool x =
+        t >= 10000 && t < 110000 && ((t - 10000) / 25000) % 2 == 0;
+    const bool down = t >= 200000 && t < 217000;
+    const bool right = t >= 217000 && t < 234000;
+    EXPECT_EQ(report.buttons, (x ? 1 << 2 : 0) | (right ? 1 << 3 : 0))
+        << "at " << t;
+    EXPECT_EQ(report.hat, down ? 180 : right ? 90 : -1) << "at " << t;
+  }
+}
+
+TEST(SimTest, PCController_AlignsToFrames) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  sim->SetFramePeriod(1000);
+  sim->Tap(pins::kThumbMiddle, 20123, 5000);
+  PCController controller(std::move(teensy));
+
+  // Tick every 10us, like a free-running loop with nothing to send.
+  uint32_t built_before = 0;
+  while (sim->now() < 30000) {
+    if (sim->now() == 15000) {
+      const SendCounters counters = controller.GetSendCounters();
+      built_before = counters.sent + counters.suppressed;
+    }
+    controller.Loop();
+    sim->Advance(10);
+  }
+
+  // Once locked on, the press is sent just before the next poll rather than
+  // when first seen, and only one report is built per frame.
+  const SimTeensy::JoystickReport* press = nullptr;
+  for (const auto& report : sim->reports()) {
+    if (report.buttons & 1 << 2) {
+      press = &report;
+      break;
+    }
+  }
+  ASSERT_NE(press, nullptr);
+  EXPECT_GE(press->micros, 21000 - kSofMarginMicros);
+  EXPECT_LT(press->micros, 21000);
+  const SendCounters counters = controller.GetSendCounters();
+  EXPECT_EQ(counters.sent + counters.suppressed - built_before, 15);
+}
+
+TEST(SimTest, PCController_SlowSensorStaysBeforeFrame) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  Flash(*sim);
+  // High-speed microframes, with a sensor read that takes longer than one.
+  sim->SetFramePeriod(125);
+  sim->SetSensorReadMicros(300);
+  for (unsigned long t = 20000; t < 40000; t += 2000) {
+    sim->Tap(pins::kThumbMiddle, t + t / 1000 * 7, 1000);
+  }
+  PCController controller(std::move(teensy));
+
+  while (sim->now() < 45000) {
+    controller.Loop();
+    sim->Advance(10);
+  }
+
+  // Once locked on, every report goes out before the frame starts, within
+  // the margin give or take a tick, as the sensor is read between reports.
+  int presses = 0;
+  for (const auto& report : sim->reports()) {
+    if (report.micros < 20000) {
+      continue;
+    }
+    const unsigned long until_sof = 125 - report.micros % 125;
+    EXPECT_LE(until_sof, kSofMarginMicros + 10) << "at " << report.micros;
+    presses += (report.buttons & 1 << 2) != 0;
+  }
+  EXPECT_GE(presses, 10);
+}
+
+TEST(SimTest, NSController_FollowsTimeline) {
+  auto teensy = std::make_unique<SimTeensy>();
+  SimTeensy* sim = teensy.get();
+  auto nspad = std::make_unique<SimNSPad>(*sim);
+  SimNSPad* pad = nspad.get();
+  Flash(*sim);
+  sim->Tap(pins::kThumbMiddle, 10000, 10000);
+  NSController controller(std::move(teensy), std::move(nspad));
+
+  while (sim->now() < 30000) {
+    controller.Loop();
+    sim->Advance(kTickMicros);
+  }
+
+  EXPECT_EQ(sim->exit_status(), 0);
+  // Boot, the release of index top, and the press and release of thumb
+  // middle.
+  ASSERT_EQ(pad->reports().size(), 4);
+  for (const auto& report : pad->reports()) {
+    const bool x = report.micros >= 10000 && report.micros < 20000;
+    const bool triangle = report.micros < 1000;
+    EXPECT_EQ(report.buttons, (x ? 1 << 1 : 0) | (triangle ? 1 << 3 : 0))
+        << "at " << report.micros;
+    EXPECT_EQ(report.dpad, pad->DPadCentered());
+    EXPECT_EQ(report.left_x, 128);
+  }
+}
+
+TEST(SimTest, EEPROM_FileBacked) {
+  const std::string path = ::testing::TempDir() + "sim_test_eeprom.bin";
+  std::remove(path.c_str());
+  {
+    SimTeensy teensy(path);
+    EXPECT_EQ(teensy.EEPROMRead(0), 0xFF);
+    teensy.WriteCalibration(kSimCalibration);
+    teensy.WriteProfiles(kSimProfiles);
+  }
+
+  std::ifstream image(path, std::ios::binary | std::ios::ate);
+  EXPECT_EQ(image.tellg(), SimTeensy::kEEPROMSize);
+
+  SimTeensy teensy(path);
+  EXPECT_EQ(teensy.EEPROMRead(11), 0xE8);  // Range = 1000
+  EXPECT_EQ(teensy.EEPROMRead(15), kSimProfiles.size() + 1);
+  EXPECT_EQ(teensy.EEPROMRead(16), decoder::kFormatVersion);
+  EXPECT_EQ(teensy.EEPROMRead(17), 192);
+  std::remove(path.c_str());
+}
+
+}  // namespace hs
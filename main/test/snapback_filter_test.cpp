@@ -0,0 +1,214 @@
+#include "snapback_filter.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "hall_joystick.h"
+#include "test/sim_teensy.h"
+
+namespace hs {
+
+namespace {
+
+// Crossing neutral at 10% of full tilt per millisecond or faster holds
+// overshoots of up to 40% for up to 10ms. Full tilt is 100 units.
+const SnapbackConfig kConfig = {
+    .velocity = 10, .max_overshoot = 40, .window = 10};
+
+SnapbackFilter GetFilter() {
+  SnapbackFilter filter;
+  filter.Configure(kConfig, 100);
+  return filter;
+}
+
+}  // namespace
+
+TEST(SnapbackFilterTest, Inactive) {
+  SnapbackFilter filter;
+  EXPECT_FALSE(filter.IsActive());
+
+  filter.Configure({}, 100);
+  EXPECT_FALSE(filter.IsActive());
+
+  filter.Configure(kConfig, 100);
+  EXPECT_TRUE(filter.IsActive());
+}
+
+TEST(SnapbackFilterTest, HoldsFastCrossing) {
+  SnapbackFilter filter = GetFilter();
+  filter.Update(100, 0);
+  filter.Update(50, 1000);
+
+  // 70 units in 1ms.
+  EXPECT_EQ(filter.Update(-20, 2000), 0);
+  EXPECT_EQ(filter.Update(-30, 3000), 0);
+  EXPECT_EQ(filter.Update(-10, 4000), 0);
+  // Back at neutral, the overshoot is over.
+  EXPECT_EQ(filter.Update(0, 5000), 0);
+  EXPECT_EQ(filter.Update(-5, 15000), -5);
+}
+
+TEST(SnapbackFilterTest, PassesSlowCrossing) {
+  SnapbackFilter filter = GetFilter();
+  filter.Update(5, 0);
+
+  // 9 units in 1ms.
+  EXPECT_EQ(filter.Update(-4, 1000), -4);
+  EXPECT_EQ(filter.Update(-20, 2000), -20);
+}
+
+TEST(SnapbackFilterTest, PassesDirectionChange) {
+  SnapbackFilter filter = GetFilter();
+  filter.Update(100, 0);
+
+  EXPECT_EQ(filter.Update(-30, 1000), 0);
+  // Further than an overshoot goes.
+  EXPECT_EQ(filter.Update(-41, 1300), -41);
+  EXPECT_EQ(filter.Update(-30, 1600), -30);
+  // Straight past the overshoot range.
+  EXPECT_EQ(filter.Update(100, 2000), 100);
+}
+
+TEST(SnapbackFilterTest, ReleasesAfterWindow) {
+  SnapbackFilter filter = GetFilter();
+  filter.Update(100, 0);
+
+  EXPECT_EQ(filter.Update(-20, 1000), 0);
+  EXPECT_EQ(filter.Update(-20, 10999), 0);
+  EXPECT_EQ(filter.Update(-20, 11000), -20);
+}
+
+TEST(SnapbackFilterTest, ReleasesOnReturn) {
+  SnapbackFilter filter = GetFilter();
+  filter.Update(100, 0);
+
+  EXPECT_EQ(filter.Update(-20, 1000), 0);
+  // Slowly back past neutral, so not a snapback of its own.
+  EXPECT_EQ(filter.Update(5, 4000), 5);
+}
+
+TEST(SnapbackFilterTest, ClockWraparound) {
+  SnapbackFilter filter = GetFilter();
+  const uint32_t release = UINT32_MAX - 500;
+  filter.Update(100, release - 1000);
+
+  EXPECT_EQ(filter.Update(-20, release), 0);
+  EXPECT_EQ(filter.Update(-20, release + 9000), 0);
+  EXPECT_EQ(filter.Update(-20, release + 10000), -20);
+}
+
+// Replays hall sensor release traces through an unfiltered joystick and one
+// with the filter, with a range of 1000 sensor units either side of neutral.
+class SnapbackTraceTest : public ::testing::Test {
+ protected:
+  struct Output {
+    int raw;
+    int filtered;
+  };
+
+  SnapbackTraceTest()
+      : raw_(kSimCalibration, /*min=*/0, /*max=*/1023, /*threshold=*/0),
+        filtered_(kSimCalibration, /*min=*/0, /*max=*/1023, /*threshold=*/0) {
+    filtered_.ConfigureSnapback(kConfig);
+  }
+
+  // Write `x(t)` in sensor units every 100us for `duration` microseconds as
+  // a trace, then replay it. Returns the X output at each sensor read.
+  std::vector<Output> Replay(const std::function<double(double)>& x,
+                             int duration) {
+    const std::string path =
+        ::testing::TempDir() + "snapback_filter_test_trace.txt";
+    {
+      std::ofstream trace(path);
+      trace << "# micros x y z\n";
+      for (int micros = 0; micros <= duration; micros += 100) {
+        trace << micros << " " << x(micros) << " 0 1000000\n";
+      }
+    }
+    EXPECT_TRUE(teensy_.LoadHallTrace(path));
+    std::remove(path.c_str());
+
+    std::vector<Output> outputs;
+    while (teensy_.now() < static_cast<unsigned long>(duration)) {
+      teensy_.Advance(330);
+      outputs.push_back({raw_.GetCoordinates(teensy_).x,
+                         filtered_.GetCoordinates(teensy_).x});
+    }
+    return outputs;
+  }
+
+  SimTeensy teensy_;
+  HallJoystick raw_;
+  HallJoystick filtered_;
+};
+
+TEST_F(SnapbackTraceTest, Release) {
+  // Held at full tilt right for 5ms, then let go. The spring rings at about
+  // 80Hz and is damped to a quarter of the swing each half cycle.
+  const double omega = 2 * M_PI / 12000;
+  const double zeta = 0.4;
+  const std::vector<Output> outputs = Replay(
+      [&](double t) {
+        if (t < 5000) {
+          return 1000.0;
+        }
+        t -= 5000;
+        return 1000 * exp(-zeta * omega * t) *
+               cos(omega * sqrt(1 - zeta * zeta) * t);
+      },
+      40000);
+
+  int raw_min = 512;
+  int filtered_min = 512;
+  for (const Output& output : outputs) {
+    raw_min = std::min(raw_min, output.raw);
+    filtered_min = std::min(filtered_min, output.filtered);
+  }
+  // Unfiltered, the stick overshoots by a quarter of full tilt.
+  EXPECT_LT(raw_min, 512 - 100);
+  // Filtered, the overshoot is held at neutral. Only the later ripple, too
+  // slow to be a release, gets through.
+  EXPECT_GE(filtered_min, 512 - 10);
+  EXPECT_EQ(outputs.back().filtered, 512);
+}
+
+TEST_F(SnapbackTraceTest, DirectionChange) {
+  // Flicked from full right to full left over 6ms.
+  const std::vector<Output> outputs = Replay(
+      [](double t) {
+        if (t < 5000) {
+          return 1000.0;
+        }
+        return std::max(-1000.0, 1000 - (t - 5000) / 3);
+      },
+      20000);
+
+  // Output only differs while inside the overshoot range.
+  for (size_t i = 0; i < outputs.size(); i++) {
+    if (abs(outputs[i].raw - 512) > 204) {
+      EXPECT_EQ(outputs[i].filtered, outputs[i].raw) << "at sample " << i;
+    }
+  }
+  EXPECT_EQ(outputs.back().filtered, 0);
+}
+
+TEST_F(SnapbackTraceTest, SlowCrossing) {
+  // From 30% right to 30% left over 200ms.
+  const std::vector<Output> outputs = Replay(
+      [](double t) { return 300 - t * 600 / 200000; }, 200000);
+
+  for (size_t i = 0; i < outputs.size(); i++) {
+    EXPECT_EQ(outputs[i].filtered, outputs[i].raw) << "at sample " << i;
+  }
+}
+
+}  // namespace hs
@@ -0,0 +1,190 @@
+#include "sof_scheduler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace hs {
+
+namespace {
+
+// Feed SOFs every `period` microseconds from `start`, returning the time of
+// the last one.
+uint32_t Feed(SofScheduler& scheduler, uint32_t start, uint32_t period,
+              int frames) {
+  for (int i = 0; i < frames; i++) {
+    scheduler.OnSof(start + i * period);
+  }
+  return start + (frames - 1) * period;
+}
+
+}  // namespace
+
+TEST(SofSchedulerTest, Unlocked_AlwaysDue) {
+  SofScheduler scheduler(50);
+  EXPECT_TRUE(scheduler.IsDue(0));
+  EXPECT_TRUE(scheduler.IsDue(0));
+
+  Feed(scheduler, 0, 1000, kSofLockFrames);
+  EXPECT_FALSE(scheduler.IsLocked());
+  EXPECT_TRUE(scheduler.IsDue(kSofLockFrames * 1000 - 500));
+}
+
+TEST(SofSchedulerTest, LocksOntoFullSpeedFrames) {
+  SofScheduler scheduler(50);
+  const uint32_t last = Feed(scheduler, 123, 1000, kSofLockFrames + 2);
+
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(last), last + 1000);
+  EXPECT_EQ(scheduler.NextSof(last + 999), last + 1000);
+  // Frames keep being predicted without new SOFs.
+  EXPECT_EQ(scheduler.NextSof(last + 2500), last + 3000);
+}
+
+TEST(SofSchedulerTest, DueOncePerFrameWithinMargin) {
+  SofScheduler scheduler(50);
+  const uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  EXPECT_FALSE(scheduler.IsDue(last + 1));
+  EXPECT_FALSE(scheduler.IsDue(last + 949));
+  EXPECT_TRUE(scheduler.IsDue(last + 950));
+  EXPECT_FALSE(scheduler.IsDue(last + 960));
+  EXPECT_FALSE(scheduler.IsDue(last + 999));
+
+  // The SOF arriving doesn't make the same frame due again.
+  scheduler.OnSof(last + 1000);
+  EXPECT_FALSE(scheduler.IsDue(last + 1001));
+  EXPECT_TRUE(scheduler.IsDue(last + 1960));
+}
+
+TEST(SofSchedulerTest, LateTickStillBuilds) {
+  SofScheduler scheduler(50);
+  const uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  // The loop was busy through the window, so the next frame's report is
+  // built as soon as its window opens.
+  EXPECT_FALSE(scheduler.IsDue(last + 1200));
+  EXPECT_TRUE(scheduler.IsDue(last + 1990));
+}
+
+TEST(SofSchedulerTest, BusyTickSpanningSofKeepsPhase) {
+  SofScheduler scheduler(50);
+  uint32_t sof = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  for (int i = 0; i < 20; i++) {
+    // A 300us sensor read between reports spans the SOF, which is only
+    // noticed once the read ends.
+    sof += 1000;
+    scheduler.OnSof(sof - 100, sof + 200);
+    ASSERT_TRUE(scheduler.IsLocked());
+    ASSERT_EQ(scheduler.NextSof(sof + 200), sof + 1000);
+    ASSERT_FALSE(scheduler.IsDue(sof + 949));
+    ASSERT_TRUE(scheduler.IsDue(sof + 950));
+  }
+}
+
+TEST(SofSchedulerTest, BusyTicksSpanningMicroframes) {
+  SofScheduler scheduler(50);
+  uint32_t sof = Feed(scheduler, 0, 125, kSofLockFrames + 2);
+
+  // A 300us read spans two SOFs, and the later one is seen.
+  scheduler.OnSof(sof + 100, sof + 400);
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(sof + 400), sof + 500);
+}
+
+TEST(SofSchedulerTest, UnlockedIgnoresLateSofs) {
+  SofScheduler scheduler(50);
+  uint32_t t = 0;
+  for (int i = 0; i < 4 * kSofLockFrames; i++) {
+    // Every third SOF is only noticed after a busy tick.
+    if (i % 3 == 2) {
+      scheduler.OnSof(t - 30, t + 90);
+    } else {
+      scheduler.OnSof(t);
+    }
+    t += 125;
+  }
+
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(t - 125), t);
+}
+
+TEST(SofSchedulerTest, LateSofOutsidePrediction) {
+  SofScheduler scheduler(50);
+  const uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  // The SOF can't have come before 1020us, so the phase moves there and the
+  // period is averaged toward the longer interval.
+  scheduler.OnSof(last + 1020, last + 1300);
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_NEAR(scheduler.NextSof(last + 1300), last + 2020, 3);
+}
+
+TEST(SofSchedulerTest, HighSpeedMicroframes) {
+  SofScheduler scheduler(50);
+  // SOFs noticed up to 3us late.
+  uint32_t t = 0;
+  for (int i = 0; i < 64; i++) {
+    scheduler.OnSof(i * 125 + i % 4);
+    t = i * 125 + i % 4;
+  }
+
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_NEAR(scheduler.NextSof(t), 64 * 125, 4);
+  EXPECT_FALSE(scheduler.IsDue(64 * 125 - 80));
+  EXPECT_TRUE(scheduler.IsDue(64 * 125 - 40));
+}
+
+TEST(SofSchedulerTest, MissedFrames) {
+  SofScheduler scheduler(50);
+  uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  // Two frames go by unseen.
+  last += 3000;
+  scheduler.OnSof(last);
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(last), last + 1000);
+}
+
+TEST(SofSchedulerTest, MarginTooLongForPeriod) {
+  SofScheduler scheduler(200);
+  const uint32_t last = Feed(scheduler, 0, 125, kSofLockFrames + 2);
+
+  EXPECT_TRUE(scheduler.IsDue(last + 1));
+  EXPECT_TRUE(scheduler.IsDue(last + 2));
+}
+
+TEST(SofSchedulerTest, PeriodChangeRelocks) {
+  SofScheduler scheduler(50);
+  uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  last = Feed(scheduler, last + 125, 125, 2);
+  EXPECT_FALSE(scheduler.IsLocked());
+  last = Feed(scheduler, last + 125, 125, kSofLockFrames);
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(last), last + 125);
+}
+
+TEST(SofSchedulerTest, Suspended) {
+  SofScheduler scheduler(50);
+  const uint32_t last = Feed(scheduler, 0, 1000, kSofLockFrames + 2);
+
+  // With no SOFs for a long time, every tick is due.
+  EXPECT_TRUE(scheduler.IsDue(last + 100000));
+  EXPECT_TRUE(scheduler.IsDue(last + 100001));
+
+  scheduler.OnSof(last + 200000);
+  EXPECT_FALSE(scheduler.IsLocked());
+}
+
+TEST(SofSchedulerTest, ClockWraparound) {
+  SofScheduler scheduler(50);
+  const uint32_t last =
+      Feed(scheduler, UINT32_MAX - 5500, 1000, kSofLockFrames + 2);
+
+  EXPECT_TRUE(scheduler.IsLocked());
+  EXPECT_EQ(scheduler.NextSof(last), last + 1000);
+  EXPECT_TRUE(scheduler.IsDue(last + 960));
+}
+
+}  // namespace hs
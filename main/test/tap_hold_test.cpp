@@ -0,0 +1,130 @@
+#include "tap_hold.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "pins.h"
+
+namespace hs {
+
+namespace {
+
+const uint32_t kTerm = 200000;
+const uint16_t kTapHoldPin = 1 << pins::kThumbTop;
+const uint16_t kOtherPin = 1 << pins::kIndexTop;
+const uint32_t kHold = 1u << pins::kThumbTop;
+const uint32_t kTap = 1u << TapInput(pins::kThumbTop);
+
+}  // namespace
+
+TEST(TapHoldTest, Inactive) {
+  TapHold tap_hold;
+
+  EXPECT_FALSE(tap_hold.IsActive());
+  EXPECT_EQ(tap_hold.Update(0xFFFF, 0), 0);
+}
+
+TEST(TapHoldTest, Tap) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  EXPECT_TRUE(tap_hold.IsActive());
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000 + kTerm - 1), 0);
+  EXPECT_EQ(tap_hold.Update(0, 1000 + kTerm - 1), kTap);
+  // The tap is output long enough for the host to see it, then cleared.
+  EXPECT_EQ(tap_hold.Update(0, 1000 + kTerm - 1 + kTapMicros - 1), kTap);
+  EXPECT_EQ(tap_hold.Update(0, 1000 + kTerm - 1 + kTapMicros), 0);
+}
+
+TEST(TapHoldTest, Hold) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000 + kTerm), kHold);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000 + 2 * kTerm), kHold);
+  EXPECT_EQ(tap_hold.Update(0, 1000 + 2 * kTerm), 0);
+}
+
+TEST(TapHoldTest, PermissiveHold) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin | kOtherPin, 2000), 0);
+  // Tapping another button while pending resolves the pin as a hold before
+  // the term elapses.
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 3000), kHold);
+}
+
+TEST(TapHoldTest, LayerPin_HoldsBackOtherPins) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm, kTapHoldPin);
+
+  tap_hold.Update(kTapHoldPin, 1000);
+  tap_hold.Update(kTapHoldPin | kOtherPin, 2000);
+  EXPECT_EQ(tap_hold.Filter(kTapHoldPin | kOtherPin), kTapHoldPin);
+
+  // Released within the term, the other pin is replayed once the hold
+  // resolves, until a tap would expire.
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 3000), kHold);
+  EXPECT_EQ(tap_hold.Filter(kTapHoldPin), kTapHoldPin | kOtherPin);
+  tap_hold.Update(kTapHoldPin, 3000 + kTapMicros - 1);
+  EXPECT_EQ(tap_hold.Filter(kTapHoldPin), kTapHoldPin | kOtherPin);
+  tap_hold.Update(kTapHoldPin, 3000 + kTapMicros);
+  EXPECT_EQ(tap_hold.Filter(kTapHoldPin), kTapHoldPin);
+}
+
+TEST(TapHoldTest, LayerPin_ReleasesHeldPinsOnTap) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm, kTapHoldPin);
+
+  tap_hold.Update(kTapHoldPin, 1000);
+  tap_hold.Update(kTapHoldPin | kOtherPin, 2000);
+  EXPECT_EQ(tap_hold.Update(kOtherPin, 3000), kTap);
+  EXPECT_EQ(tap_hold.Filter(kOtherPin), kOtherPin);
+}
+
+TEST(TapHoldTest, PlainPin_DoesntHoldBack) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  tap_hold.Update(kTapHoldPin, 1000);
+  tap_hold.Update(kTapHoldPin | kOtherPin, 2000);
+  EXPECT_EQ(tap_hold.Filter(kTapHoldPin | kOtherPin),
+            kTapHoldPin | kOtherPin);
+}
+
+TEST(TapHoldTest, RollingPressIsTap) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin | kOtherPin, 2000), 0);
+  // Releasing the pin before the other button is a tap.
+  EXPECT_EQ(tap_hold.Update(kOtherPin, 3000), kTap);
+}
+
+TEST(TapHoldTest, ClockWraparound) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+
+  const uint32_t press = UINT32_MAX - 1000;
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, press), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, press + kTerm - 1), 0);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, press + kTerm), kHold);
+}
+
+TEST(TapHoldTest, Configure_IgnoresHeldPins) {
+  TapHold tap_hold;
+  tap_hold.Configure(kTapHoldPin, kTerm);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000), 0);
+
+  // Reconfiguring while the pin is pending drops it until pressed again.
+  tap_hold.Configure(kTapHoldPin, kTerm);
+  EXPECT_EQ(tap_hold.Update(kTapHoldPin, 1000 + kTerm), 0);
+  EXPECT_EQ(tap_hold.Update(0, 1000 + kTerm), 0);
+}
+
+}  // namespace hs
@@ -12,6 +12,7 @@
 namespace hs {
 
 using ::testing::AllOf;
+using ::testing::ElementsAreArray;
 using ::testing::Field;
 using ::testing::Matcher;
 
@@ -29,11 +30,45 @@ hs_profile_Profile_Layer_Action AnalogLayerAction(
       .action_type = {.analog = {.id = id, .value = val}}};
 }
 
+hs_profile_Profile_Layer_Action TurboLayerAction(
+    hs_profile_Profile_Layer_DigitalAction action, int rate) {
+  return hs_profile_Profile_Layer_Action{
+      .which_action_type = hs_profile_Profile_Layer_Action_turbo_tag,
+      .action_type = {.turbo = {.action = action, .rate = rate}}};
+}
+
+hs_profile_Profile_Layer_Action MacroLayerAction(int macro) {
+  return hs_profile_Profile_Layer_Action{
+      .which_action_type = hs_profile_Profile_Layer_Action_macro_tag,
+      .action_type = {.macro = macro}};
+}
+
+hs_profile_Profile_Layer_Action TapHoldLayerAction(
+    hs_profile_Profile_Layer_DigitalAction tap,
+    hs_profile_Profile_Layer_DigitalAction hold) {
+  return hs_profile_Profile_Layer_Action{
+      .which_action_type = hs_profile_Profile_Layer_Action_tap_hold_tag,
+      .action_type = {.tap_hold = {.tap = tap, .hold = hold}}};
+}
+
 MATCHER_P(ActionTypeEq, expected, "action_type") {
   if (expected.which_action_type ==
       hs_profile_Profile_Layer_Action_digital_tag) {
     return arg.action_type.digital == expected.action_type.digital;
   }
+  if (expected.which_action_type ==
+      hs_profile_Profile_Layer_Action_turbo_tag) {
+    return arg.action_type.turbo.action == expected.action_type.turbo.action &&
+           arg.action_type.turbo.rate == expected.action_type.turbo.rate;
+  }
+  if (expected.which_action_type == hs_profile_Profile_Layer_Action_macro_tag) {
+    return arg.action_type.macro == expected.action_type.macro;
+  }
+  if (expected.which_action_type ==
+      hs_profile_Profile_Layer_Action_tap_hold_tag) {
+    return arg.action_type.tap_hold.tap == expected.action_type.tap_hold.tap &&
+           arg.action_type.tap_hold.hold == expected.action_type.tap_hold.hold;
+  }
   return arg.action_type.analog.id == expected.action_type.analog.id &&
          arg.action_type.analog.value == expected.action_type.analog.value;
 }
@@ -45,8 +80,7 @@ auto ActionEq(const hs_profile_Profile_Layer_Action& expected) {
                ActionTypeEq(expected));
 }
 
-std::vector<Matcher<AnalogButton>> AnalogEq(
-    const std::vector<AnalogButton>& expected) {
+std::vector<Matcher<AnalogButton>> AnalogEq(const AnalogButtons& expected) {
   std::vector<Matcher<AnalogButton>> matchers;
   for (const auto& button : expected) {
     matchers.push_back(AllOf(Field("value", &AnalogButton::value, button.value),
@@ -55,6 +89,39 @@ std::vector<Matcher<AnalogButton>> AnalogEq(
   return matchers;
 }
 
+auto MappingEq(const ButtonPinMapping& expected) {
+  return AllOf(
+      Field("buttons", &ButtonPinMapping::buttons,
+            ElementsAreArray(expected.buttons)),
+      Field("dpad_up", &ButtonPinMapping::dpad_up, expected.dpad_up),
+      Field("dpad_down", &ButtonPinMapping::dpad_down, expected.dpad_down),
+      Field("dpad_left", &ButtonPinMapping::dpad_left, expected.dpad_left),
+      Field("dpad_right", &ButtonPinMapping::dpad_right, expected.dpad_right),
+      Field("mod", &ButtonPinMapping::mod, expected.mod),
+      Field("tap_hold", &ButtonPinMapping::tap_hold, expected.tap_hold),
+      Field("timed", &ButtonPinMapping::timed,
+            AllOf(Field("turbo", &TimedActions::turbo, expected.timed.turbo),
+                  Field("macro", &TimedActions::macro, expected.timed.macro),
+                  Field("turbo_half_period_micros",
+                        &TimedActions::turbo_half_period_micros,
+                        ElementsAreArray(
+                            expected.timed.turbo_half_period_micros)),
+                  Field("macro_index", &TimedActions::macro_index,
+                        ElementsAreArray(expected.timed.macro_index)))),
+      Field("left_x", &ButtonPinMapping::left_x,
+            ElementsAreArray(AnalogEq(expected.left_x))),
+      Field("left_y", &ButtonPinMapping::left_y,
+            ElementsAreArray(AnalogEq(expected.left_y))),
+      Field("z_y", &ButtonPinMapping::z_y,
+            ElementsAreArray(AnalogEq(expected.z_y))),
+      Field("z_x", &ButtonPinMapping::z_x,
+            ElementsAreArray(AnalogEq(expected.z_x))),
+      Field("slider_left", &ButtonPinMapping::slider_left,
+            ElementsAreArray(AnalogEq(expected.slider_left))),
+      Field("slider_right", &ButtonPinMapping::slider_right,
+            ElementsAreArray(AnalogEq(expected.slider_right))));
+}
+
 }  // namespace hs
 
 #endif  // TEST_UTIL_H_
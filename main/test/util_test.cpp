@@ -7,7 +7,9 @@
 
 namespace hs {
 
+using ::testing::ElementsAre;
 using ::testing::InSequence;
+using ::testing::IsEmpty;
 using ::testing::Return;
 
 TEST(UtilTest, GetShortFromEEPROM) {
@@ -36,4 +38,20 @@ TEST(UtilTest, GetIntFromEEPROM) {
   EXPECT_EQ(util::GetIntFromEEPROM(teensy, 0), 16909060);
 }
 
+TEST(UtilTest, FixedVector) {
+  util::FixedVector<int, 3> values;
+  EXPECT_THAT(values, IsEmpty());
+
+  values.push_back(1);
+  values.push_back(2);
+  EXPECT_THAT(values, ElementsAre(1, 2));
+  EXPECT_EQ(values[1], 2);
+}
+
+TEST(UtilTest, FixedVector_DropsPastCapacity) {
+  util::FixedVector<int, 3> values = {1, 2, 3};
+  values.push_back(4);
+  EXPECT_THAT(values, ElementsAre(1, 2, 3));
+}
+
 }  // namespace hs
@@ -3,6 +3,9 @@
 #ifndef UTIL_H_
 #define UTIL_H_
 
+#include <stddef.h>
+
+#include <initializer_list>
 #include <memory>
 
 #include "teensy.h"
@@ -10,6 +13,39 @@
 namespace hs {
 namespace util {
 
+// Vector with a fixed capacity and inline storage, for collections that
+// are rebuilt while the controller is running and so must stay off the heap.
+// Elements pushed past the capacity are dropped.
+template <typename T, size_t N>
+class FixedVector {
+ public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  FixedVector() : size_(0) {}
+  FixedVector(std::initializer_list<T> values) : size_(0) {
+    for (const T& value : values) {
+      push_back(value);
+    }
+  }
+
+  void push_back(const T& value) {
+    if (size_ < N) {
+      values_[size_++] = value;
+    }
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T& operator[](size_t i) const { return values_[i]; }
+  const_iterator begin() const { return values_; }
+  const_iterator end() const { return values_ + size_; }
+
+ private:
+  T values_[N];
+  size_t size_;
+};
+
 // Read 2 bytes from EEPROM and return it as a single short.
 int16_t GetShortFromEEPROM(const Teensy& teensy, int address);
 